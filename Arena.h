@@ -0,0 +1,85 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Bump allocator for AST and symbol storage
+//              Objects are carved out of large blocks and never freed
+//              individually - the whole arena is released at once.
+// ============================================================================
+
+#pragma once
+#include "common.h"
+#include <memory>
+#include <new>
+#include <vector>
+#include <string_view>
+#include <type_traits>
+
+class Arena {
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* cursor = nullptr;
+    char* limit = nullptr;
+    size_t allocations = 0;     // allocate() calls (--stats)
+    size_t reserved = 0;        // Bytes in all blocks
+
+    void grow(size_t minBytes) {
+        size_t size = minBytes > BLOCK_SIZE ? minBytes : BLOCK_SIZE;
+        blocks.emplace_back(new char[size]);
+        reserved += size;
+        cursor = blocks.back().get();
+        limit = cursor + size;
+    }
+
+public:
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    Arena(Arena&&) = default;
+    Arena& operator=(Arena&&) = default;
+
+    void* allocate(size_t bytes, size_t align = alignof(std::max_align_t)) {
+        allocations++;
+        uintptr_t p = (reinterpret_cast<uintptr_t>(cursor) + align - 1) & ~(uintptr_t)(align - 1);
+        if (cursor == nullptr || p + bytes > reinterpret_cast<uintptr_t>(limit)) {
+            grow(bytes + align);
+            p = (reinterpret_cast<uintptr_t>(cursor) + align - 1) & ~(uintptr_t)(align - 1);
+        }
+        cursor = reinterpret_cast<char*>(p + bytes);
+        return reinterpret_cast<void*>(p);
+    }
+
+    // Only trivially destructible types - the arena never runs destructors
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        static_assert(std::is_trivially_destructible<T>::value,
+                      "Arena objects must be trivially destructible");
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    template <typename T>
+    T* allocateArray(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value,
+                      "Arena objects must be trivially destructible");
+        return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    std::string_view copyString(std::string_view text) {
+        char* dst = static_cast<char*>(allocate(text.size() + 1, 1));
+        memcpy(dst, text.data(), text.size());
+        dst[text.size()] = '\0';
+        return std::string_view(dst, text.size());
+    }
+
+    void clear() {
+        blocks.clear();
+        cursor = limit = nullptr;
+        allocations = 0;
+        reserved = 0;
+    }
+
+    size_t getAllocations() const { return allocations; }
+    size_t getBlockCount() const { return blocks.size(); }
+    size_t getReservedBytes() const { return reserved; }
+};
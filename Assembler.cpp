@@ -0,0 +1,101 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Assembler library implementation
+// ============================================================================
+
+#include "Assembler.h"
+#include "parser.h"
+#include "MacroExpander.h"
+#include <stdexcept>
+
+bool Assembler::parse(char* buffer, size_t size) {
+    ScopedTimer timer(parseNanos);
+    ast.reserve(size / 16);
+    sourceBytes = size >= 2 ? size - 2 : 0;     // Without the trailing NULs
+
+    ParseContext ctx(ast, symbols, diagnostics);
+    MacroTable macros;      // Recorded tokens are not needed after the parse
+    ctx.includes = &includes;
+    ctx.macros = &macros;
+    void* scanner = scanner_create(ctx, buffer, size);
+    if (scanner == nullptr) {
+        ctx.report(DiagnosticKind::SCAN, "Could not create scanner");
+        return false;
+    }
+
+    MacroExpander tokens(ctx, scanner);
+    const int result = yyparse(tokens, ctx);
+    scanner_destroy(scanner);
+    macroInvocations = macros.getInvocations();
+    macroReplays = macros.getReused();
+    return result == 0 && !hasErrors();
+}
+
+bool Assembler::encode() {
+    try {
+        const bool ok = encoder.encode(ast, diagnostics, encodeThreads);
+        image = ok ? &encoder.getImage() : nullptr;
+        return ok;
+    } catch (const std::exception& e) {
+        diagnostics.push_back({DiagnosticKind::ASSEMBLY, 0, 0, e.what()});
+        image = nullptr;
+        return false;
+    }
+}
+
+void Assembler::setSourceName(const std::string& path) {
+    ast.setMainFile(path);
+    includes.setMainFile(path);
+}
+
+bool Assembler::assembleFile(const std::string& path) {
+    setSourceName(path);
+    try {
+        source = std::make_unique<SourceFile>(path);
+    } catch (const std::exception& e) {
+        diagnostics.push_back({DiagnosticKind::ASSEMBLY, 0, 0, e.what()});
+        return false;
+    }
+    return assemble(source->data(), source->bufferSize());
+}
+
+AssemblyStats Assembler::getStats() const {
+    AssemblyStats stats;
+    const EncodeStats& encode = encoder.getStats();
+    stats.phase(StatsPhase::PARSE) = parseNanos;
+    stats.phase(StatsPhase::LAYOUT) = encode.layoutNanos;
+    stats.phase(StatsPhase::ENCODE) = encode.totalNanos - encode.layoutNanos;
+
+    stats.sourceBytes = sourceBytes;
+    stats.includedFiles = includes.getParsedFiles();
+    stats.cachedFiles = includes.getCachedFiles();
+    stats.statements = ast.size();
+    for (const Statement& stmt : ast) {
+        stats.instructions += stmt.type == StatementType::INSTRUCTION;
+        stats.directives += stmt.type == StatementType::DIRECTIVE;
+        stats.labels += stmt.type == StatementType::LABEL;
+    }
+    stats.macroInvocations = macroInvocations;
+    stats.macroReplays = macroReplays;
+
+    stats.symbols = symbols.size();
+    stats.nameLookups = symbols.getLookups();
+    stats.symbolLookups = encode.symbolLookups;
+
+    for (const Arena* arena : {&ast.arena, &symbols.getStorage()}) {
+        stats.arenaAllocations += arena->getAllocations();
+        stats.arenaBlocks += arena->getBlockCount();
+        stats.arenaBytes += arena->getReservedBytes();
+    }
+
+    stats.layoutPasses = encode.layoutPasses;
+    stats.encodePasses = encode.encodePasses;
+    stats.fixups = encode.fixups;
+    stats.expandedInstructions = encoder.countExpandedInstructions(ast);
+    stats.relaxedBranches = encoder.getRelaxedBranchCount();
+    stats.shortLoads = encoder.getShortLoadCount();
+    stats.peepholeRewrites = encoder.getPeepholeRewrites().size();
+    stats.words = image != nullptr ? image->size() : 0;
+    return stats;
+}
@@ -0,0 +1,127 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Library entry point - assembles one program from a buffer
+//              Each Assembler owns all state of its assembly (symbols, AST,
+//              image, diagnostics), so separate Assemblers can run on
+//              separate threads at the same time.
+// ============================================================================
+
+#pragma once
+#include "common.h"
+#include "ast.h"
+#include "StringInterner.h"
+#include "SymbolTable.h"
+#include "InstructionEncoder.h"
+#include "MemoryImage.h"
+#include "ParseContext.h"
+#include "SourceFile.h"
+#include "IncludeResolver.h"
+#include "ObjectFile.h"
+#include "LineTable.h"
+#include "Stats.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Settings shared by single, batch and watch runs
+struct AssemblerOptions {
+    IncludeOptions includes;
+    unsigned encodeThreads = 1;     // Workers for encoding large programs, 0 = one per hardware thread
+    bool branchRelaxation = true;   // Rewrite out-of-range branches into long form
+    bool loadShrinking = true;      // Encode mv rX, =value in one word when the value fits
+    bool peephole = false;          // Drop instructions without effect (-O)
+    size_t maxErrors = DEFAULT_MAX_ERRORS;  // Assembly errors reported before encoding stops, 0 = all
+    bool objectOutput = false;      // Encode a relocatable object for sblink (-c)
+    bool listing = false;           // Record statement addresses for formatListing() (-l)
+    bool lineTable = false;         // Record them for getLineTable() (-g, --run)
+};
+
+class Assembler {
+private:
+    std::unique_ptr<SourceFile> source;     // Set by assembleFile() only
+    StringInterner symbols;
+    ProgramAST ast;
+    IncludeResolver includes;
+    SymbolTable symbolTable;
+    Encoder encoder;
+    std::vector<Diagnostic> diagnostics;
+    const MemoryImage* image = nullptr;
+    unsigned encodeThreads = 1;
+
+    // Collected for getStats()
+    uint64_t parseNanos = 0;
+    size_t sourceBytes = 0;
+    size_t macroInvocations = 0;
+    size_t macroReplays = 0;
+
+public:
+    Assembler() : symbolTable(symbols), encoder(symbolTable) {}
+
+    Assembler(const Assembler&) = delete;
+    Assembler& operator=(const Assembler&) = delete;
+
+    // Parse a source buffer. The last two bytes of the buffer must be NUL,
+    // and the buffer must stay alive as long as the Assembler (the AST
+    // points into it). Returns false on scan or syntax errors.
+    bool parse(char* buffer, size_t size);
+
+    // Set before parse()
+    void setOptions(const AssemblerOptions& options) {
+        includes.setOptions(options.includes);
+        encodeThreads = options.encodeThreads;
+        encoder.setBranchRelaxation(options.branchRelaxation);
+        encoder.setLoadShrinking(options.loadShrinking);
+        encoder.setPeephole(options.peephole);
+        encoder.setMaxErrors(options.maxErrors);
+        encoder.setObjectOutput(options.objectOutput);
+        encoder.setStatementAddresses(options.listing || options.lineTable);
+    }
+
+    // Name of the main source for .include resolution and messages, set by
+    // assembleFile() - call it before parse() when assembling a buffer
+    void setSourceName(const std::string& path);
+
+    // Branches rewritten into long form by encode()
+    size_t getRelaxedBranchCount() const { return encoder.getRelaxedBranchCount(); }
+
+    // =value loads encoded in one word by encode()
+    size_t getShortLoadCount() const { return encoder.getShortLoadCount(); }
+
+    // Peephole rewrites applied by encode(), indices into getAST()
+    const std::vector<PeepholeRewrite>& getPeepholeRewrites() const { return encoder.getPeepholeRewrites(); }
+
+    // Encode the parsed program into the memory image. Returns false on
+    // assembly errors (undefined symbols, out of range values, ...), which
+    // are all added to the diagnostics in source order.
+    bool encode();
+
+    bool assemble(char* buffer, size_t size) { return parse(buffer, size) && encode(); }
+
+    // Load 'path' and assemble it - the Assembler keeps the file alive
+    bool assembleFile(const std::string& path);
+
+    // Valid after encode() succeeded
+    const MemoryImage& getImage() const { return *image; }
+
+    // Object of the encoded program - only with objectOutput set
+    ObjectModule getObject() const { return buildObject(ast, symbolTable, encoder); }
+
+    // Source location of every encoded word - only with lineTable set
+    LineTable getLineTable() const { return buildLineTable(ast, encoder.getStatementAddresses()); }
+
+    // Address of every statement of getAST() - only with listing or lineTable set
+    const std::vector<uint32_t>& getStatementAddresses() const { return encoder.getStatementAddresses(); }
+
+    const ProgramAST& getAST() const { return ast; }
+    const SymbolTable& getSymbolTable() const { return symbolTable; }
+    const StringInterner& getSymbols() const { return symbols; }
+    const IncludeResolver& getIncludes() const { return includes; }
+
+    // Timings and counters of parse() and encode() - the output phase is
+    // left to the caller
+    AssemblyStats getStats() const;
+
+    const std::vector<Diagnostic>& getDiagnostics() const { return diagnostics; }
+    bool hasErrors() const { return !diagnostics.empty(); }
+};
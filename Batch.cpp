@@ -0,0 +1,103 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Batch assembly implementation
+// ============================================================================
+
+#include "Batch.h"
+#include "Assembler.h"
+#include "Parallel.h"
+#include <fstream>
+#include <stdexcept>
+
+std::string batchOutputName(const std::string& input, const std::string& directory) {
+    const size_t slash = input.find_last_of("/\\");
+    const size_t nameStart = (slash == std::string::npos) ? 0 : slash + 1;
+    size_t dot = input.find_last_of('.');
+    if (dot == std::string::npos || dot <= nameStart) {
+        dot = input.size();
+    }
+
+    if (directory.empty()) {
+        return input.substr(0, dot);
+    }
+    std::string name = directory;
+    if (name.back() != '/' && name.back() != '\\') {
+        name += '/';
+    }
+    return name + input.substr(nameStart, dot - nameStart);
+}
+
+std::vector<std::string> readBatchManifest(const std::string& path) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        throw std::runtime_error("Could not open manifest '" + path + "'");
+    }
+
+    std::vector<std::string> inputs;
+    std::string line;
+    while (std::getline(in, line)) {
+        // Trim surrounding whitespace (including CR from CRLF files)
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') {
+            continue;
+        }
+        const size_t last = line.find_last_not_of(" \t\r");
+        inputs.push_back(line.substr(first, last - first + 1));
+    }
+    return inputs;
+}
+
+static void runJob(const BatchJob& job, const OutputOptions& baseOptions,
+                   const AssemblerOptions& assemblerOptions, int requestedDepth, BatchResult& result)
+{
+    Assembler assembler;
+    assembler.setOptions(assemblerOptions);
+    if (!assembler.assembleFile(job.input)) {
+        result.diagnostics = assembler.getDiagnostics();
+        return;
+    }
+
+    try {
+        const MemoryImage& image = assembler.getImage();
+        result.output = job.output;
+        result.words = image.size();
+        if (assemblerOptions.objectOutput) {
+            writeObjectFile(assembler.getObject(), result.output);
+            result.success = true;
+            return;
+        }
+        OutputOptions options = baseOptions;
+        options.depth = resolveMemoryDepth(image.size(), requestedDepth);
+
+        if (assemblerOptions.lineTable) {
+            std::string path = job.output;
+            writeLineTableFile(assembler.getLineTable(), path);
+        }
+        writeOutputFile(image, result.output, options);
+        result.success = true;
+    } catch (const std::exception& e) {
+        result.diagnostics.push_back({DiagnosticKind::ASSEMBLY, 0, 0, e.what()});
+    }
+}
+
+std::vector<BatchResult> runBatch(const std::vector<BatchJob>& jobs,
+                                  const OutputOptions& options,
+                                  const AssemblerOptions& assemblerOptions,
+                                  int requestedDepth,
+                                  unsigned threads)
+{
+    AssemblerOptions jobOptions = assemblerOptions;
+    jobOptions.encodeThreads = 1;
+
+    std::vector<BatchResult> results(jobs.size());
+    parallelFor(jobs.size(), threads, [&](size_t i) {
+        try {
+            runJob(jobs[i], options, jobOptions, requestedDepth, results[i]);
+        } catch (const std::exception& e) {
+            results[i].success = false;
+            results[i].diagnostics.push_back({DiagnosticKind::ASSEMBLY, 0, 0, e.what()});
+        }
+    });
+    return results;
+}
@@ -0,0 +1,44 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Batch assembly of many independent inputs on a worker pool
+//              Each input gets its own Assembler, so workers share nothing
+//              but the read-only options.
+// ============================================================================
+
+#pragma once
+#include "common.h"
+#include "ParseContext.h"
+#include "OutputWriter.h"
+#include "Assembler.h"
+#include <string>
+#include <vector>
+
+struct BatchJob {
+    std::string input;
+    std::string output;     // Without extension - the writer appends it
+};
+
+struct BatchResult {
+    bool success = false;
+    uint32_t words = 0;     // Image size
+    std::string output;     // Final output path (with extension)
+    std::vector<Diagnostic> diagnostics;
+};
+
+// Output name for 'input': the input path without its extension, placed
+// in 'directory' if one is given
+std::string batchOutputName(const std::string& input, const std::string& directory);
+
+// Read a manifest - one input path per line, blank lines and lines starting
+// with '#' are skipped. Throws if the manifest cannot be read.
+std::vector<std::string> readBatchManifest(const std::string& path);
+
+// Assemble and write every job. 'requestedDepth' is resolved per image
+// as for a single input. threads = 0 uses one worker per hardware thread;
+// each job encodes on its own worker.
+std::vector<BatchResult> runBatch(const std::vector<BatchJob>& jobs,
+                                  const OutputOptions& options,
+                                  const AssemblerOptions& assemblerOptions,
+                                  int requestedDepth,
+                                  unsigned threads);
@@ -0,0 +1,174 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: sbasm_bench - pipeline benchmarks on synthetic workloads
+//              Every workload is benchmarked at every size per stage: parse
+//              (scanner, macro expansion and yyparse), encode (Encoder with
+//              one thread), output (MIF formatting into memory) and
+//              assemble (all three). Names are stage/workload/words.
+//
+//                  sbasm_bench [benchmark options]
+//                  sbasm_bench --write-workloads <dir>
+//
+//              The second form writes the generated programs as .s files,
+//              for profiling the sbasm binary on them.
+// ============================================================================
+
+#include "Assembler.h"
+#include "OutputWriter.h"
+#include "Workload.h"
+#include <benchmark/benchmark.h>
+#include <fstream>
+#include <vector>
+
+namespace {
+
+// Generated source with the two trailing NULs the scanner needs
+std::vector<char> sourceBuffer(WorkloadKind kind, size_t words) {
+    const std::string text = generateWorkload(kind, words);
+    std::vector<char> buffer(text.begin(), text.end());
+    buffer.push_back('\0');
+    buffer.push_back('\0');
+    return buffer;
+}
+
+OutputOptions outputOptions(const MemoryImage& image) {
+    OutputOptions options;
+    options.depth = resolveMemoryDepth(image.size(), DEPTH_DEFAULT);
+    return options;
+}
+
+// Parse and encode once outside the timed loop. False (and the benchmark
+// skipped) if the workload does not assemble.
+bool prepare(benchmark::State& state, Assembler& assembler, std::vector<char>& source, bool encode) {
+    if (!assembler.parse(source.data(), source.size()) || (encode && !assembler.encode())) {
+        const std::vector<Diagnostic>& diagnostics = assembler.getDiagnostics();
+        state.SkipWithError(diagnostics.empty() ? "assembly failed" : diagnostics[0].message.c_str());
+        return false;
+    }
+    return true;
+}
+
+void parseStage(benchmark::State& state, WorkloadKind kind, size_t words) {
+    std::vector<char> source = sourceBuffer(kind, words);
+    for (auto _ : state) {
+        Assembler assembler;
+        if (!prepare(state, assembler, source, false)) {
+            break;
+        }
+        benchmark::DoNotOptimize(assembler.getAST().size());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(source.size() - 2));
+}
+
+void encodeStage(benchmark::State& state, WorkloadKind kind, size_t words) {
+    std::vector<char> source = sourceBuffer(kind, words);
+    Assembler assembler;
+    if (!prepare(state, assembler, source, false)) {
+        return;
+    }
+    for (auto _ : state) {
+        if (!assembler.encode()) {
+            state.SkipWithError("encode failed");
+            break;
+        }
+        benchmark::DoNotOptimize(assembler.getImage().size());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                            static_cast<int64_t>(assembler.getAST().size()));
+}
+
+void outputStage(benchmark::State& state, WorkloadKind kind, size_t words) {
+    std::vector<char> source = sourceBuffer(kind, words);
+    Assembler assembler;
+    if (!prepare(state, assembler, source, true)) {
+        return;
+    }
+    const MemoryImage& image = assembler.getImage();
+    const OutputOptions options = outputOptions(image);
+    OutputBuffer out;
+    for (auto _ : state) {
+        out.clear();
+        formatOutput(image, options, out);
+        benchmark::DoNotOptimize(out.bytes());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(out.size()));
+}
+
+void assembleStage(benchmark::State& state, WorkloadKind kind, size_t words) {
+    std::vector<char> source = sourceBuffer(kind, words);
+    OutputBuffer out;
+    for (auto _ : state) {
+        Assembler assembler;
+        if (!prepare(state, assembler, source, true)) {
+            break;
+        }
+        out.clear();
+        formatOutput(assembler.getImage(), outputOptions(assembler.getImage()), out);
+        benchmark::DoNotOptimize(out.bytes());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(source.size() - 2));
+}
+
+using StageFn = void (*)(benchmark::State&, WorkloadKind, size_t);
+
+struct BenchStageDef {
+    std::string_view name;
+    StageFn run;
+};
+
+constexpr BenchStageDef BENCH_STAGES[] = {
+    {"parse",    parseStage},
+    {"encode",   encodeStage},
+    {"output",   outputStage},
+    {"assemble", assembleStage},
+};
+
+// Write every workload at every size to 'directory'
+int writeWorkloads(const std::string& directory) {
+    for (const WorkloadDef& workload : WORKLOADS) {
+        for (size_t words : WORKLOAD_SIZES) {
+            const std::string path = directory + "/" + std::string(workload.name) + "-" +
+                                     std::to_string(words) + ".s";
+            std::ofstream out(path);
+            out << "// " << workload.description << ", about " << words << " words\n"
+                << generateWorkload(workload.kind, words);
+            if (!out) {
+                std::cerr << "Error: Could not write " << path << std::endl;
+                return 1;
+            }
+            std::cout << path << "\n";
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc == 3 && std::string_view(argv[1]) == "--write-workloads") {
+        return writeWorkloads(argv[2]);
+    }
+
+    for (const BenchStageDef& stage : BENCH_STAGES) {
+        for (const WorkloadDef& workload : WORKLOADS) {
+            for (size_t words : WORKLOAD_SIZES) {
+                const std::string name = std::string(stage.name) + "/" + std::string(workload.name) + "/" +
+                                         std::to_string(words);
+                const StageFn run = stage.run;
+                const WorkloadKind kind = workload.kind;
+                benchmark::RegisterBenchmark(name.c_str(), [run, kind, words](benchmark::State& state) {
+                    run(state, kind, words);
+                })->Unit(benchmark::kMicrosecond);
+            }
+        }
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,121 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Binary serialization helpers (parse cache, objects, line tables)
+//              Values are stored in native byte order. Strings are a 32-bit
+//              length followed by the bytes. Varints take 7 bits per byte,
+//              low bits first, for tables of mostly small numbers.
+// ============================================================================
+
+#pragma once
+#include "common.h"
+#include <string>
+#include <string_view>
+
+class ByteWriter {
+private:
+    std::string& out;
+
+public:
+    explicit ByteWriter(std::string& buffer) : out(buffer) {}
+
+    template <typename T>
+    void put(T value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void putString(std::string_view text) {
+        put(static_cast<uint32_t>(text.size()));
+        out.append(text.data(), text.size());
+    }
+
+    void putBytes(const void* data, size_t size) {
+        out.append(static_cast<const char*>(data), size);
+    }
+
+    void putVarint(uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    // Small negative and positive values both in few bytes
+    void putSignedVarint(int64_t value) {
+        putVarint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+    }
+};
+
+// Bounds-checked reader over a mapped file. Strings are returned as views
+// into the mapping.
+class ByteReader {
+private:
+    const char* cursor;
+    const char* limit;
+
+public:
+    ByteReader(const char* data, size_t size) : cursor(data), limit(data + size) {}
+
+    template <typename T>
+    bool get(T& value) {
+        if (static_cast<size_t>(limit - cursor) < sizeof(T)) {
+            return false;
+        }
+        memcpy(&value, cursor, sizeof(T));
+        cursor += sizeof(T);
+        return true;
+    }
+
+    bool getString(std::string_view& text) {
+        uint32_t length = 0;
+        if (!get(length) || static_cast<size_t>(limit - cursor) < length) {
+            return false;
+        }
+        text = std::string_view(cursor, length);
+        cursor += length;
+        return true;
+    }
+
+    bool getBytes(void* data, size_t size) {
+        if (static_cast<size_t>(limit - cursor) < size) {
+            return false;
+        }
+        memcpy(data, cursor, size);
+        cursor += size;
+        return true;
+    }
+
+    bool getVarint(uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && cursor < limit; shift += 7) {
+            const uint8_t byte = static_cast<uint8_t>(*cursor++);
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool getSignedVarint(int64_t& value) {
+        uint64_t encoded = 0;
+        if (!getVarint(encoded)) {
+            return false;
+        }
+        value = static_cast<int64_t>(encoded >> 1) ^ -static_cast<int64_t>(encoded & 1);
+        return true;
+    }
+
+    size_t remaining() const { return static_cast<size_t>(limit - cursor); }
+
+    bool skip(size_t bytes) {
+        if (static_cast<size_t>(limit - cursor) < bytes) {
+            return false;
+        }
+        cursor += bytes;
+        return true;
+    }
+
+    bool done() const { return cursor == limit; }
+};
@@ -0,0 +1,103 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Diagnostics shared by the scanner, parser and encoder
+//              The encoder records an ErrorCode with the offending operand on
+//              the hot path and builds the message text only when a
+//              statement fails. It then carries on with the next statement,
+//              so one run reports every error, up to --max-errors.
+// ============================================================================
+
+#pragma once
+#include "common.h"
+#include <iterator>
+#include <string>
+#include <string_view>
+
+// Phase that reported a diagnostic
+enum class DiagnosticKind : uint8_t {
+    SCAN,       // Unexpected character, unknown directive
+    PARSE,      // Syntax error
+    ASSEMBLY,   // Encoding, symbol or layout error
+    LINK        // sblink: placement or symbol resolution error
+};
+
+enum class ErrorCode : uint8_t {
+    NONE,                   // Scan and parse errors
+    INVALID_REGISTER,
+    IMMEDIATE_RANGE,
+    SHORT_IMMEDIATE_RANGE,  // #value that needs =value
+    INVALID_NUMBER,
+    UNDEFINED_SYMBOL,
+    UNDEFINED_LABEL,
+    BRANCH_RANGE,
+    SHIFT_RANGE,
+    WORD_RANGE,
+    NEGATIVE_SPACE,
+    ORG_BACKWARDS,
+    ORG_RANGE,
+    DUPLICATE_LABEL,
+    DUPLICATE_DEFINE,
+    UNKNOWN_INSTRUCTION,
+    UNSUPPORTED_FORMAT,
+    ADDRESS_SPACE,          // Program exceeds the 16-bit address space
+    DUPLICATE_GLOBAL,       // .global symbol exported by two objects
+    SECTION_OVERLAP,        // Absolute objects claim the same words
+    TOO_MANY_ERRORS         // Errors past --max-errors were not reported
+};
+
+// Stable names for tools reading diagnostics - indexed by ErrorCode
+struct ErrorCodeDef {
+    ErrorCode code;
+    std::string_view name;
+};
+
+inline constexpr ErrorCodeDef ERROR_CODES[] = {
+    {ErrorCode::NONE,                  "none"},
+    {ErrorCode::INVALID_REGISTER,      "invalid-register"},
+    {ErrorCode::IMMEDIATE_RANGE,       "immediate-range"},
+    {ErrorCode::SHORT_IMMEDIATE_RANGE, "short-immediate-range"},
+    {ErrorCode::INVALID_NUMBER,        "invalid-number"},
+    {ErrorCode::UNDEFINED_SYMBOL,      "undefined-symbol"},
+    {ErrorCode::UNDEFINED_LABEL,       "undefined-label"},
+    {ErrorCode::BRANCH_RANGE,          "branch-range"},
+    {ErrorCode::SHIFT_RANGE,           "shift-range"},
+    {ErrorCode::WORD_RANGE,            "word-range"},
+    {ErrorCode::NEGATIVE_SPACE,        "negative-space"},
+    {ErrorCode::ORG_BACKWARDS,         "org-backwards"},
+    {ErrorCode::ORG_RANGE,             "org-range"},
+    {ErrorCode::DUPLICATE_LABEL,       "duplicate-label"},
+    {ErrorCode::DUPLICATE_DEFINE,      "duplicate-define"},
+    {ErrorCode::UNKNOWN_INSTRUCTION,   "unknown-instruction"},
+    {ErrorCode::UNSUPPORTED_FORMAT,    "unsupported-format"},
+    {ErrorCode::ADDRESS_SPACE,         "address-space"},
+    {ErrorCode::DUPLICATE_GLOBAL,      "duplicate-global"},
+    {ErrorCode::SECTION_OVERLAP,       "section-overlap"},
+    {ErrorCode::TOO_MANY_ERRORS,       "too-many-errors"},
+};
+
+constexpr bool errorCodesInOrder() {
+    for (size_t i = 0; i < std::size(ERROR_CODES); i++) {
+        if (static_cast<size_t>(ERROR_CODES[i].code) != i) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(errorCodesInOrder(), "ERROR_CODES must be indexed by ErrorCode");
+
+constexpr std::string_view getErrorName(ErrorCode code) {
+    return ERROR_CODES[static_cast<size_t>(code)].name;
+}
+
+// Errors reported by one encode (--max-errors), the first in statement order
+constexpr size_t DEFAULT_MAX_ERRORS = 20;
+
+struct Diagnostic {
+    DiagnosticKind kind;
+    int line;                           // Source line, 0 if unknown
+    int column;                         // Source column, 0 if unknown
+    std::string message;                // Complete message text
+    uint16_t file = 0;                  // Statement::file of assembly errors
+    ErrorCode code = ErrorCode::NONE;   // Assembly errors only
+};
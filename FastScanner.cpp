@@ -0,0 +1,338 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Hand-written scanner for the qCore assembler
+//              Drop-in replacement for the flex lexer (lexer.l) - same tokens,
+//              same line/column tracking and messages. Blank and identifier
+//              runs are classified 16 bytes at a time with SSE2 where
+//              available, comments are skipped with memchr.
+//              Selected with -DSBASM_FAST_SCANNER=ON, or automatically when
+//              flex is not installed.
+// ============================================================================
+
+#include "parser.h"
+#include "common.h"
+#include "InstructionDef.h"
+#include "StringInterner.h"
+#include "ParseContext.h"
+#include "NumberParser.h"
+
+#if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+#include <emmintrin.h>
+#define SBASM_SCANNER_SSE2 1
+#endif
+
+// ============================================================================
+// Character classes
+// ============================================================================
+
+static inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+static inline bool isBinDigit(char c) { return c == '0' || c == '1'; }
+static inline bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+static inline bool isHexDigit(char c) {
+    return isDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+static inline bool isIdentStart(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+static inline bool isIdentChar(char c) { return isIdentStart(c) || isDigit(c); }
+
+#ifdef SBASM_SCANNER_SSE2
+// Bit i set if byte i of 'chunk' is in [lo, hi] (signed compare, ASCII only)
+static inline __m128i inRange(__m128i chunk, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8(static_cast<char>(lo - 1))),
+                         _mm_cmplt_epi8(chunk, _mm_set1_epi8(static_cast<char>(hi + 1))));
+}
+
+static inline uint32_t blankMask(__m128i chunk) {
+    const __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')),
+                                                _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))),
+                                   _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')));
+    return static_cast<uint32_t>(_mm_movemask_epi8(m));
+}
+
+static inline uint32_t identMask(__m128i chunk) {
+    const __m128i lower = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+    const __m128i m = _mm_or_si128(_mm_or_si128(inRange(lower, 'a', 'z'), inRange(chunk, '0', '9')),
+                                   _mm_cmpeq_epi8(chunk, _mm_set1_epi8('_')));
+    return static_cast<uint32_t>(_mm_movemask_epi8(m));
+}
+
+// Length of the run at 'p' whose bytes are all set in classify(chunk)
+template <uint32_t (*classify)(__m128i), bool (*scalar)(char)>
+static inline size_t spanRun(const char* p, const char* limit) {
+    const char* start = p;
+    while (limit - p >= 16) {
+        const uint32_t mask = classify(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+        if (mask != 0xFFFF) {
+            return static_cast<size_t>(p - start) + static_cast<size_t>(__builtin_ctz(~mask));
+        }
+        p += 16;
+    }
+    while (p < limit && scalar(*p)) {
+        p++;
+    }
+    return static_cast<size_t>(p - start);
+}
+
+static size_t spanBlanks(const char* p, const char* limit) { return spanRun<blankMask, isBlank>(p, limit); }
+static size_t spanIdent(const char* p, const char* limit) { return spanRun<identMask, isIdentChar>(p, limit); }
+#else
+static size_t spanBlanks(const char* p, const char* limit) {
+    const char* start = p;
+    while (p < limit && isBlank(*p)) {
+        p++;
+    }
+    return static_cast<size_t>(p - start);
+}
+
+static size_t spanIdent(const char* p, const char* limit) {
+    const char* start = p;
+    while (p < limit && isIdentChar(*p)) {
+        p++;
+    }
+    return static_cast<size_t>(p - start);
+}
+#endif
+
+// ============================================================================
+// Token matchers - each returns the match length, 0 if there is no match
+// ============================================================================
+
+// Longest of -?[0-9]+, -?0[xX][0-9a-fA-F]+ and -?0[bB][01]+
+static size_t matchNumber(const char* p) {
+    const char* q = (*p == '-') ? p + 1 : p;
+    const size_t sign = static_cast<size_t>(q - p);
+    size_t decimal = 0;
+    while (isDigit(q[decimal])) {
+        decimal++;
+    }
+    if (decimal == 0) {
+        return 0;
+    }
+
+    size_t prefixed = 0;
+    if (q[0] == '0' && (q[1] == 'x' || q[1] == 'X') && isHexDigit(q[2])) {
+        prefixed = 3;
+        while (isHexDigit(q[prefixed])) {
+            prefixed++;
+        }
+    } else if (q[0] == '0' && (q[1] == 'b' || q[1] == 'B') && isBinDigit(q[2])) {
+        prefixed = 3;
+        while (isBinDigit(q[prefixed])) {
+            prefixed++;
+        }
+    }
+    return sign + (prefixed > decimal ? prefixed : decimal);
+}
+
+// "([^"\\]|\\.)* " - a backslash escapes any character except newline
+static size_t matchString(const char* p, const char* limit) {
+    const char* q = p + 1;
+    while (q < limit) {
+        if (*q == '"') {
+            return static_cast<size_t>(q + 1 - p);
+        }
+        if (*q == '\\') {
+            if (q + 1 >= limit || q[1] == '\n') {
+                return 0;
+            }
+            q++;
+        }
+        q++;
+    }
+    return 0;
+}
+
+// ============================================================================
+// Scanner
+// ============================================================================
+
+class FastScanner {
+private:
+    ParseContext& ctx;
+    const char* cursor;     // Next character to scan
+    const char* limit;      // First of the two trailing NULs
+    YYSTYPE* lval = nullptr;
+
+    int textToken(int token, size_t length) {
+        lval->text = TokenText{cursor, static_cast<int>(length)};
+        ctx.column += static_cast<int>(length);
+        cursor += length;
+        return token;
+    }
+
+    // Same convention as set_number() in lexer.l
+    int numberToken(int token, size_t length, size_t skip) {
+        lval->number.text = TokenText{cursor, static_cast<int>(length)};
+        NumberLiteral& number = lval->number.value;
+        number.valid = parseNumber(std::string_view(cursor + skip, length - skip), number.value);
+        ctx.column += static_cast<int>(length);
+        cursor += length;
+        return token;
+    }
+
+    // Same convention as set_symbol() in lexer.l
+    int symbolToken(int token, size_t length, size_t skip, size_t trim) {
+        lval->symbol.text = TokenText{cursor, static_cast<int>(length - trim)};
+        lval->symbol.sym = ctx.symbols.intern(cursor + skip, length - skip - trim);
+        ctx.column += static_cast<int>(length);
+        cursor += length;
+        return token;
+    }
+
+    int unexpectedCharacter() {
+        ctx.report(DiagnosticKind::SCAN, "Unexpected character '" + std::string(1, *cursor) +
+                                         "' at line " + std::to_string(ctx.line) + ", column " + std::to_string(ctx.column));
+        cursor++;
+        return INVALID;
+    }
+
+    // #value / =value and their symbol forms
+    int prefixedOperand(int numberTokenType, int symbolTokenType) {
+        if (size_t length = matchNumber(cursor + 1)) {
+            return numberToken(numberTokenType, length + 1, 1);
+        }
+        if (isIdentStart(cursor[1])) {
+            return symbolToken(symbolTokenType, spanIdent(cursor + 1, limit) + 1, 1, 0);
+        }
+        return unexpectedCharacter();
+    }
+
+    int identifier() {
+        const size_t length = spanIdent(cursor, limit);
+        if (cursor[length] == ':') {
+            return symbolToken(LABEL, length + 1, 0, 1);
+        }
+
+        // Mnemonics and registers are resolved here, once
+        const std::string_view name(cursor, length);
+        if (const InstructionDef* def = getInstructionDef(name)) {
+            ctx.column += static_cast<int>(length);
+            cursor += length;
+            lval->def = def;
+            return INSTRUCTION;
+        }
+        uint8_t reg;
+        if (lookupRegister(name, reg)) {
+            lval->reg.text = TokenText{cursor, static_cast<int>(length)};
+            lval->reg.number = reg;
+            ctx.column += static_cast<int>(length);
+            cursor += length;
+            return REGISTER;
+        }
+        return symbolToken(IDENTIFIER, length, 0, 0);
+    }
+
+    int directive() {
+        const size_t length = spanIdent(cursor + 1, limit) + 1;
+        const std::string_view name(cursor, length);
+        if (isValidDirective(name)) {
+            return textToken(DIRECTIVE, length);
+        }
+        ctx.column += static_cast<int>(length);
+        ctx.report(DiagnosticKind::SCAN, "Unknown directive '" + std::string(name) + "' at line " +
+                                         std::to_string(ctx.line) + ", column " + std::to_string(ctx.column));
+        cursor += length;
+        return INVALID;
+    }
+
+public:
+    FastScanner(ParseContext& context, const char* base, size_t size)
+        : ctx(context), cursor(base), limit(base + size - 2) {}
+
+    int next(YYSTYPE* value) {
+        lval = value;
+        while (cursor < limit) {
+            const char c = *cursor;
+            ctx.tokenStart = SourceLocation{ctx.line, ctx.column};
+            switch (c) {
+                case ' ':
+                case '\t':
+                case '\r': {
+                    const size_t length = spanBlanks(cursor, limit);
+                    ctx.column += static_cast<int>(length);
+                    cursor += length;
+                    continue;
+                }
+
+                case '\n':
+                    ctx.line++;
+                    ctx.column = 1;
+                    cursor++;
+                    continue;
+
+                case '/':
+                    if (cursor[1] != '/') {
+                        return unexpectedCharacter();
+                    }
+                    {
+                        // Skip comments
+                        const void* newline = memchr(cursor, '\n', static_cast<size_t>(limit - cursor));
+                        cursor = newline ? static_cast<const char*>(newline) : limit;
+                    }
+                    continue;
+
+                case '"': {
+                    // Quoted string - escapes are decoded by the parser
+                    const size_t length = matchString(cursor, limit);
+                    return length ? textToken(STRING, length) : unexpectedCharacter();
+                }
+
+                case '.':
+                    return isIdentStart(cursor[1]) ? directive() : unexpectedCharacter();
+
+                case '#':
+                    return prefixedOperand(IMMEDIATE, IMMEDIATE_SYMBOL);
+
+                case '=':
+                    return prefixedOperand(LABEL_IMMEDIATE, LABEL_IMMEDIATE_SYMBOL);
+
+                case ',':
+                    ctx.column++;
+                    cursor++;
+                    return COMMA;
+
+                case '[':
+                    ctx.column++;
+                    cursor++;
+                    return LBRACKET;
+
+                case ']':
+                    ctx.column++;
+                    cursor++;
+                    return RBRACKET;
+
+                default:
+                    if (isIdentStart(c)) {
+                        return identifier();
+                    }
+                    if (size_t length = matchNumber(cursor)) {
+                        return numberToken(NUMBER, length, 0);
+                    }
+                    return unexpectedCharacter();
+            }
+        }
+        ctx.tokenStart = SourceLocation{ctx.line, ctx.column};
+        return END;
+    }
+};
+
+// ============================================================================
+// Scanner interface - same as the flex lexer
+// ============================================================================
+
+int scanner_next(YYSTYPE* lval, void* scanner) {
+    return static_cast<FastScanner*>(scanner)->next(lval);
+}
+
+void* scanner_create(ParseContext& ctx, char* base, size_t size) {
+    return new FastScanner(ctx, base, size);
+}
+
+void scanner_destroy(void* scanner) {
+    delete static_cast<FastScanner*>(scanner);
+}
@@ -0,0 +1,60 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: libFuzzer target for the assembler library (-DSBASM_FUZZ=ON,
+//              clang only)
+//              Each input is assembled as a source file. A program that
+//              assembles is written in every output format, listed, and its
+//              line table is serialized and decoded again; a table that does
+//              not survive that is reported as a crash. .include resolves
+//              against the working directory, so run it from an empty one:
+//
+//                  mkdir corpus && ./bin/sbasm_fuzz corpus
+// ============================================================================
+
+#include "Assembler.h"
+#include "Listing.h"
+#include "OutputWriter.h"
+
+// Larger inputs only slow the fuzzer down - the scanner and encoder paths
+// are all reached by small programs
+constexpr size_t FUZZ_MAX_INPUT = 64 * 1024;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size > FUZZ_MAX_INPUT) {
+        return 0;
+    }
+    // The scanner needs two trailing NULs
+    std::string buffer(reinterpret_cast<const char*>(data), size);
+    buffer.append(2, '\0');
+
+    AssemblerOptions options;
+    options.listing = true;
+    options.lineTable = true;
+    Assembler assembler;
+    assembler.setOptions(options);
+    assembler.setSourceName("fuzz.s");
+    if (!assembler.assemble(buffer.data(), buffer.size())) {
+        return 0;
+    }
+
+    const MemoryImage& image = assembler.getImage();
+    for (const OutputFormatDef& def : OUTPUT_FORMATS) {
+        OutputOptions output;
+        output.format = def.format;
+        output.depth = resolveMemoryDepth(image.size(), DEPTH_AUTO);
+        OutputBuffer out;
+        formatOutput(image, output, out);
+    }
+
+    OutputBuffer listing;
+    formatListing(assembler.getAST(), assembler.getStatementAddresses(), image, listing);
+    formatSymbolMap(assembler.getSymbolTable(), assembler.getSymbols().size(), "fuzz.s", listing);
+
+    const LineTable lines = assembler.getLineTable();
+    LineTable decoded;
+    if (!decodeLineTable(serializeLineTable(lines), decoded) || decoded.size() != lines.size()) {
+        __builtin_trap();
+    }
+    return 0;
+}
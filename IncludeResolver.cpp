@@ -0,0 +1,182 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: .include expansion implementation
+// ============================================================================
+
+#include "IncludeResolver.h"
+#include "parser.h"
+#include "MacroExpander.h"
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+void IncludeResolver::setMainFile(const std::string& path) {
+    std::error_code ec;
+    const fs::path canonical = fs::weakly_canonical(path, ec);
+    mainPath = ec ? path : canonical.string();
+    mainDirectory = fs::path(path).parent_path().string();
+}
+
+std::string IncludeResolver::resolve(std::string_view path) const {
+    const fs::path target{std::string(path)};
+    std::error_code ec;
+    if (target.is_absolute()) {
+        return fs::is_regular_file(target, ec) ? target.string() : std::string();
+    }
+
+    // The including file's directory first, then the -I directories in order
+    const std::string& base = stack.empty() ? mainDirectory : stack.back().directory;
+    const fs::path local = (fs::path(base) / target).lexically_normal();
+    if (fs::is_regular_file(local, ec)) {
+        return local.string();
+    }
+    for (const std::string& dir : options.searchPaths) {
+        const fs::path candidate = (fs::path(dir) / target).lexically_normal();
+        if (fs::is_regular_file(candidate, ec)) {
+            return candidate.string();
+        }
+    }
+    return std::string();
+}
+
+void IncludeResolver::parseFile(ParseContext& child, SourceFile& source, uint64_t hash, size_t first) {
+    parsedFiles++;
+    const size_t errors = child.diagnostics.size();
+
+    void* scanner = scanner_create(child, source.data(), source.bufferSize());
+    if (scanner == nullptr) {
+        child.report(DiagnosticKind::SCAN, "Could not create scanner");
+        return;
+    }
+    MacroExpander tokens(child, scanner);
+    const int result = yyparse(tokens, child);
+    scanner_destroy(scanner);
+
+    // Only clean parses are cached, errors are always reported from source.
+    // Macro definitions are not part of the statements, so files that
+    // define or use macros are always parsed.
+    if (result != 0 || child.diagnostics.size() != errors || tokens.usedMacros() ||
+        (options.cacheDirectory.empty() && options.memoryCache == nullptr)) {
+        return;
+    }
+
+    // The file's own statements - everything it added except nested expansions
+    std::vector<StatementRange> own;
+    size_t cursor = first;
+    for (const StatementRange& nested : stack.back().nested) {
+        own.push_back({cursor, nested.first});
+        cursor = nested.second;
+    }
+    own.push_back({cursor, child.ast.size()});
+    std::string entry = serializeParseCache(hash, source.size(), child.ast, child.symbols, own);
+    if (!options.cacheDirectory.empty()) {
+        writeParseCache(parseCachePath(options.cacheDirectory, hash), entry);
+    }
+    if (options.memoryCache != nullptr) {
+        options.memoryCache->store(hash, std::move(entry));
+    }
+}
+
+void IncludeResolver::include(ParseContext& ctx, std::string_view path, int line) {
+    auto fail = [&](const std::string& message) {
+        ctx.report(DiagnosticKind::PARSE, "Include error at line " + std::to_string(line) + ": " + message,
+                   SourceLocation{line, 0});
+    };
+
+    if (stack.size() >= MAX_INCLUDE_DEPTH) {
+        fail("Includes are nested more than " + std::to_string(MAX_INCLUDE_DEPTH) + " levels deep");
+        return;
+    }
+
+    const std::string resolved = resolve(path);
+    if (resolved.empty()) {
+        fail("Could not find include file '" + std::string(path) + "'");
+        return;
+    }
+
+    std::error_code ec;
+    const fs::path canonicalPath = fs::weakly_canonical(resolved, ec);
+    const std::string canonical = ec ? resolved : canonicalPath.string();
+    bool recursive = canonical == mainPath;
+    for (const Frame& frame : stack) {
+        recursive = recursive || frame.path == canonical;
+    }
+    if (recursive) {
+        fail("Recursive include of '" + std::string(path) + "'");
+        return;
+    }
+
+    std::unique_ptr<SourceFile> source;
+    try {
+        source = std::make_unique<SourceFile>(resolved);
+    } catch (const std::exception& e) {
+        fail(e.what());
+        return;
+    }
+
+    ParseContext child(ctx.ast, ctx.symbols, ctx.diagnostics);
+    child.includes = this;
+    child.macros = ctx.macros;
+    child.file = ctx.ast.addFile(resolved);
+    child.fileName = resolved;
+
+    const size_t first = ctx.ast.size();
+    stack.push_back({canonical, fs::path(resolved).parent_path().string(), {}});
+
+    const bool caching = !options.cacheDirectory.empty() || options.memoryCache != nullptr;
+    const uint64_t hash = caching ? hashContent(source->text()) : 0;
+
+    // Statements loaded from an entry point into it - the source is no longer needed
+    bool cached = false;
+    if (options.memoryCache != nullptr) {
+        const std::string* entry = options.memoryCache->find(hash);
+        cached = entry != nullptr && decodeParseCache(*entry, hash, source->size(), child, *this);
+    }
+    if (!cached && !options.cacheDirectory.empty()) {
+        std::unique_ptr<SourceFile> entry = loadParseCache(parseCachePath(options.cacheDirectory, hash),
+                                                           hash, source->size(), child, *this);
+        if (entry) {
+            cached = true;
+            buffers.push_back(std::move(entry));
+        }
+    }
+
+    if (cached) {
+        cachedFiles++;
+    } else {
+        parseFile(child, *source, hash, first);
+        buffers.push_back(std::move(source));
+    }
+
+    stack.pop_back();
+    if (!stack.empty()) {
+        stack.back().nested.push_back({first, ctx.ast.size()});
+    }
+}
+
+std::string_view IncludeResolver::incbin(ParseContext& ctx, std::string_view path, int line) {
+    auto fail = [&](const std::string& message) {
+        ctx.report(DiagnosticKind::PARSE, "Include error at line " + std::to_string(line) + ": " + message,
+                   SourceLocation{line, 0});
+    };
+
+    const std::string resolved = resolve(path);
+    if (resolved.empty()) {
+        fail("Could not find .incbin file '" + std::string(path) + "'");
+        return std::string_view();
+    }
+    std::unique_ptr<SourceFile> file;
+    try {
+        file = std::make_unique<SourceFile>(resolved);
+    } catch (const std::exception& e) {
+        fail(e.what());
+        return std::string_view();
+    }
+
+    // Listed with the sources, so --watch picks up changes to it
+    ctx.ast.addFile(resolved);
+    const std::string_view data = file->text();
+    buffers.push_back(std::move(file));
+    return data;
+}
@@ -0,0 +1,67 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: .include expansion with an optional parse cache
+//              Included files are parsed in place into the including
+//              program's AST. With a cache directory, each included file's
+//              statements are stored by content hash and loaded from there
+//              while the file is unchanged. .incbin files are found the
+//              same way and stay mapped as long as the resolver.
+// ============================================================================
+
+#pragma once
+#include "common.h"
+#include "ParseContext.h"
+#include "ParseCache.h"
+#include "SourceFile.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+constexpr size_t MAX_INCLUDE_DEPTH = 64;
+
+struct IncludeOptions {
+    std::vector<std::string> searchPaths;   // -I directories, tried after the including file's directory
+    std::string cacheDirectory;             // Empty: no parse cache
+    ParseCacheMemory* memoryCache = nullptr;    // In-process cache (--watch), tried first
+};
+
+class IncludeResolver : public IncludeHandler {
+private:
+    // One file being expanded
+    struct Frame {
+        std::string path;                       // Canonical path (recursion check)
+        std::string directory;                  // Base for relative includes
+        std::vector<StatementRange> nested;     // Statements added by nested includes
+    };
+
+    IncludeOptions options;
+    std::string mainDirectory;
+    std::string mainPath;
+    std::vector<Frame> stack;
+    std::vector<std::unique_ptr<SourceFile>> buffers;   // Sources, .incbin files and cache entries the AST points into
+    size_t cachedFiles = 0;     // Included files loaded from the cache
+    size_t parsedFiles = 0;     // Included files scanned and parsed
+
+    // First existing candidate for 'path', empty if none
+    std::string resolve(std::string_view path) const;
+
+    // Parse 'source' into the AST and store its own statements in the cache
+    void parseFile(ParseContext& child, SourceFile& source, uint64_t hash, size_t first);
+
+public:
+    void setOptions(const IncludeOptions& opts) { options = opts; }
+
+    // Path of the main source - relative includes of the main source are
+    // resolved against its directory (default: the working directory)
+    void setMainFile(const std::string& path);
+
+    void include(ParseContext& ctx, std::string_view path, int line) override;
+
+    // Map the file at 'path', found like an include, for the rest of the
+    // assembly
+    std::string_view incbin(ParseContext& ctx, std::string_view path, int line) override;
+
+    size_t getCachedFiles() const { return cachedFiles; }
+    size_t getParsedFiles() const { return parsedFiles; }
+};
@@ -3,13 +3,18 @@
 // Date: December 10, 2025
 // Description: Data-driven instruction definitions for the qCore assembler
 //              To add a new instruction, simply add an entry to INSTRUCTIONS table
+//              All tables are constexpr; name lookups use a perfect hash that
+//              is generated at compile time (no static init, thread-safe).
 // ============================================================================
 
 #pragma once
 #include <string>
-#include <vector>
-#include <unordered_map>
+#include <string_view>
 #include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <memory>
 #include <sstream>
 #include <iomanip>
 
@@ -28,134 +33,239 @@ enum class InstrFormat {
 
 // Instruction definition entry
 struct InstructionDef {
-    std::string mnemonic;   // Assembly mnemonic (e.g., "add", "mv", "beq")
-    InstrFormat format;     // How to parse and encode this instruction
-    uint16_t opcodeReg;     // Opcode for register variant
-    uint16_t opcodeImm;     // Opcode for immediate variant (0 if N/A)
-    int immBits;            // Number of bits for immediate field
-    uint8_t extraData;      // Format-specific data (e.g., branch condition, shift type)
-    int baseSize;           // Base instruction size in words (1 or 2)
-    bool canExpand;         // True if instruction can expand (e.g., =label generates 2 words)
-    std::string description;// Human-readable description for documentation
-    
-    InstructionDef(const std::string& m, InstrFormat f, uint16_t opR, uint16_t opI, 
-                   int bits, uint8_t extra = 0, int size = 1, bool expand = false,
-                   const std::string& desc = "")
-        : mnemonic(m), format(f), opcodeReg(opR), opcodeImm(opI), immBits(bits), 
-          extraData(extra), baseSize(size), canExpand(expand), description(desc) {}
+    std::string_view mnemonic;   // Assembly mnemonic (e.g., "add", "mv", "beq")
+    InstrFormat format;          // How to parse and encode this instruction
+    uint16_t opcodeReg;          // Opcode for register variant
+    uint16_t opcodeImm;          // Opcode for immediate variant (0 if N/A)
+    int immBits;                 // Number of bits for immediate field
+    uint8_t extraData;           // Format-specific data (e.g., branch condition, shift type)
+    int baseSize;                // Base instruction size in words (1 or 2)
+    bool canExpand;              // True if instruction can expand (e.g., =label generates 2 words)
+    int cycles;                  // Clock cycles per word executed, 3 fetch states included
+    std::string_view description;// Human-readable description for documentation
 };
 
-// INSTRUCTION TABLE - Add new instructions 
-// Format: {mnemonic, format, opcodeReg, opcodeImm, immBits, extraData, size, canExpand, description}
-
-inline const std::vector<InstructionDef>& getInstructionTable() {
-    static const std::vector<InstructionDef> INSTRUCTIONS = {
-        // Data Movement Instructions
-        {"mv",    InstrFormat::REG_IMM_OR_REG, 0x0000, 0x1000, 9, 0, 1, true,  "Move register or immediate to register"},
-        {"mvt",   InstrFormat::REG_IMM,        0x3000, 0x3000, 8, 0, 1, false, "Move to top byte of register"},
-        
-        // ALU Instructions
-        {"add",   InstrFormat::REG_IMM_OR_REG, 0x4000, 0x5000, 9, 0, 1, true,  "Add register or immediate"},
-        {"sub",   InstrFormat::REG_IMM_OR_REG, 0x6000, 0x7000, 9, 0, 1, true,  "Subtract register or immediate"},
-        {"and",   InstrFormat::REG_IMM_OR_REG, 0xC000, 0xD000, 9, 0, 1, true,  "Bitwise AND register or immediate"},
-        
-        // Compare Instruction
-        {"cmp",   InstrFormat::REG_IMM_OR_REG, 0xE000, 0xF000, 9, 0, 1, false, "Compare register with register or immediate"},
-        
-        // Memory Instructions
-        {"ld",    InstrFormat::REG_MEM,        0x8000, 0x8000, 0, 0, 1, false, "Load from memory"},
-        {"st",    InstrFormat::REG_MEM,        0xA000, 0xA000, 0, 0, 1, false, "Store to memory"},
-        {"push",  InstrFormat::REG_ONLY,       0xB000, 0xB000, 0, 0x05, 1, false, "Push register to stack"},
-        {"pop",   InstrFormat::REG_ONLY,       0x9000, 0x9000, 0, 0x05, 1, false, "Pop from stack to register"},
-        
-        // Shift Instructions (extraData = shift type: 0=LSL, 1=LSR, 2=ASR, 3=ROR)
-        {"lsl",   InstrFormat::SHIFT,          0xE000, 0xE000, 4, 0, 1, false, "Logical shift left"},
-        {"lsr",   InstrFormat::SHIFT,          0xE000, 0xE000, 4, 1, 1, false, "Logical shift right"},
-        {"asr",   InstrFormat::SHIFT,          0xE000, 0xE000, 4, 2, 1, false, "Arithmetic shift right"},
-        {"ror",   InstrFormat::SHIFT,          0xE000, 0xE000, 4, 3, 1, false, "Rotate right"},
-        
-        // Branch Instructions (extraData = condition code)
-        {"b",     InstrFormat::BRANCH,         0x2000, 0x2000, 9, 0, 1, false, "Unconditional branch"},
-        {"beq",   InstrFormat::BRANCH,         0x2000, 0x2000, 9, 1, 1, false, "Branch if equal (Z=1)"},
-        {"bne",   InstrFormat::BRANCH,         0x2000, 0x2000, 9, 2, 1, false, "Branch if not equal (Z=0)"},
-        {"bcc",   InstrFormat::BRANCH,         0x2000, 0x2000, 9, 3, 1, false, "Branch if carry clear (C=0)"},
-        {"bcs",   InstrFormat::BRANCH,         0x2000, 0x2000, 9, 4, 1, false, "Branch if carry set (C=1)"},
-        {"bpl",   InstrFormat::BRANCH,         0x2000, 0x2000, 9, 5, 1, false, "Branch if positive (N=0)"},
-        {"bmi",   InstrFormat::BRANCH,         0x2000, 0x2000, 9, 6, 1, false, "Branch if negative (N=1)"},
-        {"bl",    InstrFormat::BRANCH,         0x2000, 0x2000, 9, 7, 1, false, "Branch and link (call)"},
-
-        // Control Instructions
-        {"halt",  InstrFormat::NO_OPERAND,     0xE1F0, 0xE1F0, 0, 0, 1, false, "Halt processor execution"},
-    };
-    return INSTRUCTIONS;
+// Read-only view over a constexpr table, usable in range-for
+template <typename T>
+struct TableView {
+    const T* first;
+    size_t count;
+
+    constexpr const T* begin() const { return first; }
+    constexpr const T* end() const { return first + count; }
+    constexpr size_t size() const { return count; }
+};
+
+// COMPILE-TIME PERFECT HASH
+//
+// For each name table, a seed is searched at compile time such that every
+// name lands in its own slot. A lookup is then one hash, one slot load and
+// one string compare.
+
+namespace perfect_hash {
+
+constexpr uint32_t hash(std::string_view name, uint32_t seed) {
+    uint32_t h = 2166136261u ^ (seed * 0x9E3779B9u);
+    for (char c : name) {
+        h ^= static_cast<uint8_t>(c);
+        h *= 16777619u;
+    }
+    return h ^ (h >> 15);
 }
 
-inline const std::unordered_map<std::string, const InstructionDef*>& getInstructionMap() {
-    static std::unordered_map<std::string, const InstructionDef*> map;
-    static bool initialized = false;
-    
-    if (!initialized) {
-        for (const auto& instr : getInstructionTable()) {
-            map[instr.mnemonic] = &instr;
+template <size_t SLOTS>
+struct Table {
+    static_assert((SLOTS & (SLOTS - 1)) == 0, "Slot count must be a power of two");
+
+    uint32_t seed = 0;
+    bool valid = false;
+    int16_t slots[SLOTS] = {};   // Index into the definition table, -1 if empty
+
+    constexpr size_t slotOf(std::string_view name) const {
+        return hash(name, seed) & (SLOTS - 1);
+    }
+};
+
+template <size_t SLOTS, typename T, size_t N>
+constexpr Table<SLOTS> build(const T (&defs)[N], std::string_view T::*key) {
+    static_assert(N <= SLOTS, "Too many names for the slot count");
+    Table<SLOTS> table;
+    for (uint32_t seed = 0; seed < 100000; seed++) {
+        table.seed = seed;
+        for (size_t i = 0; i < SLOTS; i++) {
+            table.slots[i] = -1;
+        }
+        bool collision = false;
+        for (size_t i = 0; i < N && !collision; i++) {
+            size_t slot = table.slotOf(defs[i].*key);
+            if (table.slots[slot] >= 0) {
+                collision = true;
+            } else {
+                table.slots[slot] = static_cast<int16_t>(i);
+            }
+        }
+        if (!collision) {
+            table.valid = true;
+            return table;
         }
-        initialized = true;
     }
-    return map;
+    return table;
 }
 
-inline bool isValidInstruction(const std::string& mnemonic) {
-    return getInstructionMap().count(mnemonic) > 0;
+template <size_t SLOTS, typename T, size_t N>
+constexpr const T* find(const Table<SLOTS>& table, const T (&defs)[N],
+                        std::string_view T::*key, std::string_view name) {
+    int16_t index = table.slots[table.slotOf(name)];
+    return (index >= 0 && defs[index].*key == name) ? &defs[index] : nullptr;
 }
 
-inline const InstructionDef* getInstructionDef(const std::string& mnemonic) {
-    auto& map = getInstructionMap();
-    auto it = map.find(mnemonic);
-    return (it != map.end()) ? it->second : nullptr;
+} // namespace perfect_hash
+
+// INSTRUCTION TABLE - Add new instructions 
+// Format: {mnemonic, format, opcodeReg, opcodeImm, immBits, extraData, size, canExpand, cycles, description}
+// Cycle counts follow the multi-cycle qCore control FSM: 3 states to fetch
+// the instruction word, then 1 (moves), 2 (branches, stores, compares) or
+// 3 (ALU writeback, loads, stack) execute states.
+
+inline constexpr InstructionDef INSTRUCTIONS[] = {
+    // Data Movement Instructions
+    {"mv",    InstrFormat::REG_IMM_OR_REG, 0x0000, 0x1000, 9, 0, 1, true,  4, "Move register or immediate to register"},
+    {"mvt",   InstrFormat::REG_IMM,        0x3000, 0x3000, 8, 0, 1, false, 4, "Move to top byte of register"},
+    
+    // ALU Instructions
+    {"add",   InstrFormat::REG_IMM_OR_REG, 0x4000, 0x5000, 9, 0, 1, true,  6, "Add register or immediate"},
+    {"sub",   InstrFormat::REG_IMM_OR_REG, 0x6000, 0x7000, 9, 0, 1, true,  6, "Subtract register or immediate"},
+    {"and",   InstrFormat::REG_IMM_OR_REG, 0xC000, 0xD000, 9, 0, 1, true,  6, "Bitwise AND register or immediate"},
+    
+    // Compare Instruction
+    {"cmp",   InstrFormat::REG_IMM_OR_REG, 0xE000, 0xF000, 9, 0, 1, false, 5, "Compare register with register or immediate"},
+    
+    // Memory Instructions
+    {"ld",    InstrFormat::REG_MEM,        0x8000, 0x8000, 0, 0, 1, false, 6, "Load from memory"},
+    {"st",    InstrFormat::REG_MEM,        0xA000, 0xA000, 0, 0, 1, false, 5, "Store to memory"},
+    {"push",  InstrFormat::REG_ONLY,       0xB000, 0xB000, 0, 0x05, 1, false, 6, "Push register to stack"},
+    {"pop",   InstrFormat::REG_ONLY,       0x9000, 0x9000, 0, 0x05, 1, false, 6, "Pop from stack to register"},
+    
+    // Shift Instructions (extraData = shift type: 0=LSL, 1=LSR, 2=ASR, 3=ROR)
+    {"lsl",   InstrFormat::SHIFT,          0xE000, 0xE000, 4, 0, 1, false, 6, "Logical shift left"},
+    {"lsr",   InstrFormat::SHIFT,          0xE000, 0xE000, 4, 1, 1, false, 6, "Logical shift right"},
+    {"asr",   InstrFormat::SHIFT,          0xE000, 0xE000, 4, 2, 1, false, 6, "Arithmetic shift right"},
+    {"ror",   InstrFormat::SHIFT,          0xE000, 0xE000, 4, 3, 1, false, 6, "Rotate right"},
+    
+    // Branch Instructions (extraData = condition code)
+    {"b",     InstrFormat::BRANCH,         0x2000, 0x2000, 9, 0, 1, false, 5, "Unconditional branch"},
+    {"beq",   InstrFormat::BRANCH,         0x2000, 0x2000, 9, 1, 1, false, 5, "Branch if equal (Z=1)"},
+    {"bne",   InstrFormat::BRANCH,         0x2000, 0x2000, 9, 2, 1, false, 5, "Branch if not equal (Z=0)"},
+    {"bcc",   InstrFormat::BRANCH,         0x2000, 0x2000, 9, 3, 1, false, 5, "Branch if carry clear (C=0)"},
+    {"bcs",   InstrFormat::BRANCH,         0x2000, 0x2000, 9, 4, 1, false, 5, "Branch if carry set (C=1)"},
+    {"bpl",   InstrFormat::BRANCH,         0x2000, 0x2000, 9, 5, 1, false, 5, "Branch if positive (N=0)"},
+    {"bmi",   InstrFormat::BRANCH,         0x2000, 0x2000, 9, 6, 1, false, 5, "Branch if negative (N=1)"},
+    {"bl",    InstrFormat::BRANCH,         0x2000, 0x2000, 9, 7, 1, false, 6, "Branch and link (call)"},
+
+    // Control Instructions
+    {"halt",  InstrFormat::NO_OPERAND,     0xE1F0, 0xE1F0, 0, 0, 1, false, 4, "Halt processor execution"},
+};
+
+inline constexpr auto INSTRUCTION_HASH = perfect_hash::build<64>(INSTRUCTIONS, &InstructionDef::mnemonic);
+static_assert(INSTRUCTION_HASH.valid, "No perfect hash found for instruction mnemonics");
+
+constexpr TableView<InstructionDef> getInstructionTable() {
+    return {INSTRUCTIONS, std::size(INSTRUCTIONS)};
+}
+
+constexpr const InstructionDef* getInstructionDef(std::string_view mnemonic) {
+    return perfect_hash::find(INSTRUCTION_HASH, INSTRUCTIONS, &InstructionDef::mnemonic, mnemonic);
+}
+
+// Values a #immediate of 'def' accepts - its field read as a signed
+// number, except for two instructions whose decoding differs:
+//  - mvt sets the top byte, written signed or unsigned (-128 to 255)
+//  - cmp shares its opcode with the shifts and halt, which have bit 8 of
+//    the field set, so it only has the low 8 bits, zero extended
+struct ImmediateRange {
+    int64_t minimum;
+    int64_t maximum;
+};
+
+constexpr ImmediateRange getImmediateRange(const InstructionDef* def) {
+    const int64_t half = 1ll << (def->immBits - 1);
+    if (def->mnemonic == "mvt") {
+        return {-half, 2 * half - 1};
+    }
+    if (def->mnemonic == "cmp") {
+        return {0, half - 1};
+    }
+    return {-half, half - 1};
+}
+
+// Conditional branches and their inverse condition - used by branch
+// relaxation to skip over a long jump
+struct BranchInverse {
+    std::string_view branch;
+    std::string_view inverse;
+};
+
+inline constexpr BranchInverse BRANCH_INVERSES[] = {
+    {"beq", "bne"}, {"bne", "beq"},
+    {"bcc", "bcs"}, {"bcs", "bcc"},
+    {"bpl", "bmi"}, {"bmi", "bpl"},
+};
+
+constexpr const InstructionDef* getInvertedBranch(const InstructionDef* def) {
+    for (const auto& entry : BRANCH_INVERSES) {
+        if (entry.branch == def->mnemonic) {
+            return getInstructionDef(entry.inverse);
+        }
+    }
+    return nullptr;
+}
+
+constexpr bool isValidInstruction(std::string_view mnemonic) {
+    return getInstructionDef(mnemonic) != nullptr;
 }
 
 // REGISTER DEFINITIONS
 
 struct RegisterDef {
-    std::string name;
+    std::string_view name;
     uint8_t number;
-    std::string description;
-    
-    RegisterDef(const std::string& n, uint8_t num, const std::string& desc = "")
-        : name(n), number(num), description(desc) {}
+    std::string_view description;
 };
 
-inline const std::vector<RegisterDef>& getRegisterTable() {
-    static const std::vector<RegisterDef> REGISTERS = {
-        {"r0", 0, "General purpose register 0"},
-        {"r1", 1, "General purpose register 1"},
-        {"r2", 2, "General purpose register 2"},
-        {"r3", 3, "General purpose register 3"},
-        {"r4", 4, "General purpose register 4"},
-        {"r5", 5, "General purpose register 5 / Stack Pointer"},
-        {"r6", 6, "General purpose register 6 / Link Register"},
-        {"r7", 7, "General purpose register 7 / Program Counter"},
-        {"sp", 5, "Stack Pointer (alias for r5)"},
-        {"lr", 6, "Link Register (alias for r6)"},
-        {"pc", 7, "Program Counter (alias for r7)"},
-    };
-    return REGISTERS;
+inline constexpr RegisterDef REGISTERS[] = {
+    {"r0", 0, "General purpose register 0"},
+    {"r1", 1, "General purpose register 1"},
+    {"r2", 2, "General purpose register 2"},
+    {"r3", 3, "General purpose register 3"},
+    {"r4", 4, "General purpose register 4"},
+    {"r5", 5, "General purpose register 5 / Stack Pointer"},
+    {"r6", 6, "General purpose register 6 / Link Register"},
+    {"r7", 7, "General purpose register 7 / Program Counter"},
+    {"sp", 5, "Stack Pointer (alias for r5)"},
+    {"lr", 6, "Link Register (alias for r6)"},
+    {"pc", 7, "Program Counter (alias for r7)"},
+};
+
+constexpr uint8_t PC_REGISTER = 7;
+
+inline constexpr auto REGISTER_HASH = perfect_hash::build<32>(REGISTERS, &RegisterDef::name);
+static_assert(REGISTER_HASH.valid, "No perfect hash found for register names");
+
+constexpr TableView<RegisterDef> getRegisterTable() {
+    return {REGISTERS, std::size(REGISTERS)};
 }
 
-inline const std::unordered_map<std::string, uint8_t>& getRegisterMap() {
-    static std::unordered_map<std::string, uint8_t> regMap;
-    static bool initialized = false;
-    
-    if (!initialized) {
-        for (const auto& reg : getRegisterTable()) {
-            regMap[reg.name] = reg.number;
-        }
-        initialized = true;
-    }
-    return regMap;
+constexpr bool isValidRegister(std::string_view reg) {
+    return perfect_hash::find(REGISTER_HASH, REGISTERS, &RegisterDef::name, reg) != nullptr;
 }
 
-inline bool isValidRegister(const std::string& reg) {
-    return getRegisterMap().count(reg) > 0;
+constexpr bool lookupRegister(std::string_view reg, uint8_t& number) {
+    const RegisterDef* def = perfect_hash::find(REGISTER_HASH, REGISTERS, &RegisterDef::name, reg);
+    if (def == nullptr) {
+        return false;
+    }
+    number = def->number;
+    return true;
 }
 
 inline const char* getRegisterName(uint8_t regNum) {
@@ -166,159 +276,300 @@ inline const char* getRegisterName(uint8_t regNum) {
 // DIRECTIVE DEFINITIONS
 
 struct DirectiveDef {
-    std::string name;
-    std::string description;
-    
-    DirectiveDef(const std::string& n, const std::string& desc = "")
-        : name(n), description(desc) {}
+    std::string_view name;
+    std::string_view description;
 };
 
-inline const std::vector<DirectiveDef>& getDirectiveTable() {
-    static const std::vector<DirectiveDef> DIRECTIVES = {
-        {".word",   "Emit a 16-bit word value"},
-        {".define", "Define a symbolic constant"},
-        {".org",    "Set the current assembly address (origin)"},
-        {".space",  "Reserve N words of zero-initialized memory"},
-        {".ascii",  "Emit a string as words (one char per word, no null terminator)"},
-        {".asciiz", "Emit a null-terminated string (one char per word)"},
-    };
-    return DIRECTIVES;
+inline constexpr DirectiveDef DIRECTIVES[] = {
+    {".word",   "Emit 16-bit word values (.word a, b, ...)"},
+    {".define", "Define a symbolic constant"},
+    {".org",    "Set the current assembly address (origin)"},
+    {".space",  "Reserve N words of zero-initialized memory"},
+    {".ascii",  "Emit a string as words (one char per word, no null terminator)"},
+    {".asciiz", "Emit a null-terminated string (one char per word)"},
+    {".include", "Assemble the statements of another source file in place"},
+    {".loopbound", "Most times the loop at a label runs, for --timing"},
+    {".fill",   "Emit a count of copies of one word (.fill count, value)"},
+    {".incbin", "Emit the bytes of a binary file as little-endian words"},
+    {".macro",  "Define a macro up to .endm (.macro name p1, p2, ...)"},
+    {".endm",   "End a .macro definition"},
+    {".rept",   "Assemble the lines up to .endr a count of times"},
+    {".endr",   "End a .rept block"},
+    {".local",  "Labels made unique per expansion of a .macro or .rept body"},
+    {".global", "Export labels and defines to other objects (.global name, ...)"},
+};
+
+inline constexpr auto DIRECTIVE_HASH = perfect_hash::build<32>(DIRECTIVES, &DirectiveDef::name);
+static_assert(DIRECTIVE_HASH.valid, "No perfect hash found for directive names");
+
+constexpr TableView<DirectiveDef> getDirectiveTable() {
+    return {DIRECTIVES, std::size(DIRECTIVES)};
 }
 
-inline const std::unordered_map<std::string, const DirectiveDef*>& getDirectiveMap() {
-    static std::unordered_map<std::string, const DirectiveDef*> map;
-    static bool initialized = false;
-    
-    if (!initialized) {
-        for (const auto& dir : getDirectiveTable()) {
-            map[dir.name] = &dir;
-        }
-        initialized = true;
-    }
-    return map;
+constexpr const DirectiveDef* getDirectiveDef(std::string_view dir) {
+    return perfect_hash::find(DIRECTIVE_HASH, DIRECTIVES, &DirectiveDef::name, dir);
 }
 
-inline bool isValidDirective(const std::string& dir) {
-    return getDirectiveMap().count(dir) > 0;
+constexpr bool isValidDirective(std::string_view dir) {
+    return getDirectiveDef(dir) != nullptr;
 }
 
+static_assert(getInstructionDef("halt") == &INSTRUCTIONS[std::size(INSTRUCTIONS) - 1], "Instruction hash broken");
+static_assert(getInstructionDef("nop") == nullptr, "Instruction hash broken");
+
 // DISASSEMBLY - Used by MIF writer
+//
+// The decoder writes into caller-provided fixed-size buffers instead of
+// building strings. Only branch targets depend on the address, so the
+// address-independent text of every word can be cached (DisassemblyTable).
+
+constexpr size_t DISASM_MAX_LENGTH = 32;   // Upper bound for any disassembly text
+
+// Lowercase hex without padding (matches std::hex), returns chars written
+inline size_t formatHex(uint32_t value, char* out) {
+    static const char digits[] = "0123456789abcdef";
+    char tmp[8];
+    size_t n = 0;
+    do {
+        tmp[n++] = digits[value & 0xF];
+        value >>= 4;
+    } while (value != 0);
+    for (size_t i = 0; i < n; i++) {
+        out[i] = tmp[n - 1 - i];
+    }
+    return n;
+}
 
-inline std::string disassembleInstruction(uint16_t instr, size_t address) {
-    std::ostringstream oss;
-    
-    uint16_t opcode = (instr >> 13) & 0x7;
-    uint16_t imm = (instr >> 12) & 0x1;
-    uint16_t rX = (instr >> 9) & 0x7;
-    uint16_t rY = instr & 0x7;
-    uint16_t immediate9 = instr & 0x1FF;
-    uint16_t immediate8 = instr & 0xFF;
+inline size_t appendText(char* out, const char* text) {
+    size_t n = strlen(text);
+    memcpy(out, text, n);
+    return n;
+}
+
+inline bool isBranchWord(uint16_t instr) {
+    return ((instr >> 13) & 0x7) == 1 && !((instr >> 12) & 0x1);
+}
+
+inline uint32_t branchTarget(uint16_t instr, size_t address) {
+    int16_t offset = instr & 0x1FF;
+    if (offset & 0x100) offset |= 0xFE00;  // Sign extend
+    return static_cast<uint32_t>(static_cast<int>(address) + 1 + offset);
+}
+
+// DECODING - one instruction word into its fields, shared by the
+// disassembler and the simulator
+
+enum class Operation : uint8_t {
+    MV, MVT, ADD, SUB, AND, CMP, LD, ST, PUSH, POP, LSL, LSR, ASR, ROR, BRANCH, HALT
+};
+
+struct DecodedWord {
+    Operation op;
+    bool immediate;     // Second operand is 'value' instead of rY
+    uint8_t rX;         // Condition code for branches
+    uint8_t rY;         // Stack pointer for push and pop
+    int16_t value;      // Sign-extended 9-bit immediate or branch offset,
+                        // mvt byte or shift amount
+};
+
+constexpr DecodedWord decodeWord(uint16_t instr) {
+    const uint16_t opcode = (instr >> 13) & 0x7;
+    const bool imm = (instr >> 12) & 0x1;
+    const uint8_t rX = (instr >> 9) & 0x7;
+    const uint8_t rY = instr & 0x7;
+    const int16_t immediate9 = static_cast<int16_t>((instr & 0x100) ? (instr & 0x1FF) - 0x200 : (instr & 0x1FF));
 
     switch (opcode) {
-        case 0: // MV register
-            oss << "mv   " << getRegisterName(rX) << ", " << getRegisterName(rY);
-            break;
+        case 0: return {Operation::MV, imm, rX, rY, immediate9};
+        case 1: return imm ? DecodedWord{Operation::MVT, true, rX, rY, static_cast<int16_t>(instr & 0xFF)}
+                           : DecodedWord{Operation::BRANCH, true, rX, rY, immediate9};
+        case 2: return {Operation::ADD, imm, rX, rY, immediate9};
+        case 3: return {Operation::SUB, imm, rX, rY, immediate9};
+        case 4: return {imm ? Operation::POP : Operation::LD, false, rX, rY, 0};
+        case 5: return {imm ? Operation::PUSH : Operation::ST, false, rX, rY, 0};
+        case 6: return {Operation::AND, imm, rX, rY, immediate9};
+        default: break;
+    }
 
-        case 1: // MV immediate or Branch
-            if (imm) {
-                oss << "mvt  " << getRegisterName(rX) << ", #0x" << std::hex << immediate8;
-            } else {
-                static const char* conditions[] = {"b   ", "beq ", "bne ", "bcc ", "bcs ", "bpl ", "bmi ", "bl  "};
-                int16_t offset = immediate9;
-                if (offset & 0x100) offset |= 0xFE00;  // Sign extend
-                int target = address + 1 + offset;
-                oss << conditions[rX] << "0x" << std::hex << target;
-            }
-            break;
+    // CMP, shifts and HALT (1110---11111----)
+    if (!((instr >> 8) & 0x1)) {
+        return {Operation::CMP, imm, rX, rY, immediate9};
+    }
+    const bool immShift = (instr >> 7) & 0x1;
+    const uint16_t shiftType = (instr >> 5) & 0x3;
+    if (immShift && shiftType == 3 && (instr & 0x10)) {
+        return {Operation::HALT, false, rX, rY, 0};
+    }
+    constexpr Operation shifts[] = {Operation::LSL, Operation::LSR, Operation::ASR, Operation::ROR};
+    return {shifts[shiftType], immShift, rX, rY, static_cast<int16_t>(instr & 0xF)};
+}
 
-        case 2: // ADD
-            if (imm) {
-                oss << "add  " << getRegisterName(rX) << ", #0x" << std::hex << immediate9;
-            } else {
-                oss << "add  " << getRegisterName(rX) << ", " << getRegisterName(rY);
-            }
-            break;
+// Table entry of a decoded word - for its mnemonic and cycle count
+constexpr const InstructionDef* getDecodedDef(const DecodedWord& decoded) {
+    constexpr std::string_view names[] = {"mv", "mvt", "add", "sub", "and", "cmp", "ld", "st",
+                                          "push", "pop", "lsl", "lsr", "asr", "ror", "b", "halt"};
+    constexpr std::string_view branches[] = {"b", "beq", "bne", "bcc", "bcs", "bpl", "bmi", "bl"};
+    return getInstructionDef(decoded.op == Operation::BRANCH ? branches[decoded.rX]
+                                                             : names[static_cast<int>(decoded.op)]);
+}
 
-        case 3: // SUB
-            if (imm) {
-                oss << "sub  " << getRegisterName(rX) << ", #0x" << std::hex << immediate9;
-            } else {
-                oss << "sub  " << getRegisterName(rX) << ", " << getRegisterName(rY);
-            }
-            break;
+// Address-independent part of the disassembly. For branches this is the
+// mnemonic followed by "0x"; the caller appends the target.
+inline size_t disassembleStatic(uint16_t instr, char* out) {
+    const DecodedWord decoded = decodeWord(instr);
+    const uint8_t rX = decoded.rX;
+    const uint8_t rY = decoded.rY;
+    char* p = out;
+
+    // Common operand shapes
+    auto regReg = [&](const char* mnemonic) {
+        p += appendText(p, mnemonic);
+        p += appendText(p, getRegisterName(rX));
+        p += appendText(p, ", ");
+        p += appendText(p, getRegisterName(rY));
+    };
+    auto regImm = [&](const char* mnemonic, uint16_t value) {
+        p += appendText(p, mnemonic);
+        p += appendText(p, getRegisterName(rX));
+        p += appendText(p, ", #0x");
+        p += formatHex(value, p);
+    };
+    auto regMem = [&](const char* mnemonic) {
+        p += appendText(p, mnemonic);
+        p += appendText(p, getRegisterName(rX));
+        p += appendText(p, ", [");
+        p += appendText(p, getRegisterName(rY));
+        p += appendText(p, "]");
+    };
+    // Immediates print as the sign-extended value the encoder accepts
+    auto aluOp = [&](const char* mnemonic) {
+        if (!decoded.immediate) {
+            regReg(mnemonic);
+        } else if (decoded.value < 0) {
+            p += appendText(p, mnemonic);
+            p += appendText(p, getRegisterName(rX));
+            p += appendText(p, ", #-0x");
+            p += formatHex(static_cast<uint32_t>(-decoded.value), p);
+        } else {
+            regImm(mnemonic, static_cast<uint16_t>(decoded.value));
+        }
+    };
 
-        case 4: // LD or POP
-            if (imm) {
-                oss << "pop  " << getRegisterName(rX);
-            } else {
-                oss << "ld   " << getRegisterName(rX) << ", [" << getRegisterName(rY) << "]";
+    switch (decoded.op) {
+        case Operation::MV:  aluOp("mv   "); break;
+        case Operation::ADD: aluOp("add  "); break;
+        case Operation::SUB: aluOp("sub  "); break;
+        case Operation::AND: aluOp("and  "); break;
+        case Operation::MVT: regImm("mvt  ", decoded.value); break;
+        case Operation::LD:  regMem("ld   "); break;
+        case Operation::ST:  regMem("st   "); break;
+
+        // The stack register is rY (extraData); the assembler only writes sp,
+        // so any other register prints as the raw word
+        case Operation::PUSH:
+        case Operation::POP:
+            if (rY != getDecodedDef(decoded)->extraData) {
+                p += appendText(p, ".word 0x");
+                p += formatHex(instr, p);
+                break;
             }
+            p += appendText(p, decoded.op == Operation::PUSH ? "push " : "pop  ");
+            p += appendText(p, getRegisterName(rX));
             break;
 
-        case 5: // ST or PUSH
-            if (imm) {
-                oss << "push " << getRegisterName(rX);
-            } else {
-                oss << "st   " << getRegisterName(rX) << ", [" << getRegisterName(rY) << "]";
-            }
+        case Operation::BRANCH: {
+            static const char* conditions[] = {"b   ", "beq ", "bne ", "bcc ", "bcs ", "bpl ", "bmi ", "bl  "};
+            p += appendText(p, conditions[rX]);
+            p += appendText(p, "0x");
             break;
+        }
 
-        case 6: // AND
-            if (imm) {
-                oss << "and  " << getRegisterName(rX) << ", #0x" << std::hex << immediate9;
-            } else {
-                oss << "and  " << getRegisterName(rX) << ", " << getRegisterName(rY);
-            }
-            break;
+        case Operation::CMP: aluOp("cmp  "); break;
 
-        case 7: // CMP, Shifts, HALT
-        {
-            uint16_t shiftFlag = (instr >> 8) & 0x1;
-            
-            if (shiftFlag) {
-                uint16_t immShift = (instr >> 7) & 0x1;
-                uint16_t shiftType = (instr >> 5) & 0x3;
-                uint16_t shiftAmount = instr & 0xF;
-                
-                // Check for HALT: 1110---11111----
-                if (immShift && shiftType == 3 && (instr & 0x10)) {
-                    oss << "halt";
-                } else {
-                    static const char* shiftTypes[] = {"lsl ", "lsr ", "asr ", "ror "};
-                    oss << shiftTypes[shiftType] << getRegisterName(rX);
-                    if (immShift) {
-                        oss << ", #0x" << std::hex << shiftAmount;
-                    } else {
-                        oss << ", " << getRegisterName(rY);
-                    }
-                }
-            } else if (imm) {
-                // CMP immediate
-                if (immediate9 & 0x100) {
-                    int16_t signedImm = immediate9 | 0xFE00;
-                    oss << "cmp  " << getRegisterName(rX) << ", #-0x" << std::hex << (-signedImm);
-                } else {
-                    oss << "cmp  " << getRegisterName(rX) << ", #0x" << std::hex << immediate9;
-                }
-            } else {
-                oss << "cmp  " << getRegisterName(rX) << ", " << getRegisterName(rY);
-            }
+        case Operation::LSL:
+        case Operation::LSR:
+        case Operation::ASR:
+        case Operation::ROR: {
+            static const char* shiftTypes[] = {"lsl ", "lsr ", "asr ", "ror "};
+            const char* mnemonic = shiftTypes[static_cast<int>(decoded.op) - static_cast<int>(Operation::LSL)];
+            if (decoded.immediate) regImm(mnemonic, decoded.value); else regReg(mnemonic);
+            break;
         }
-        break;
+
+        case Operation::HALT:
+            p += appendText(p, "halt");
+            break;
     }
     
-    return oss.str();
+    return p - out;
 }
 
-inline std::string formatDataWord(uint16_t value) {
-    std::ostringstream oss;
-    oss << "data 0x" << std::hex << std::setw(4) << std::setfill('0') << value;
+// Full disassembly into 'out' (at least DISASM_MAX_LENGTH bytes)
+inline size_t disassembleInto(uint16_t instr, size_t address, char* out) {
+    size_t n = disassembleStatic(instr, out);
+    if (isBranchWord(instr)) {
+        n += formatHex(branchTarget(instr, address), out + n);
+    }
+    return n;
+}
+
+inline std::string disassembleInstruction(uint16_t instr, size_t address) {
+    char text[DISASM_MAX_LENGTH];
+    return std::string(text, disassembleInto(instr, address, text));
+}
+
+// Data word comment into 'out' (at least DISASM_MAX_LENGTH bytes)
+inline size_t formatDataWordInto(uint16_t value, char* out) {
+    static const char digits[] = "0123456789abcdef";
+    char* p = out;
+    p += appendText(p, "data 0x");
+    for (int shift = 12; shift >= 0; shift -= 4) {
+        *p++ = digits[(value >> shift) & 0xF];
+    }
     if (value >= 0x20 && value < 0x7F) {
-        oss << " '" << static_cast<char>(value) << "'";
+        *p++ = ' ';
+        *p++ = '\'';
+        *p++ = static_cast<char>(value);
+        *p++ = '\'';
     }
-    return oss.str();
+    return p - out;
 }
 
+inline std::string formatDataWord(uint16_t value) {
+    char text[DISASM_MAX_LENGTH];
+    return std::string(text, formatDataWordInto(value, text));
+}
+
+// Lazily filled decode table covering the whole 16-bit instruction space.
+// Each word is decoded at most once; later occurrences are a memcpy plus,
+// for branches, patching in the address-dependent target.
+class DisassemblyTable {
+private:
+    struct Entry {
+        char text[23];
+        uint8_t length;     // 0 = not decoded yet
+    };
+    static_assert(sizeof(Entry) == 24, "Unexpected DisassemblyTable entry size");
+
+    std::unique_ptr<Entry[]> entries;
+
+public:
+    DisassemblyTable() : entries(new Entry[0x10000]()) {}
+
+    size_t format(uint16_t instr, size_t address, char* out) {
+        Entry& entry = entries[instr];
+        if (entry.length == 0) {
+            entry.length = static_cast<uint8_t>(disassembleStatic(instr, entry.text));
+        }
+        memcpy(out, entry.text, entry.length);
+        size_t n = entry.length;
+        if (isBranchWord(instr)) {
+            n += formatHex(branchTarget(instr, address), out + n);
+        }
+        return n;
+    }
+};
+
 // FORMAT HELPERS
 
 inline std::string getFormatString(InstrFormat format) {
@@ -338,7 +589,7 @@ inline std::string getFormatString(InstrFormat format) {
 
 inline std::string getFormatHint(const InstructionDef* def) {
     if (!def) return "";
-    return "Expected format: " + def->mnemonic + " " + getFormatString(def->format);
+    return "Expected format: " + std::string(def->mnemonic) + " " + getFormatString(def->format);
 }
 
 // DOCUMENTATION GENERATOR
@@ -6,24 +6,144 @@
 
 #include "InstructionEncoder.h"
 #include "InstructionDef.h"
+#include "Parallel.h"
+#include "Stats.h"
+#include <algorithm>
 
-uint8_t Encoder::parseRegister(const std::string& reg) {
-    auto& regMap = getRegisterMap();
-    auto it = regMap.find(reg);
-    if (it == regMap.end()) {
-        throw std::runtime_error("Invalid register name: " + reg);
+std::string Encoder::location(uint16_t file, int line) const {
+    std::string text = "line " + std::to_string(line);
+    if (file != 0 && program != nullptr) {
+        text += " of " + program->fileName(file);
     }
-    return it->second;
+    return text;
 }
 
-uint16_t Encoder::encodeImmediate(int64_t value, int bits, const std::string& context) {
-    int64_t maxVal = (1ll << (bits - 1)) - 1;
-    int64_t minVal = -(1ll << (bits - 1));
-    
-    if (value > maxVal || value < minVal) {
-        throw std::runtime_error("Immediate value " + std::to_string(value) + 
-                                " out of range [" + std::to_string(minVal) + ", " + 
-                                std::to_string(maxVal) + "] for " + context);
+// Error reporting - a statement records at most one fault, turned into a
+// Diagnostic when the statement is done
+
+void Encoder::fail(const EncodeFault& f) {
+    if (fault.code == ErrorCode::NONE) {
+        fault = f;
+    }
+}
+
+void Encoder::finishStatement() {
+    if (fault.code == ErrorCode::NONE) {
+        return;
+    }
+    const Statement& stmt = *currentStatement;
+    if (!resolving && maxErrors != 0 && errors.size() >= maxErrors) {
+        truncated = true;
+    } else {
+        Diagnostic diag{DiagnosticKind::ASSEMBLY, stmt.line, stmt.column, describe(stmt, fault), stmt.file,
+                        fault.code};
+        errors.push_back({static_cast<size_t>(&stmt - &(*program)[0]), std::move(diag)});
+    }
+    if (fault.code == ErrorCode::ADDRESS_SPACE) {
+        halted = true;
+    }
+    fault = EncodeFault();
+}
+
+bool Encoder::hasError(const Statement& stmt) const {
+    const size_t index = static_cast<size_t>(&stmt - &(*program)[0]);
+    return std::any_of(errors.begin(), errors.end(),
+                       [index](const std::pair<size_t, Diagnostic>& error) { return error.first == index; });
+}
+
+std::string Encoder::describe(const Statement& stmt, const EncodeFault& f) const {
+    const std::string context = !f.context.empty() ? std::string(f.context) : fixupContext(f.kind, f.def);
+    std::string text;
+    switch (f.code) {
+        case ErrorCode::INVALID_REGISTER:
+            text = "Invalid register name: " + std::string(f.operand);
+            break;
+        case ErrorCode::IMMEDIATE_RANGE:
+        case ErrorCode::SHORT_IMMEDIATE_RANGE:
+        case ErrorCode::BRANCH_RANGE:
+        case ErrorCode::SHIFT_RANGE:
+            text = describeFieldFault(f);
+            break;
+        case ErrorCode::INVALID_NUMBER:
+            text = "Failed to parse immediate value '" + std::string(f.operand) + "' for " + context +
+                   ": invalid number";
+            break;
+        case ErrorCode::UNDEFINED_SYMBOL:
+            text = "Failed to parse immediate value '" + std::string(f.operand) + "' for " + context +
+                   ": Undefined symbol: " + std::string(symbolTable.getName(f.symbol));
+            break;
+        case ErrorCode::UNDEFINED_LABEL:
+            text = "Undefined label: " + std::string(f.operand);
+            break;
+        case ErrorCode::WORD_RANGE:
+            text = std::string(stmt.directive.name) + " value out of range [-32768, 65535]";
+            break;
+        case ErrorCode::NEGATIVE_SPACE:
+            text = std::string(stmt.directive.name) + " count cannot be negative";
+            break;
+        case ErrorCode::ORG_BACKWARDS:
+            text = ".org address is less than current address";
+            break;
+        case ErrorCode::ORG_RANGE:
+            text = ".org address is outside the 16-bit address space";
+            break;
+        case ErrorCode::DUPLICATE_LABEL:
+            text = "Duplicate label: " + std::string(f.operand);
+            break;
+        case ErrorCode::DUPLICATE_DEFINE:
+            text = "Duplicate define: " + std::string(f.operand);
+            break;
+        case ErrorCode::UNKNOWN_INSTRUCTION:
+            text = "Unknown instruction";
+            break;
+        case ErrorCode::UNSUPPORTED_FORMAT:
+            text = "Unhandled instruction format for: " + std::string(f.def->mnemonic);
+            break;
+        case ErrorCode::ADDRESS_SPACE:
+            text = "Program exceeds the 16-bit address space";
+            break;
+        case ErrorCode::NONE:
+        case ErrorCode::DUPLICATE_GLOBAL:
+        case ErrorCode::SECTION_OVERLAP:
+        case ErrorCode::TOO_MANY_ERRORS:
+            break;
+    }
+    if (f.hint) {
+        text += "\n  " + getFormatHint(f.def);
+    }
+
+    // Data directives keep their own prefix, as do .word fixups
+    const bool data = stmt.type == StatementType::DIRECTIVE && stmt.directive.name != ".define" &&
+                      stmt.directive.name != ".org";
+    return (data ? "Error encoding directive at " : "Error at ") + location(stmt.file, stmt.line) + ": " + text;
+}
+
+uint8_t Encoder::checkRegister(uint8_t reg, std::string_view text, const InstructionDef* hintDef) {
+    if (reg == NO_REGISTER) {
+        EncodeFault f(ErrorCode::INVALID_REGISTER, text);
+        f.def = hintDef;
+        f.hint = hintDef != nullptr;
+        fail(f);
+        return 0;
+    }
+    return reg;
+}
+
+static ImmediateRange signedRange(int bits) {
+    return {-(1ll << (bits - 1)), (1ll << (bits - 1)) - 1};
+}
+
+// Two's complement field of 'bits' bits holding a value of 'range', or 0
+// with an IMMEDIATE_RANGE fault
+static uint16_t immediateBits(int64_t value, int bits, ImmediateRange range, std::string_view context,
+                              EncodeFault& fault) {
+    if (value > range.maximum || value < range.minimum) {
+        fault = EncodeFault(ErrorCode::IMMEDIATE_RANGE, {}, value);
+        fault.bits = bits;
+        fault.minimum = range.minimum;
+        fault.maximum = range.maximum;
+        fault.context = context;
+        return 0;
     }
     
     if (value < 0) 
@@ -31,329 +151,1011 @@ uint16_t Encoder::encodeImmediate(int64_t value, int bits, const std::string& co
     return static_cast<uint16_t>(value & ((1 << bits) - 1));
 }
 
-int64_t Encoder::parseImmediateOrSymbol(const std::string& value, const std::string& context) {
-    try {
-        if (symbolTable.hasDefine(value)) {
-            return symbolTable.getDefineValue(value);
+uint16_t Encoder::encodeImmediate(int64_t value, int bits, std::string_view context) {
+    EncodeFault f;
+    const uint16_t encoded = immediateBits(value, bits, signedRange(bits), context, f);
+    if (f.code != ErrorCode::NONE) {
+        fail(f);
+    }
+    return encoded;
+}
+
+ErrorCode Encoder::resolveValue(NumberLiteral number, SymbolId symbol, int64_t& value) const {
+    // Symbol reference - single lookup by interned ID
+    if (symbol != NO_SYMBOL) {
+        stats.symbolLookups++;
+        const Symbol sym = symbolTable.lookup(symbol);
+        if (sym.kind == SymbolKind::UNDEFINED) {
+            return ErrorCode::UNDEFINED_SYMBOL;
         }
-        
-        std::string numStr = value;
-        // Strip # or = prefix if present
-        if (!numStr.empty() && (numStr[0] == '#' || numStr[0] == '=')) {
-            numStr = numStr.substr(1);
+        value = sym.value;
+        return ErrorCode::NONE;
+    }
+    // Literal - converted by the scanner
+    if (!number.valid) {
+        return ErrorCode::INVALID_NUMBER;
+    }
+    value = number.value;
+    return ErrorCode::NONE;
+}
+
+bool Encoder::fieldValue(FixupKind kind, const InstructionDef* def, std::string_view operand, NumberLiteral number,
+                         SymbolId symbol, int64_t& value)
+{
+    if (isLabelField(kind)) {
+        int address = 0;
+        stats.symbolLookups++;
+        if (!symbolTable.getLabelAddress(symbol, address)) {
+            fail(EncodeFault(ErrorCode::UNDEFINED_LABEL, symbolTable.getName(symbol)));
+            return false;
         }
-        
-        // Check if it's a symbol after stripping prefix
-        if (symbolTable.hasDefine(numStr)) {
-            return symbolTable.getDefineValue(numStr);
+        value = address;
+        return true;
+    }
+    const ErrorCode code = resolveValue(number, symbol, value);
+    if (code != ErrorCode::NONE) {
+        EncodeFault f(code, operand);
+        f.symbol = symbol;
+        f.kind = kind;
+        f.def = def;
+        fail(f);
+        return false;
+    }
+    return true;
+}
+
+bool Encoder::directiveValue(const DataValue& item, std::string_view context, int64_t& value) {
+    const ErrorCode code = resolveValue(item.number, item.symbol, value);
+    if (code != ErrorCode::NONE) {
+        EncodeFault f(code, item.text);
+        f.symbol = item.symbol;
+        f.context = context;
+        fail(f);
+        return false;
+    }
+    return true;
+}
+
+// Forward references - a symbol named by an operand that has no value yet
+
+bool Encoder::isPending(SymbolId symbol) const {
+    if (symbol == NO_SYMBOL) {
+        return false;
+    }
+    stats.symbolLookups++;
+    return symbolTable.lookup(symbol).kind == SymbolKind::UNDEFINED;
+}
+
+std::string fixupContext(FixupKind kind, const InstructionDef* def) {
+    switch (kind) {
+        case FixupKind::SHIFT:      return "shift amount";
+        case FixupKind::ADDRESS:    return "branch target";
+        case FixupKind::WORD:       return ".word directive";
+        case FixupKind::HIGH_BYTE:
+        case FixupKind::LOW_BYTE:
+            return def->format == InstrFormat::LABEL_LOAD ? "label load"
+                                                          : std::string(def->mnemonic) + " label immediate";
+        default:                    return std::string(def->mnemonic);
+    }
+}
+
+// Bits contributed by a resolved value - shared by direct encoding, fixups
+// and the linker
+uint16_t encodeFieldBits(FixupKind kind, const InstructionDef* def, int64_t value, int address,
+                         EncodeFault& fault)
+{
+    switch (kind) {
+        case FixupKind::BRANCH: {
+            const int64_t offset = value - (address + 1);
+            if (offset > 255 || offset < -256) {
+                fault = EncodeFault(ErrorCode::BRANCH_RANGE, {}, offset);
+                return 0;
+            }
+            return immediateBits(offset, def->immBits, signedRange(def->immBits), "branch offset", fault);
         }
-        if (symbolTable.hasLabel(numStr)) {
-            return symbolTable.getLabelAddress(numStr);
+        case FixupKind::IMMEDIATE:
+            return immediateBits(value, def->immBits, getImmediateRange(def), def->mnemonic, fault);
+
+        case FixupKind::SHORT_IMMEDIATE: {
+            int64_t maxVal = (1ll << (def->immBits - 1)) - 1;
+            int64_t minVal = -(1ll << (def->immBits - 1));
+            if (value > maxVal || value < minVal) {
+                fault = EncodeFault(ErrorCode::SHORT_IMMEDIATE_RANGE, {}, value);
+                fault.bits = def->immBits;
+                return 0;
+            }
+            return immediateBits(value, def->immBits, getImmediateRange(def), def->mnemonic, fault);
         }
-        
-        if (numStr.size() >= 2) {
-            if (numStr.substr(0, 2) == "0x" || numStr.substr(0, 2) == "0X") {
-                return std::stoll(numStr.substr(2), nullptr, 16);
+        case FixupKind::SHIFT:
+            if (value > 15 || value < 0) {
+                fault = EncodeFault(ErrorCode::SHIFT_RANGE, {}, value);
+                return 0;
             }
-            if (numStr.substr(0, 2) == "0b" || numStr.substr(0, 2) == "0B") {
-                return std::stoll(numStr.substr(2), nullptr, 2);
+            return (1 << 7) | (value & 0xF);
+
+        case FixupKind::HIGH_BYTE:
+            return (value >> 8) & 0xFF;
+
+        case FixupKind::LOW_BYTE:
+            return value & 0xFF;
+
+        case FixupKind::ADDRESS:
+            return static_cast<uint16_t>(value & 0xFFFF);
+
+        case FixupKind::WORD:
+            if (value > 0xFFFF || value < -0x8000) {
+                fault = EncodeFault(ErrorCode::WORD_RANGE, {}, value);
+                return 0;
             }
+            return static_cast<uint16_t>(value & 0xFFFF);
+    }
+    return 0;
+}
+
+std::string describeFieldFault(const EncodeFault& f) {
+    switch (f.code) {
+        case ErrorCode::IMMEDIATE_RANGE:
+            return "Immediate value " + std::to_string(f.value) + " out of range [" +
+                   std::to_string(f.minimum) + ", " + std::to_string(f.maximum) + "] for " + (!f.context.empty() ? std::string(f.context) : fixupContext(f.kind, f.def));
+        case ErrorCode::SHORT_IMMEDIATE_RANGE:
+            return "Immediate value with # must fit in " + std::to_string(f.bits) + " bits, got: " +
+                   std::to_string(f.value) + ". Use = for larger values.";
+        case ErrorCode::BRANCH_RANGE:
+            return "Branch target too far (offset " + std::to_string(f.value) + " words)";
+        case ErrorCode::SHIFT_RANGE:
+            return "Shift amount must be between 0 and 15";
+        case ErrorCode::WORD_RANGE:
+            return ".word value out of range [-32768, 65535]";
+        default:
+            return std::string();
+    }
+}
+
+uint16_t Encoder::encodeField(FixupKind kind, const InstructionDef* def, int64_t value, int address) {
+    EncodeFault f;
+    const uint16_t bits = encodeFieldBits(kind, def, value, address, f);
+    if (f.code != ErrorCode::NONE) {
+        branchOutOfRange = branchOutOfRange || f.code == ErrorCode::BRANCH_RANGE;
+        fail(f);
+    }
+    return bits;
+}
+
+void Encoder::emit(uint16_t word, SegmentKind kind) {
+    if (slice != nullptr) {
+        *slice++ = word;
+    } else if (currentAddress >= static_cast<int>(ADDRESS_SPACE_WORDS)) {
+        fail(EncodeFault(ErrorCode::ADDRESS_SPACE));
+        return;
+    } else {
+        image.emit(word, kind);
+    }
+    currentAddress++;
+}
+
+void Encoder::emitWithField(uint16_t base, FixupKind kind, const InstructionDef* def,
+                            std::string_view operand, NumberLiteral number, SymbolId symbol)
+{
+    const SegmentKind segment = (kind == FixupKind::WORD || kind == FixupKind::ADDRESS) ? SegmentKind::DATA
+                                                                                        : SegmentKind::CODE;
+
+    // Object output - the linker fills in the field
+    if (objectOutput && relocates(kind, symbol)) {
+        relocations.push_back({static_cast<uint32_t>(image.storedWords()), static_cast<uint32_t>(currentAddress),
+                               symbol, kind, def, operand, currentStatement});
+        emit(base, segment);
+        return;
+    }
+
+    // Not defined yet - emit the word without the field and patch it at the end
+    if (isPending(symbol)) {
+        fixups.push_back({static_cast<uint32_t>(image.storedWords()), static_cast<uint32_t>(currentAddress),
+                          symbol, kind, def, operand, currentStatement});
+        emit(base, segment);
+        return;
+    }
+
+    int64_t value = 0;
+    const bool resolved = fieldValue(kind, def, operand, number, symbol, value);
+    emit(base | (resolved ? encodeField(kind, def, value, currentAddress) : 0), segment);
+}
+
+// Errors found here come after every error of the pass in statement order;
+// the final sort puts them in place. A statement that already failed is
+// not reported again.
+void Encoder::resolveFixups() {
+    stats.fixups += fixups.size();
+    resolving = true;
+    for (const Fixup& fixup : fixups) {
+        if (halted) {
+            break;
+        }
+        currentStatement = fixup.stmt;
+        int64_t value = 0;
+        if (fieldValue(fixup.kind, fixup.def, fixup.operand, NO_NUMBER, fixup.symbol, value)) {
+            image.patch(fixup.index, encodeField(fixup.kind, fixup.def, value, static_cast<int>(fixup.address)));
         }
-        return std::stoll(numStr, nullptr, 0);
-    } catch (const std::exception& e) {
-        throw std::runtime_error("Failed to parse immediate value '" + value + "' for " + context + ": " + e.what());
+        if (fault.code != ErrorCode::NONE && hasError(*fixup.stmt)) {
+            fault = EncodeFault();
+        }
+        finishStatement();
     }
+    fixups.clear();
+    resolving = false;
 }
 
 // Generic encoding functions - one per instruction format
 
 void Encoder::encodeRegReg(const InstructionDef* def, uint8_t rX, uint8_t rY) {
-    machineCode.push_back(def->opcodeReg | (rX << 9) | rY);
-    currentAddress++;
+    emit(def->opcodeReg | (rX << 9) | rY);
 }
 
-void Encoder::encodeRegImm(const InstructionDef* def, uint8_t rX, int64_t imm) {
-    machineCode.push_back(def->opcodeImm | (rX << 9) | encodeImmediate(imm, def->immBits, def->mnemonic));
-    currentAddress++;
+void Encoder::encodeRegImm(const InstructionDef* def, const Instruction& instr, uint8_t rX) {
+    emitWithField(def->opcodeImm | (rX << 9), FixupKind::IMMEDIATE, def, instr.operand2, instr.number2, instr.symbol2);
 }
 
-void Encoder::encodeRegImmOrReg(const InstructionDef* def, Instruction* instr, uint8_t rX) {
+void Encoder::encodeRegImmOrReg(const InstructionDef* def, const Instruction& instr, uint8_t rX, bool shortLoad) {
+    if (shortLoad) {
+        emitWithField(mvDef->opcodeImm | (rX << 9), FixupKind::SHORT_IMMEDIATE, def,
+                      instr.operand2, instr.number2, instr.symbol2);
+        return;
+    }
+
     // Handle label immediate (=label) - generates MVT + instruction sequence
-    if (instr->isLabelImmediate) {
-        int64_t value;
-        if (symbolTable.hasLabel(instr->operand2)) {
-            value = symbolTable.getLabelAddress(instr->operand2);
-        } else if (symbolTable.hasDefine(instr->operand2)) {
-            value = symbolTable.getDefineValue(instr->operand2);
-        } else {
-            value = parseImmediateOrSymbol(instr->operand2, def->mnemonic + " label immediate");
-        }
-        
-        // For mv instruction with =label, generate MVT + ADD sequence
-        if (def->mnemonic == "mv") {
-            auto mvtDef = getInstructionDef("mvt");
-            machineCode.push_back(mvtDef->opcodeImm | (rX << 9) | ((value >> 8) & 0xFF));
-            auto addDef = getInstructionDef("add");
-            machineCode.push_back(addDef->opcodeImm | (rX << 9) | (value & 0xFF));
-            currentAddress += 2;
-        } else {
-            // For ALU ops with =label, generate MVT + op sequence
-            auto mvtDef = getInstructionDef("mvt");
-            machineCode.push_back(mvtDef->opcodeImm | (rX << 9) | ((value >> 8) & 0xFF));
-            machineCode.push_back(def->opcodeImm | (rX << 9) | (value & 0xFF));
-            currentAddress += 2;
-        }
+    if (instr.isLabelImmediate) {
+        // For mv instruction with =label, generate MVT + ADD sequence,
+        // for ALU ops with =label, generate MVT + op sequence
+        const InstructionDef* lowDef = (def == mvDef) ? addDef : def;
+        emitWithField(mvtDef->opcodeImm | (rX << 9), FixupKind::HIGH_BYTE, def,
+                      instr.operand2, instr.number2, instr.symbol2);
+        emitWithField(lowDef->opcodeImm | (rX << 9), FixupKind::LOW_BYTE, def,
+                      instr.operand2, instr.number2, instr.symbol2);
         return;
     }
     
     // Handle regular immediate (#value)
-    if (instr->isImmediate) {
-        int64_t value;
-        if (symbolTable.hasDefine(instr->operand2)) {
-            value = symbolTable.getDefineValue(instr->operand2);
-        } else {
-            value = parseImmediateOrSymbol(instr->operand2, def->mnemonic);
-        }
-        
-        int64_t maxVal = (1ll << (def->immBits - 1)) - 1;
-        int64_t minVal = -(1ll << (def->immBits - 1));
-        if (value > maxVal || value < minVal) {
-            throw std::runtime_error("Immediate value with # must fit in " + 
-                                    std::to_string(def->immBits) + " bits, got: " + 
-                                    std::to_string(value) + ". Use = for larger values.");
-        }
-        
-        encodeRegImm(def, rX, value);
+    if (instr.isImmediate) {
+        emitWithField(def->opcodeImm | (rX << 9), FixupKind::SHORT_IMMEDIATE, def,
+                      instr.operand2, instr.number2, instr.symbol2);
     } else {
         // Register operand
-        uint8_t rY = parseRegister(instr->operand2);
+        uint8_t rY = checkRegister(instr.reg2, instr.operand2, nullptr);
         encodeRegReg(def, rX, rY);
     }
 }
 
-void Encoder::encodeBranch(const InstructionDef* def, Instruction* instr) {
-    const int targetAddr = symbolTable.getLabelAddress(instr->operand1);
-    const int offset = targetAddr - (currentAddress + 1);
-    
-    if (offset > 255 || offset < -256) {
-        throw std::runtime_error("Branch target too far (offset " + std::to_string(offset) + " words)");
+void Encoder::encodeBranch(const InstructionDef* def, const Instruction& instr, bool relaxedBranch) {
+    if (instr.symbol1 == NO_SYMBOL) {
+        fail(EncodeFault(ErrorCode::UNDEFINED_LABEL, instr.operand1));
+        emit(def->opcodeReg | (def->extraData << 9));
+        return;
     }
-    
-    machineCode.push_back(def->opcodeReg | (def->extraData << 9) | encodeImmediate(offset, def->immBits, "branch offset"));
-    currentAddress++;
+    if (!relaxedBranch) {
+        emitWithField(def->opcodeReg | (def->extraData << 9), FixupKind::BRANCH, def,
+                      instr.operand1, NO_NUMBER, instr.symbol1);
+        return;
+    }
+
+    // Long form: b<inverted> over the jump, then ld pc, [pc] loads the
+    // target from the word that follows it
+    if (def->extraData != 0) {
+        const InstructionDef* inverse = getInvertedBranch(def);
+        emit(inverse->opcodeReg | (inverse->extraData << 9) | encodeImmediate(2, inverse->immBits, "branch offset"));
+    }
+    emit(ldDef->opcodeReg | (PC_REGISTER << 9) | PC_REGISTER);
+    emitWithField(0, FixupKind::ADDRESS, def, instr.operand1, NO_NUMBER, instr.symbol1);
 }
 
 void Encoder::encodeRegOnly(const InstructionDef* def, uint8_t rX) {
-    machineCode.push_back(def->opcodeReg | (rX << 9) | def->extraData);
-    currentAddress++;
+    emit(def->opcodeReg | (rX << 9) | def->extraData);
 }
 
 void Encoder::encodeRegMem(const InstructionDef* def, uint8_t rX, uint8_t rY) {
-    machineCode.push_back(def->opcodeReg | (rX << 9) | rY);
-    currentAddress++;
+    emit(def->opcodeReg | (rX << 9) | rY);
 }
 
-void Encoder::encodeShift(const InstructionDef* def, Instruction* instr, uint8_t rX) {
+void Encoder::encodeShift(const InstructionDef* def, const Instruction& instr, uint8_t rX) {
     uint8_t shiftType = def->extraData;
     uint16_t encoded = def->opcodeReg | (rX << 9) | (0b10 << 7) | (shiftType << 5);
     
-    if (instr->isImmediate) {
-        const int64_t imm = parseImmediateOrSymbol(instr->operand2, "shift amount");
-        if (imm > 15 || imm < 0) {
-            throw std::runtime_error("Shift amount must be between 0 and 15");
-        }
-        encoded |= (1 << 7) | (imm & 0xF);
+    if (instr.isImmediate) {
+        emitWithField(encoded, FixupKind::SHIFT, def, instr.operand2, instr.number2, instr.symbol2);
     } else {
-        const uint8_t rY = parseRegister(instr->operand2);
-        encoded |= rY;
+        const uint8_t rY = checkRegister(instr.reg2, instr.operand2, nullptr);
+        emit(encoded | rY);
     }
-    
-    machineCode.push_back(encoded);
-    currentAddress++;
 }
 
-void Encoder::encodeLabelLoad(Instruction* instr, uint8_t rX) {
-    int64_t value;
-    if (symbolTable.hasLabel(instr->operand2)) {
-        value = symbolTable.getLabelAddress(instr->operand2);
-    } else if (symbolTable.hasDefine(instr->operand2)) {
-        value = symbolTable.getDefineValue(instr->operand2);
-    } else {
-        value = parseImmediateOrSymbol(instr->operand2, "label load");
+void Encoder::encodeLabelLoad(const InstructionDef* def, const Instruction& instr, uint8_t rX, bool shortLoad) {
+    if (shortLoad) {
+        emitWithField(mvDef->opcodeImm | (rX << 9), FixupKind::SHORT_IMMEDIATE, def,
+                      instr.operand2, instr.number2, instr.symbol2);
+        return;
     }
-    
-    auto mvtDef = getInstructionDef("mvt");
-    auto addDef = getInstructionDef("add");
-    
-    machineCode.push_back(mvtDef->opcodeImm | (rX << 9) | ((value >> 8) & 0xFF));
-    machineCode.push_back(addDef->opcodeImm | (rX << 9) | (value & 0xFF));
-    currentAddress += 2;
+    emitWithField(mvtDef->opcodeImm | (rX << 9), FixupKind::HIGH_BYTE, def,
+                  instr.operand2, instr.number2, instr.symbol2);
+    emitWithField(addDef->opcodeImm | (rX << 9), FixupKind::LOW_BYTE, def,
+                  instr.operand2, instr.number2, instr.symbol2);
 }
 
 void Encoder::encodeNoOperand(const InstructionDef* def) {
-    machineCode.push_back(def->opcodeReg);
-    currentAddress++;
+    emit(def->opcodeReg);
 }
 
 // Main encoding dispatcher
 
-void Encoder::encodeInstruction(Instruction* instr) {
-    try {
-        const InstructionDef* def = getInstructionDef(instr->opcode);
-        if (!def) {
-            throw std::runtime_error("Unknown instruction: " + instr->opcode);
-        }
+void Encoder::encodeInstruction(const Statement& stmt) {
+    if (isRemoved(stmt)) {
+        return;
+    }
+    const Instruction& instr = stmt.instruction;
+    currentStatement = &stmt;
+    const InstructionDef* def = instr.def;
+    if (!def) {
+        fail(EncodeFault(ErrorCode::UNKNOWN_INSTRUCTION));
+        emit(0);
+        finishStatement();
+        return;
+    }
+
+    uint8_t rX = 0;
+    if (def->format != InstrFormat::BRANCH && def->format != InstrFormat::NO_OPERAND) {
+        rX = checkRegister(instr.reg1, instr.operand1, def);
+    }
 
-        if (def->format == InstrFormat::NO_OPERAND) {
+    switch (def->format) {
+        case InstrFormat::NO_OPERAND:
             encodeNoOperand(def);
-            return;
+            break;
+
+        case InstrFormat::REG_REG:
+            encodeRegReg(def, rX, checkRegister(instr.reg2, instr.operand2, def));
+            break;
+            
+        case InstrFormat::REG_IMM:
+            encodeRegImm(def, instr, rX);
+            break;
+            
+        case InstrFormat::REG_IMM_OR_REG:
+            encodeRegImmOrReg(def, instr, rX, isShortLoad(stmt));
+            break;
+            
+        case InstrFormat::BRANCH:
+            encodeBranch(def, instr, isRelaxed(stmt));
+            break;
+            
+        case InstrFormat::REG_ONLY:
+            encodeRegOnly(def, rX);
+            break;
+            
+        case InstrFormat::REG_MEM:
+            encodeRegMem(def, rX, checkRegister(instr.reg2, instr.operand2, def));
+            break;
+            
+        case InstrFormat::SHIFT:
+            encodeShift(def, instr, rX);
+            break;
+            
+        case InstrFormat::LABEL_LOAD:
+            encodeLabelLoad(def, instr, rX, isShortLoad(stmt));
+            break;
+
+        default: {
+            EncodeFault f(ErrorCode::UNSUPPORTED_FORMAT);
+            f.def = def;
+            f.hint = true;
+            fail(f);
+            emit(0);
+            break;
         }
-        
-        uint8_t rX = 0;
-        if (def->format != InstrFormat::BRANCH) {
-            try {
-                rX = parseRegister(instr->operand1);
-            } catch (const std::exception& e) {
-                throw std::runtime_error(std::string(e.what()) + "\n  " + getFormatHint(def));
+    }
+    finishStatement();
+}
+
+// Directive encoding
+
+bool Encoder::fillExtent(const Directive& dir, int64_t& count, uint16_t& word) {
+    const std::string_view context = dir.name == ".fill" ? ".fill directive" : ".space directive";
+    if (!directiveValue(dir.item(0), context, count)) {
+        return false;
+    }
+    if (count < 0) {
+        fail(EncodeFault(ErrorCode::NEGATIVE_SPACE, {}, count));
+        return false;
+    }
+    word = 0;
+    if (dir.count() > 1) {
+        int64_t value = 0;
+        if (!directiveValue(dir.item(1), context, value)) {
+            return false;
+        }
+        if (value > 0xFFFF || value < -0x8000) {
+            fail(EncodeFault(ErrorCode::WORD_RANGE, {}, value));
+            return false;
+        }
+        word = static_cast<uint16_t>(value & 0xFFFF);
+    }
+    return true;
+}
+
+// Little-endian 16-bit words, an odd last byte is the low byte of a word -
+// the same layout as the bin output format. Copied into the image as one
+// extent.
+void Encoder::emitBytes(std::string_view bytes) {
+    const size_t count = (bytes.size() + 1) / 2;
+    if (static_cast<size_t>(currentAddress) + count > ADDRESS_SPACE_WORDS) {
+        fail(EncodeFault(ErrorCode::ADDRESS_SPACE, {}, static_cast<int64_t>(count)));
+        return;
+    }
+    uint16_t* out = slice;
+    if (slice != nullptr) {
+        slice += count;
+    } else {
+        const size_t index = image.append(static_cast<uint32_t>(count), SegmentKind::DATA);
+        out = image.storage() + index;
+    }
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(bytes.data());
+    const size_t pairs = bytes.size() / 2;
+    for (size_t i = 0; i < pairs; i++) {
+        out[i] = static_cast<uint16_t>(in[2 * i] | (in[2 * i + 1] << 8));
+    }
+    if (bytes.size() % 2 != 0) {
+        out[pairs] = in[bytes.size() - 1];
+    }
+    currentAddress += static_cast<int>(count);
+}
+
+void Encoder::encodeDirective(const Statement& stmt) {
+    const Directive& dir = stmt.directive;
+    currentStatement = &stmt;
+    if (dir.name == ".word") {
+        for (size_t i = 0; i < dir.count(); i++) {
+            const DataValue item = dir.item(i);
+            emitWithField(0, FixupKind::WORD, nullptr, item.text, item.number, item.symbol);
+        }
+    } 
+    else if (dir.name == ".space" || dir.name == ".fill") {
+        int64_t count = 0;
+        uint16_t word = 0;
+        if (fillExtent(dir, count, word)) {
+            if (currentAddress + count > static_cast<int64_t>(ADDRESS_SPACE_WORDS)) {
+                fail(EncodeFault(ErrorCode::ADDRESS_SPACE, {}, count));
+            } else {
+                if (slice == nullptr) {
+                    image.fill(static_cast<uint64_t>(count), word);
+                }
+                currentAddress += static_cast<int>(count);
             }
         }
+    }
+    else if (dir.name == ".incbin") {
+        emitBytes(dir.value);
+    }
+    else if (dir.name == ".ascii" || dir.name == ".asciiz") {
+        // Emit each character as a 16-bit word
+        std::string_view str = dir.value;
+        for (char c : str) {
+            emit(static_cast<uint16_t>(static_cast<uint8_t>(c)), SegmentKind::DATA);
+        }
+        // Add null terminator for .asciiz
+        if (dir.name == ".asciiz") {
+            emit(0x0000, SegmentKind::DATA);
+        }
+    }
+    finishStatement();
+}
+
+// Labels, .define and .org - handled in order by both the serial pass and
+// the layout pass
+
+bool Encoder::defineStatement(const Statement& stmt) {
+    currentStatement = &stmt;
+    if (stmt.type == StatementType::LABEL) {
+        if (!symbolTable.addLabel(stmt.label.symbol, currentAddress)) {
+            fail(EncodeFault(ErrorCode::DUPLICATE_LABEL, stmt.label.name));
+        }
+        return true;
+    }
+    if (stmt.type != StatementType::DIRECTIVE) {
+        return false;
+    }
+
+    const Directive& dir = stmt.directive;
+    if (dir.name == ".define") {
+        int64_t value = 0;
+        if (directiveValue(DataValue{dir.value, dir.number, NO_SYMBOL}, ".define directive", value) &&
+            !symbolTable.addDefine(dir.labelSymbol, static_cast<int>(value))) {
+            fail(EncodeFault(ErrorCode::DUPLICATE_DEFINE, dir.label));
+        }
+        return true;
+    }
+    if (dir.name == ".org") {
+        // .org directive - a zero fill segment up to the target address
+        int64_t targetAddr = 0;
+        if (!directiveValue(dir.item(0), ".org directive", targetAddr)) {
+            return true;
+        }
+        if (targetAddr < currentAddress) {
+            fail(EncodeFault(ErrorCode::ORG_BACKWARDS, {}, targetAddr));
+            return true;
+        }
+        if (targetAddr > static_cast<int64_t>(ADDRESS_SPACE_WORDS)) {
+            fail(EncodeFault(ErrorCode::ORG_RANGE, {}, targetAddr));
+            return true;
+        }
         
-        switch (def->format) {
-            case InstrFormat::REG_REG:
-                try {
-                    encodeRegReg(def, rX, parseRegister(instr->operand2));
-                } catch (const std::exception& e) {
-                    throw std::runtime_error(std::string(e.what()) + "\n  " + getFormatHint(def));
-                }
-                break;
-                
-            case InstrFormat::REG_IMM:
-                encodeRegImm(def, rX, parseImmediateOrSymbol(instr->operand2, def->mnemonic));
-                break;
-                
-            case InstrFormat::REG_IMM_OR_REG:
-                encodeRegImmOrReg(def, instr, rX);
-                break;
-                
-            case InstrFormat::BRANCH:
-                encodeBranch(def, instr);
-                break;
-                
-            case InstrFormat::REG_ONLY:
-                encodeRegOnly(def, rX);
-                break;
-                
-            case InstrFormat::REG_MEM:
-                try {
-                    encodeRegMem(def, rX, parseRegister(instr->operand2));
-                } catch (const std::exception& e) {
-                    throw std::runtime_error(std::string(e.what()) + "\n  " + getFormatHint(def));
-                }
-                break;
-                
-            case InstrFormat::SHIFT:
-                encodeShift(def, instr, rX);
-                break;
-                
-            case InstrFormat::LABEL_LOAD:
-                encodeLabelLoad(instr, rX);
-                break;
-                
-            default:
-                throw std::runtime_error("Unhandled instruction format for: " + instr->opcode + 
-                                        "\n  " + getFormatHint(def));
+        if (objectOutput) {
+            image.skipTo(static_cast<uint32_t>(targetAddr));    // The linker fills the gap
+        } else {
+            image.advanceTo(static_cast<uint64_t>(targetAddr));
         }
-    } catch (const std::exception& e) {
-        throw std::runtime_error("Error at line " + std::to_string(instr->line) + ": " + e.what());
+        currentAddress = static_cast<int>(targetAddr);
+        return true;
     }
+    return false;
 }
 
-// Directive encoding
+size_t Encoder::countExpandedInstructions(const ProgramAST& ast) const {
+    size_t count = 0;
+    for (const Statement& stmt : ast) {
+        count += stmt.type == StatementType::INSTRUCTION && instructionSize(stmt) > 1;
+    }
+    return count;
+}
 
-void Encoder::encodeDirective(Directive* dir) {
-    try {
-        if (dir->name == ".word") {
-            int64_t value = parseImmediateOrSymbol(dir->value, ".word directive");
-            if (value > 0xFFFF || value < -0x8000) {
-                throw std::runtime_error(".word value out of range [-32768, 65535]");
+int Encoder::instructionSize(const Statement& stmt) const {
+    const Instruction& instr = stmt.instruction;
+    if (instr.def == nullptr) {
+        return 1;
+    }
+    if (isRemoved(stmt)) {
+        return 0;
+    }
+    if (instr.def->format == InstrFormat::LABEL_LOAD ||
+        (instr.def->format == InstrFormat::REG_IMM_OR_REG && instr.isLabelImmediate)) {
+        return isShortLoad(stmt) ? 1 : 2;   // mv #value, or MVT + ADD/op
+    }
+    if (instr.def->format == InstrFormat::BRANCH && isRelaxed(stmt)) {
+        return instr.def->extraData == 0 ? 2 : 3;   // [inverted branch] + ld pc, [pc] + target
+    }
+    return 1;
+}
+
+uint32_t Encoder::statementSize(const Statement& stmt, SegmentKind& kind, uint16_t& fill) {
+    if (stmt.type == StatementType::INSTRUCTION) {
+        kind = SegmentKind::CODE;
+        return static_cast<uint32_t>(instructionSize(stmt));
+    }
+
+    kind = SegmentKind::DATA;
+    const Directive& dir = stmt.directive;
+    if (dir.name == ".word") {
+        return static_cast<uint32_t>(dir.count());
+    }
+    if (dir.name == ".ascii" || dir.name == ".asciiz") {
+        return static_cast<uint32_t>(dir.value.size()) + (dir.name == ".asciiz" ? 1 : 0);
+    }
+    if (dir.name == ".incbin") {
+        return static_cast<uint32_t>(std::min<size_t>((dir.value.size() + 1) / 2, ADDRESS_SPACE_WORDS + 1));
+    }
+    if (dir.name == ".space" || dir.name == ".fill") {
+        currentStatement = &stmt;
+        int64_t count = 0;
+        if (!fillExtent(dir, count, fill)) {
+            return 0;
+        }
+        kind = SegmentKind::FILL;
+        return static_cast<uint32_t>(std::min<int64_t>(count, ADDRESS_SPACE_WORDS + 1));
+    }
+    return 0;
+}
+
+// Layout optimization - two choices depend on where labels end up:
+//  - branches whose target is out of the 9-bit range are rewritten as an
+//    inverted short branch over an absolute jump
+//  - mv rX, =value is encoded as a single mv rX, #value when the value fits
+// Both change the size of a statement and so move everything after it. All
+// loads start short, and a change only ever grows a statement (a short load
+// back to two words, a branch to its long form), so repeating the layout
+// until nothing changes reaches a fixed point. Statements dropped by the
+// peephole optimizer take no words in any layout.
+
+// Largest =value encoded as #value. Values up to 255 mean the same whether
+// the 9-bit immediate is sign or zero extended.
+constexpr int64_t SHORT_LOAD_MAX = 255;
+
+bool Encoder::isRelaxable(const InstructionDef* def) {
+    return def != nullptr && def->format == InstrFormat::BRANCH && (def->extraData == 0 || getInvertedBranch(def) != nullptr);
+}
+
+bool Encoder::isShrinkable(const Instruction& instr) const {
+    // ALU ops with =value are left alone - their MVT + op pair does not
+    // compute 'rX op value', so a one-word op would change the result
+    return instr.def != nullptr &&
+           (instr.def->format == InstrFormat::LABEL_LOAD || (instr.def == mvDef && instr.isLabelImmediate));
+}
+
+uint8_t Encoder::statementForm(const Statement& stmt) const {
+    return formFlags != nullptr ? formFlags[&stmt - &(*program)[0]] : 0;
+}
+
+bool Encoder::seedForms(const ProgramAST& ast) {
+    forms.assign(ast.size(), 0);
+    bool any = false;
+    if (optimizing) {
+        std::vector<char> removed;
+        rewrites = findPeepholeRewrites(ast, removed);
+        for (size_t i = 0; i < ast.size(); i++) {
+            forms[i] = removed[i] ? FORM_REMOVED : 0;
+        }
+        any = !rewrites.empty();
+    }
+    for (size_t i = 0; shrinking && i < ast.size(); i++) {
+        if (!forms[i] && ast[i].type == StatementType::INSTRUCTION && isShrinkable(ast[i].instruction)) {
+            forms[i] = FORM_SHORT_LOAD;
+            any = true;
+        }
+    }
+    // Branches to other modules may end up anywhere - long form up front
+    for (size_t i = 0; objectOutput && relaxation && i < ast.size(); i++) {
+        const Instruction& instr = ast[i].instruction;
+        if (!forms[i] && ast[i].type == StatementType::INSTRUCTION && isRelaxable(instr.def) &&
+            relocates(FixupKind::BRANCH, instr.symbol1)) {
+            forms[i] = FORM_LONG_BRANCH;
+            any = true;
+        }
+    }
+    formFlags = forms.data();
+    return any;
+}
+
+bool Encoder::settleLayout(const ProgramAST& ast) {
+    ScopedTimer timer(stats.layoutNanos);
+    if (forms.size() != ast.size()) {
+        forms.assign(ast.size(), 0);
+    }
+    formFlags = forms.data();
+
+    std::vector<int> addresses(ast.size());
+    bool grown = false;
+    for (;;) {
+        stats.layoutPasses++;
+        symbolTable.clear();
+        image.clear();
+        currentAddress = 0;
+        for (size_t i = 0; i < ast.size(); i++) {
+            addresses[i] = currentAddress;
+            if (!defineStatement(ast[i])) {
+                SegmentKind kind;
+                uint16_t fill = 0;
+                currentAddress += static_cast<int>(statementSize(ast[i], kind, fill));
+            }
+            if (fault.code != ErrorCode::NONE || currentAddress > static_cast<int>(ADDRESS_SPACE_WORDS)) {
+                // Left for the encode to report
+                fault = EncodeFault();
+                dropForms();
+                symbolTable.clear();
+                image.clear();
+                currentAddress = 0;
+                return false;
+            }
+        }
+
+        bool changed = false;
+        for (size_t i = 0; i < ast.size(); i++) {
+            const Statement& stmt = ast[i];
+            if (stmt.type != StatementType::INSTRUCTION || (forms[i] & FORM_REMOVED)) {
+                continue;
             }
-            machineCode.push_back(static_cast<uint16_t>(value & 0xFFFF));
-            currentAddress++;
-        } 
-        else if (dir->name == ".space") {
-            int64_t count = parseImmediateOrSymbol(dir->value, ".space directive");
-            if (count < 0) {
-                throw std::runtime_error(".space count cannot be negative");
+            const Instruction& instr = stmt.instruction;
+
+            if (forms[i] & FORM_SHORT_LOAD) {
+                // Undefined symbols keep the two-word form, which reports
+                // them, as do values only the linker knows
+                bool fits = false;
+                int64_t value = 0;
+                if (!isPending(instr.symbol2) && !relocates(FixupKind::SHORT_IMMEDIATE, instr.symbol2) &&
+                    resolveValue(instr.number2, instr.symbol2, value) == ErrorCode::NONE) {
+                    fits = value >= 0 && value <= SHORT_LOAD_MAX;
+                }
+                if (!fits) {
+                    forms[i] &= ~FORM_SHORT_LOAD;
+                    changed = true;
+                }
             }
-            for (int64_t i = 0; i < count; i++) {
-                machineCode.push_back(0x0000);
-                currentAddress++;
+
+            if (relaxation && !(forms[i] & FORM_LONG_BRANCH) && isRelaxable(instr.def)) {
+                stats.symbolLookups++;
+                const Symbol target = symbolTable.lookup(instr.symbol1);
+                const int offset = target.value - (addresses[i] + 1);
+                if (target.kind == SymbolKind::LABEL && (offset > 255 || offset < -256)) {
+                    forms[i] |= FORM_LONG_BRANCH;
+                    changed = true;
+                }
             }
         }
-        else if (dir->name == ".ascii" || dir->name == ".asciiz") {
-            // Emit each character as a 16-bit word
-            const std::string& str = dir->value;
-            for (char c : str) {
-                machineCode.push_back(static_cast<uint16_t>(static_cast<uint8_t>(c)));
-                currentAddress++;
+        if (!changed) {
+            break;
+        }
+        grown = true;
+    }
+
+    relaxedCount = 0;
+    shortLoadCount = 0;
+    for (uint8_t form : forms) {
+        relaxedCount += (form & FORM_LONG_BRANCH) != 0;
+        shortLoadCount += (form & FORM_SHORT_LOAD) != 0;
+    }
+
+    symbolTable.clear();
+    image.clear();
+    currentAddress = 0;
+    return grown;
+}
+
+// Serial encode - a single pass over the AST. Labels are defined as they
+// are reached, forward references are patched once the pass is done.
+// Failed statements are reported and skipped; the pass only stops early
+// at the end of the address space. It runs on past the error limit, as
+// forward references of earlier statements need the labels after it.
+
+void Encoder::encodeSerial(const ProgramAST& ast) {
+    stats.encodePasses++;
+    for (const Statement& stmt : ast) {
+        if (halted) {
+            return;
+        }
+        if (recordAddresses) {
+            statementAddresses.push_back(static_cast<uint32_t>(currentAddress));
+        }
+        if (defineStatement(stmt)) {
+            finishStatement();
+            continue;
+        }
+        if (stmt.type == StatementType::INSTRUCTION) {
+            encodeInstruction(stmt);
+        } else {
+            encodeDirective(stmt);
+        }
+    }
+    if (recordAddresses) {
+        statementAddresses.push_back(static_cast<uint32_t>(currentAddress));
+    }
+    resolveFixups();
+}
+
+// Layout pass - defines every symbol and reserves the words of each
+// statement in the image, so chunks know their addresses and slices.
+// Returns false on any error; the serial pass then reports it.
+
+bool Encoder::layout(const ProgramAST& ast, std::vector<EncodeChunk>& chunks) {
+    for (size_t i = 0; i < ast.size(); i++) {
+        if (i % PARALLEL_ENCODE_CHUNK_STATEMENTS == 0) {
+            if (!chunks.empty()) {
+                chunks.back().last = i;
             }
-            // Add null terminator for .asciiz
-            if (dir->name == ".asciiz") {
-                machineCode.push_back(0x0000);
-                currentAddress++;
+            chunks.push_back({i, ast.size(), currentAddress, image.storedWords()});
+        }
+
+        const Statement& stmt = ast[i];
+        if (recordAddresses) {
+            statementAddresses.push_back(static_cast<uint32_t>(currentAddress));
+        }
+        if (defineStatement(stmt)) {
+            if (fault.code != ErrorCode::NONE) {
+                return false;
             }
+            continue;
+        }
+
+        SegmentKind kind;
+        uint16_t fill = 0;
+        const uint32_t count = statementSize(stmt, kind, fill);
+        if (fault.code != ErrorCode::NONE || currentAddress + count > ADDRESS_SPACE_WORDS) {
+            return false;
         }
-    } catch (const std::exception& e) {
-        throw std::runtime_error("Error encoding directive at line " + 
-                                std::to_string(dir->line) + ": " + e.what());
+        if (kind == SegmentKind::FILL) {
+            image.fill(count, fill);
+        } else if (stmt.type == StatementType::INSTRUCTION && isRelaxed(stmt)) {
+            // The jump target of a long branch is a data word, as in the serial pass
+            image.append(count - 1, SegmentKind::CODE);
+            image.append(1, SegmentKind::DATA);
+        } else {
+            image.append(count, kind);
+        }
+        currentAddress += static_cast<int>(count);
     }
+    if (recordAddresses) {
+        statementAddresses.push_back(static_cast<uint32_t>(currentAddress));
+    }
+    return true;
 }
 
-// Main encode function
+// Encode one chunk into its reserved words. Every symbol is defined by the
+// layout pass, so a pending fixup means the symbol is undefined.
 
-std::vector<uint16_t> Encoder::encode(const std::vector<std::unique_ptr<Statement>>& ast) {
-    machineCode.clear();
-    currentAddress = 0;
-    
-    for (const auto& stmt : ast) {
-        switch (stmt->type) {
-            case StatementType::DIRECTIVE: {
-                auto dir = static_cast<Directive*>(stmt.get());
-                if (dir->name == ".org") {
-                    // .org directive - pad with zeros to reach target address
-                    int64_t targetAddr = 0;
-                    std::string valStr = dir->value;
-                    
-                    if (valStr.size() >= 2 && (valStr.substr(0, 2) == "0x" || valStr.substr(0, 2) == "0X")) {
-                        targetAddr = std::stoll(valStr.substr(2), nullptr, 16);
-                    } else if (valStr.size() >= 2 && (valStr.substr(0, 2) == "0b" || valStr.substr(0, 2) == "0B")) {
-                        targetAddr = std::stoll(valStr.substr(2), nullptr, 2);
-                    } else {
-                        targetAddr = std::stoll(valStr, nullptr, 0);
-                    }
-                    
-                    if (targetAddr < currentAddress) {
-                        throw std::runtime_error("Error at line " + std::to_string(dir->line) + 
-                                                ": .org address 0x" + std::to_string(targetAddr) + 
-                                                " is less than current address 0x" + std::to_string(currentAddress));
-                    }
-                    
-                    while (currentAddress < targetAddr) {
-                        machineCode.push_back(0x0000);
-                        currentAddress++;
-                    }
-                } else if (dir->name != ".define") {
-                    // .define is handled in first pass, skip here
-                    encodeDirective(dir);
+bool Encoder::encodeChunk(const ProgramAST& ast, const EncodeChunk& chunk, uint16_t* words) {
+    program = &ast;
+    slice = words;
+    currentAddress = chunk.address;
+    for (size_t i = chunk.first; i < chunk.last && errors.empty(); i++) {
+        const Statement& stmt = ast[i];
+        if (stmt.type == StatementType::INSTRUCTION) {
+            encodeInstruction(stmt);
+        } else if (stmt.type == StatementType::DIRECTIVE) {
+            const Directive& dir = stmt.directive;
+            if (dir.name == ".org") {
+                int64_t address = 0;
+                if (!directiveValue(dir.item(0), ".org directive", address)) {
+                    return false;
                 }
-                break;
+                currentAddress = static_cast<int>(address);
+            } else if (dir.name != ".define") {
+                encodeDirective(stmt);
             }
-            case StatementType::INSTRUCTION:
-                encodeInstruction(static_cast<Instruction*>(stmt.get()));
-                break;
-            default:
-                break;
         }
     }
-    return machineCode;
-}
\ No newline at end of file
+    return errors.empty() && fixups.empty();
+}
+
+bool Encoder::encodeParallel(const ProgramAST& ast, unsigned threads) {
+    std::vector<EncodeChunk> chunks;
+    {
+        ScopedTimer timer(stats.layoutNanos);
+        stats.layoutPasses++;
+        if (!layout(ast, chunks)) {
+            return false;
+        }
+    }
+
+    stats.encodePasses++;
+    uint16_t* words = image.storage();
+    std::vector<char> ok(chunks.size(), 0);
+    std::vector<size_t> lookups(chunks.size(), 0);
+    parallelFor(chunks.size(), threads, [&](size_t i) {
+        Encoder worker(symbolTable);
+        worker.formFlags = formFlags;
+        ok[i] = worker.encodeChunk(ast, chunks[i], words + chunks[i].index);
+        lookups[i] = worker.stats.symbolLookups;
+    });
+
+    bool encoded = true;
+    for (size_t i = 0; i < chunks.size(); i++) {
+        stats.symbolLookups += lookups[i];
+        encoded = encoded && ok[i];
+    }
+    return encoded;
+}
+
+void Encoder::reset() {
+    symbolTable.clear();
+    image.clear();
+    fixups.clear();
+    relocations.clear();
+    statementAddresses.clear();
+    errors.clear();
+    fault = EncodeFault();
+    halted = false;
+    resolving = false;
+    truncated = false;
+    currentAddress = 0;
+    branchOutOfRange = false;
+}
+
+bool Encoder::encodeOnce(const ProgramAST& ast, unsigned threads) {
+    if (threads != 1 && ast.size() >= PARALLEL_ENCODE_MIN_STATEMENTS) {
+        if (encodeParallel(ast, threads)) {
+            return true;
+        }
+        reset();
+    }
+    encodeSerial(ast);
+    return errors.empty() || !relaxation || !branchOutOfRange;
+}
+
+// Object output - a symbol the module never defines is imported from
+// another module. Defined symbols keep the kind of their first definition.
+
+void Encoder::scanModule(const ProgramAST& ast) {
+    moduleKinds.clear();
+    absoluteModule = false;
+    const auto define = [this](SymbolId id, SymbolKind kind) {
+        if (id < 0) {
+            return;
+        }
+        if (static_cast<size_t>(id) >= moduleKinds.size()) {
+            moduleKinds.resize(static_cast<size_t>(id) + 1, SymbolKind::UNDEFINED);
+        }
+        if (moduleKinds[id] == SymbolKind::UNDEFINED) {
+            moduleKinds[id] = kind;
+        }
+    };
+    for (const Statement& stmt : ast) {
+        if (stmt.type == StatementType::LABEL) {
+            define(stmt.label.symbol, SymbolKind::LABEL);
+        } else if (stmt.type == StatementType::DIRECTIVE) {
+            if (stmt.directive.name == ".define") {
+                define(stmt.directive.labelSymbol, SymbolKind::DEFINE);
+            } else if (stmt.directive.name == ".org") {
+                absoluteModule = true;
+            }
+        }
+    }
+}
+
+bool Encoder::relocates(FixupKind kind, SymbolId symbol) const {
+    if (!objectOutput || symbol == NO_SYMBOL) {
+        return false;
+    }
+    const SymbolKind defined = static_cast<size_t>(symbol) < moduleKinds.size() ? moduleKinds[symbol]
+                                                                                : SymbolKind::UNDEFINED;
+    // Labels of a relocatable module move with it, branch offsets between
+    // them do not
+    return defined == SymbolKind::UNDEFINED ||
+           (defined == SymbolKind::LABEL && !absoluteModule && kind != FixupKind::BRANCH);
+}
+
+// Clear the layout choices - every statement in its default form
+void Encoder::dropForms() {
+    forms.clear();
+    formFlags = nullptr;
+    relaxedCount = 0;
+    shortLoadCount = 0;
+    rewrites.clear();
+}
+
+// Main encode function. The parallel path only commits a result when every
+// chunk encoded cleanly; otherwise the program is encoded again serially,
+// which reports the errors exactly as a serial run would. Programs
+// without =value loads or peephole drops whose branches all fit are
+// encoded in one pass - the layout only runs up front when a statement
+// changed form, and after a branch was found out of range. A layout that
+// fails (on an error the encode reports) leaves every statement in its
+// default form.
+
+bool Encoder::encode(const ProgramAST& ast, std::vector<Diagnostic>& diagnostics, unsigned threads) {
+    stats = EncodeStats();
+    ScopedTimer timer(stats.totalNanos);
+    program = &ast;
+    dropForms();
+    reset();
+    if (objectOutput) {
+        scanModule(ast);
+        threads = 1;    // Relocations are recorded by the serial pass only
+    }
+
+    if (seedForms(ast)) {
+        settleLayout(ast);
+        reset();
+    }
+
+    while (!encodeOnce(ast, threads)) {
+        const bool grown = settleLayout(ast);
+        reset();
+        if (!grown) {
+            // Nothing left to relax (bl) - encoding again reports the errors
+            encodeSerial(ast);
+            break;
+        }
+    }
+
+    // Fixup errors were found after the pass - report the first maxErrors
+    // in statement order
+    std::stable_sort(errors.begin(), errors.end(),
+                     [](const std::pair<size_t, Diagnostic>& a, const std::pair<size_t, Diagnostic>& b) {
+                         return a.first < b.first;
+                     });
+    if (maxErrors != 0 && errors.size() > maxErrors) {
+        errors.erase(errors.begin() + static_cast<std::ptrdiff_t>(maxErrors), errors.end());
+        truncated = true;
+    }
+    for (std::pair<size_t, Diagnostic>& error : errors) {
+        diagnostics.push_back(std::move(error.second));
+    }
+    if (truncated) {
+        diagnostics.push_back({DiagnosticKind::ASSEMBLY, 0, 0,
+                               "Too many errors, stopped after " + std::to_string(errors.size()), 0,
+                               ErrorCode::TOO_MANY_ERRORS});
+    }
+    return errors.empty();
+}
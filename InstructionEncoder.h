@@ -10,42 +10,343 @@
 #include "SymbolTable.h"
 #include "InstructionDef.h"
 #include "ast.h"
+#include "MemoryImage.h"
+#include "Peephole.h"
+#include "Diagnostics.h"
+
+// Field of an emitted word that depends on a symbol value. Words that name a
+// symbol before it is defined are emitted with the field cleared and patched
+// when the pass is done.
+enum class FixupKind : uint8_t {
+    BRANCH,             // PC-relative offset of a branch
+    IMMEDIATE,          // Immediate field of a REG_IMM instruction (mvt)
+    SHORT_IMMEDIATE,    // #symbol of a REG_IMM_OR_REG instruction
+    SHIFT,              // #symbol shift amount
+    HIGH_BYTE,          // Top byte of an =symbol load (MVT word)
+    LOW_BYTE,           // Bottom byte of an =symbol load (ADD or ALU word)
+    WORD,               // .word symbol
+    ADDRESS             // Absolute target word of a relaxed branch
+};
+
+// Fields whose symbol must be a label
+inline bool isLabelField(FixupKind kind) {
+    return kind == FixupKind::BRANCH || kind == FixupKind::ADDRESS;
+}
+
+// An encoding error as recorded on the hot path. The message is only built
+// from it when the statement is reported.
+struct EncodeFault {
+    ErrorCode code = ErrorCode::NONE;
+    std::string_view operand;               // Offending operand or name
+    int64_t value = 0;                      // Offending value
+    int bits = 0;                           // Field width of a range error
+    int64_t minimum = 0;                    // Accepted values of an IMMEDIATE_RANGE error
+    int64_t maximum = 0;
+    SymbolId symbol = NO_SYMBOL;            // Undefined symbol
+    std::string_view context;               // What was encoded, empty: from 'kind' and 'def'
+    FixupKind kind = FixupKind::WORD;
+    const InstructionDef* def = nullptr;
+    bool hint = false;                      // Append the operand format of 'def'
+
+    EncodeFault() = default;
+    EncodeFault(ErrorCode c, std::string_view text = {}, int64_t v = 0) : code(c), operand(text), value(v) {}
+};
+
+// Context used in error messages for a symbol-dependent field
+std::string fixupContext(FixupKind kind, const InstructionDef* def);
+
+// Range check a value and return the bits it contributes to a field of the
+// word at 'address'. A value that does not fit returns 0 and sets 'fault'.
+// Shared by the encoder and the linker (relocations).
+uint16_t encodeFieldBits(FixupKind kind, const InstructionDef* def, int64_t value, int address,
+                         EncodeFault& fault);
+
+// Message text of a fault set by encodeFieldBits()
+std::string describeFieldFault(const EncodeFault& f);
+
+// Programs with fewer statements are always encoded serially - below this
+// the thread start-up costs more than the encoding
+constexpr size_t PARALLEL_ENCODE_MIN_STATEMENTS = 8192;
+
+// Statements per chunk of the parallel encode
+constexpr size_t PARALLEL_ENCODE_CHUNK_STATEMENTS = 2048;
+
+// A run of statements whose words have been reserved by the layout pass
+struct EncodeChunk {
+    size_t first;           // First statement index
+    size_t last;            // One past the last statement index
+    int address;            // Address of the first statement
+    size_t index;           // Backing index of the first reserved word
+};
+
+struct Fixup {
+    uint32_t index;                 // Word index in the image's backing store
+    uint32_t address;               // Word address
+    SymbolId symbol;
+    FixupKind kind;
+    const InstructionDef* def;      // Instruction for range checks, nullptr for .word
+    std::string_view operand;       // Operand text for error messages
+    const Statement* stmt;          // For the location of errors
+};
+
+// Work done by the last encode() (--stats)
+struct EncodeStats {
+    uint64_t totalNanos = 0;        // All of encode(), layout included
+    uint64_t layoutNanos = 0;       // Layout passes: sizes and label addresses only
+    size_t layoutPasses = 0;
+    size_t encodePasses = 0;        // Serial passes and parallel encodes
+    size_t symbolLookups = 0;       // Symbol table reads, workers included
+    size_t fixups = 0;              // Forward references patched after a pass
+};
 
 class Encoder {
 private:
     SymbolTable& symbolTable;
-    std::vector<uint16_t> machineCode;
+    MemoryImage image;
+    std::vector<Fixup> fixups;
     int currentAddress;
+    const Statement* currentStatement = nullptr;
+    const ProgramAST* program = nullptr;    // For file names in error messages
+    uint16_t* slice = nullptr;      // Parallel encode: words are written here instead of appended
+
+    // Encoding chosen for a statement by the layout fixed point
+    enum StatementForm : uint8_t {
+        FORM_LONG_BRANCH = 1 << 0,      // Branch rewritten into long form
+        FORM_SHORT_LOAD  = 1 << 1,      // mv rX, =value encoded as mv rX, #value
+        FORM_REMOVED     = 1 << 2       // Dropped by the peephole optimizer
+    };
+
+    // Layout optimization state
+    bool relaxation = true;             // Relax out-of-range branches instead of failing
+    bool shrinking = true;              // Encode =value loads that fit in one word
+    bool optimizing = false;            // Run the peephole optimizer
+    bool branchOutOfRange = false;      // Set when a branch offset did not fit
+    std::vector<uint8_t> forms;         // Per statement: StatementForm bits
+    const uint8_t* formFlags = nullptr; // forms.data() once a layout ran (shared with workers)
+    size_t relaxedCount = 0;
+    size_t shortLoadCount = 0;
+    std::vector<PeepholeRewrite> rewrites;
+    mutable EncodeStats stats;
+
+    // Object output (-c). Fields that depend on where the linker places the
+    // module or on a symbol of another module are emitted cleared and
+    // recorded as relocations.
+    bool objectOutput = false;
+    bool absoluteModule = false;        // Uses .org - its labels are final addresses
+    std::vector<SymbolKind> moduleKinds;    // Per symbol: defined as, UNDEFINED = imported
+    std::vector<Fixup> relocations;
+
+    // Listing (-l): the address of every statement, recorded by the pass
+    // that produces the image
+    bool recordAddresses = false;
+    std::vector<uint32_t> statementAddresses;
+
+    // Find the imports and whether the module is absolute
+    void scanModule(const ProgramAST& ast);
+
+    // True if a field of 'kind' naming 'symbol' is left to the linker
+    bool relocates(FixupKind kind, SymbolId symbol) const;          // resolveValue() is const but counts lookups
+
+    // Error state. Helpers record the first fault of a statement and go on
+    // with a zero field, so a failed statement keeps its size and the
+    // addresses after it stay right.
+    EncodeFault fault;
+    std::vector<std::pair<size_t, Diagnostic>> errors;    // By statement index
+    size_t maxErrors = DEFAULT_MAX_ERRORS;                 // 0 = no limit
+    bool halted = false;                // Address space full - the pass stops
+    bool resolving = false;             // In resolveFixups(), errors out of statement order
+    bool truncated = false;             // Errors past maxErrors were dropped
 
-    // Parse register name to register number
-    uint8_t parseRegister(const std::string& reg);
+    // Definitions used by =label expansion, resolved once per Encoder
+    const InstructionDef* mvDef;
+    const InstructionDef* mvtDef;
+    const InstructionDef* addDef;
+    const InstructionDef* ldDef;
+
+    // "line N" for the main source, "line N of FILE" for included files
+    std::string location(uint16_t file, int line) const;
+
+    // Record 'f' unless the statement already failed
+    void fail(const EncodeFault& f);
+
+    // Report the fault of the current statement, if any, and clear it.
+    // Pass errors arrive in statement order, so one past the limit is
+    // dropped; fixup errors are kept until the final sort.
+    void finishStatement();
+
+    // Message text of a fault at 'stmt'
+    std::string describe(const Statement& stmt, const EncodeFault& f) const;
+
+    // Validate a register number resolved at parse time. Invalid registers
+    // fail with the operand format of 'hintDef' (nullptr: no hint).
+    uint8_t checkRegister(uint8_t reg, std::string_view text, const InstructionDef* hintDef);
     
     // Encode immediate value with range checking
-    uint16_t encodeImmediate(int64_t value, int bits, const std::string& context);
+    uint16_t encodeImmediate(int64_t value, int bits, std::string_view context);
     
-    // Parse immediate value or symbol reference
-    int64_t parseImmediateOrSymbol(const std::string& value, const std::string& context);
+    // Value of a number literal or interned symbol reference - no fault is
+    // recorded, the layout passes probe values with it
+    ErrorCode resolveValue(NumberLiteral number, SymbolId symbol, int64_t& value) const;
+
+    // resolveValue() for a field or a directive, recording a fault on failure
+    bool fieldValue(FixupKind kind, const InstructionDef* def, std::string_view operand, NumberLiteral number,
+                    SymbolId symbol, int64_t& value);
+    bool directiveValue(const DataValue& item, std::string_view context, int64_t& value);
+
+    // True if 'symbol' names a symbol that has no value yet (forward reference)
+    bool isPending(SymbolId symbol) const;
+
+    // encodeFieldBits(), recording a fault on failure
+    uint16_t encodeField(FixupKind kind, const InstructionDef* def, int64_t value, int address);
+
+    // Append one word to the image at currentAddress
+    void emit(uint16_t word, SegmentKind kind = SegmentKind::CODE);
+
+    // Append 'base' with its symbol-dependent field, or record a fixup for it
+    void emitWithField(uint16_t base, FixupKind kind, const InstructionDef* def,
+                       std::string_view operand, NumberLiteral number, SymbolId symbol);
+
+    // Patch all recorded fixups - every symbol must be defined by now
+    void resolveFixups();
+
+    // True if an error was reported for 'stmt' by the pass so far
+    bool hasError(const Statement& stmt) const;
 
     // Generic encoding functions for each instruction format
     void encodeRegReg(const InstructionDef* def, uint8_t rX, uint8_t rY);
-    void encodeRegImm(const InstructionDef* def, uint8_t rX, int64_t imm);
-    void encodeRegImmOrReg(const InstructionDef* def, Instruction* instr, uint8_t rX);
-    void encodeBranch(const InstructionDef* def, Instruction* instr);
+    void encodeRegImm(const InstructionDef* def, const Instruction& instr, uint8_t rX);
+    void encodeRegImmOrReg(const InstructionDef* def, const Instruction& instr, uint8_t rX, bool shortLoad);
+    void encodeBranch(const InstructionDef* def, const Instruction& instr, bool relaxedBranch);
     void encodeRegOnly(const InstructionDef* def, uint8_t rX);
     void encodeRegMem(const InstructionDef* def, uint8_t rX, uint8_t rY);
-    void encodeShift(const InstructionDef* def, Instruction* instr, uint8_t rX);
-    void encodeLabelLoad(Instruction* instr, uint8_t rX);
+    void encodeShift(const InstructionDef* def, const Instruction& instr, uint8_t rX);
+    void encodeLabelLoad(const InstructionDef* def, const Instruction& instr, uint8_t rX, bool shortLoad);
     void encodeNoOperand(const InstructionDef* def);
     
+    // Count and repeated word of a .space or .fill, recording a fault if
+    // either is invalid
+    bool fillExtent(const Directive& dir, int64_t& count, uint16_t& word);
+
+    // Append the bytes of an .incbin as little-endian words
+    void emitBytes(std::string_view bytes);
+
     // Main encoding dispatcher
-    void encodeInstruction(Instruction* instr);
-    void encodeDirective(Directive* dir);
+    void encodeInstruction(const Statement& stmt);
+    void encodeDirective(const Statement& stmt);
+
+    // Define labels and .define symbols and apply .org. Returns false for
+    // statements that emit words. Errors are left in 'fault'.
+    bool defineStatement(const Statement& stmt);
+
+    // Number of words an instruction encodes to
+    int instructionSize(const Statement& stmt) const;
+
+    // Words emitted by any other statement than a label, .define or .org,
+    // and the segment kind they go to (FILL for .space and .fill, with the
+    // repeated word in 'fill'). Errors are left in 'fault'.
+    uint32_t statementSize(const Statement& stmt, SegmentKind& kind, uint16_t& fill);
+
+    // Layout optimization
+    static bool isRelaxable(const InstructionDef* def);
+    bool isShrinkable(const Instruction& instr) const;
+    uint8_t statementForm(const Statement& stmt) const;
+    bool isRelaxed(const Statement& stmt) const { return (statementForm(stmt) & FORM_LONG_BRANCH) != 0; }
+    bool isShortLoad(const Statement& stmt) const { return (statementForm(stmt) & FORM_SHORT_LOAD) != 0; }
+    bool isRemoved(const Statement& stmt) const { return (statementForm(stmt) & FORM_REMOVED) != 0; }
+
+    // Drop the statements the peephole rules remove and start every
+    // shrinkable load in its one-word form. Returns false if no statement
+    // changed form.
+    bool seedForms(const ProgramAST& ast);
+
+    // Lay the program out with the current forms, then move every short
+    // load whose value does not fit back to two words and every branch that
+    // is out of range to its long form, until nothing changes. Returns
+    // false if nothing changed. A layout that hits an error (which the
+    // encode then reports) drops all forms and returns false.
+    bool settleLayout(const ProgramAST& ast);
+
+    // Clear symbols, image and fixups before encoding again
+    void reset();
+    void dropForms();
+
+    // One encode attempt - false if it hit a branch relaxation can fix
+    bool encodeOnce(const ProgramAST& ast, unsigned threads);
+
+    // Serial single pass with fixups
+    void encodeSerial(const ProgramAST& ast);
+
+    // Parallel encode: a layout pass defines every symbol and reserves the
+    // words of every statement, then chunks are encoded concurrently into
+    // their slices. Returns false if any statement failed.
+    bool encodeParallel(const ProgramAST& ast, unsigned threads);
+    bool layout(const ProgramAST& ast, std::vector<EncodeChunk>& chunks);
+    bool encodeChunk(const ProgramAST& ast, const EncodeChunk& chunk, uint16_t* words);
 
 public:
-    Encoder(SymbolTable& st) : symbolTable(st), currentAddress(0) {}
+    Encoder(SymbolTable& st)
+        : symbolTable(st), currentAddress(0),
+          mvDef(getInstructionDef("mv")), mvtDef(getInstructionDef("mvt")), addDef(getInstructionDef("add")),
+          ldDef(getInstructionDef("ld")) {}
+
+    // Rewrite out-of-range b/b<cond> into long form (default) or fail
+    void setBranchRelaxation(bool enabled) { relaxation = enabled; }
+
+    // Encode mv rX, =value as one mv rX, #value when the value fits (default)
+    void setLoadShrinking(bool enabled) { shrinking = enabled; }
+
+    // Drop instructions without effect before encoding (default: off)
+    void setPeephole(bool enabled) { optimizing = enabled; }
+
+    // Encode a relocatable module for sblink instead of a final image
+    // (default: off). Symbols the module never defines are imports; .org
+    // makes the module absolute. Always encodes serially.
+    void setObjectOutput(bool enabled) { objectOutput = enabled; }
+
+    // Record the address of every statement for listings (default: off)
+    void setStatementAddresses(bool enabled) { recordAddresses = enabled; }
+
+    // Stop encoding after this many errors (0 = report all)
+    void setMaxErrors(size_t count) { maxErrors = count; }
+
+    // Branches rewritten into long form by the last encode()
+    size_t getRelaxedBranchCount() const { return relaxedCount; }
+
+    // =value loads encoded as one word by the last encode()
+    size_t getShortLoadCount() const { return shortLoadCount; }
+
+    // Rewrites applied by the last encode(); statement indices refer to its AST
+    const std::vector<PeepholeRewrite>& getPeepholeRewrites() const { return rewrites; }
+
+    const EncodeStats& getStats() const { return stats; }
+
+    // Object output: the fields the linker fills in, in image order, and
+    // whether the module is absolute. Word addresses are relative to the
+    // module start unless it is absolute.
+    const std::vector<Fixup>& getRelocations() const { return relocations; }
+    bool isAbsoluteModule() const { return absoluteModule; }
+
+    // Address of every statement of the last encode(), plus the address
+    // after the last one - statement i emitted the words from [i] to
+    // [i + 1] unless it is a label, .define or .org. Empty unless
+    // setStatementAddresses() was enabled.
+    const std::vector<uint32_t>& getStatementAddresses() const { return statementAddresses; }
+
+    // Instructions of the last encode() that took more than one word
+    // (=value loads and long branches) - counted on request, not while encoding
+    size_t countExpandedInstructions(const ProgramAST& ast) const;
 
     void setCurrentAddress(int addr) { currentAddress = addr; }
     int getCurrentAddress() const { return currentAddress; }
 
-    std::vector<uint16_t> encode(const std::vector<std::unique_ptr<Statement>>& ast);
+    // Assemble the whole program in one pass, defining labels and .define
+    // symbols on the way. Every error is appended to 'diagnostics' in
+    // statement order; returns false if there were any.
+    // threads != 1 encodes large programs on a worker pool (0 = one worker
+    // per hardware thread); the result and any error are the same as for
+    // the serial pass.
+    bool encode(const ProgramAST& ast, std::vector<Diagnostic>& diagnostics, unsigned threads = 1);
+
+    // The image of the last encode() - complete only if it succeeded
+    const MemoryImage& getImage() const { return image; }
 };
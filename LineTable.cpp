@@ -0,0 +1,162 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Line table implementation
+//
+// Layout of the sidecar file:
+//   header   "SBLT", version (32-bit), file count, entry count (varints)
+//   files    one string per source file
+//   entries  varints: address - end of the previous entry, words, file,
+//            line - previous line (signed), column
+// ============================================================================
+
+#include "LineTable.h"
+#include "ByteStream.h"
+#include "OutputWriter.h"
+#include "SourceFile.h"
+#include <algorithm>
+#include <stdexcept>
+
+static const char LINE_TABLE_MAGIC[4] = {'S', 'B', 'L', 'T'};
+
+void LineTable::add(const LineEntry& entry) {
+    if (!entries.empty()) {
+        LineEntry& last = entries.back();
+        if (last.address + last.words == entry.address && last.file == entry.file && last.line == entry.line &&
+            last.column == entry.column) {
+            last.words += entry.words;
+            return;
+        }
+    }
+    starts.push_back(entry.address);
+    entries.push_back(entry);
+}
+
+const LineEntry* LineTable::find(uint32_t address) const {
+    const auto next = std::upper_bound(starts.begin(), starts.end(), address);
+    if (next == starts.begin()) {
+        return nullptr;
+    }
+    const LineEntry& entry = entries[static_cast<size_t>(next - starts.begin()) - 1];
+    return address - entry.address < entry.words ? &entry : nullptr;
+}
+
+// Labels, .define and .org take no words; every other statement owns the
+// words up to the next statement's address
+LineTable buildLineTable(const ProgramAST& ast, const std::vector<uint32_t>& addresses) {
+    if (addresses.size() != ast.size() + 1) {
+        throw std::runtime_error("Line table needs the statement addresses of the encode");
+    }
+    LineTable table;
+    for (size_t i = 0; i < ast.fileCount(); i++) {
+        table.addFile(ast.fileName(static_cast<uint16_t>(i)));
+    }
+    for (size_t i = 0; i < ast.size(); i++) {
+        const Statement& stmt = ast[i];
+        if (stmt.type == StatementType::LABEL ||
+            (stmt.type == StatementType::DIRECTIVE && stmt.directive.name == ".org")) {
+            continue;
+        }
+        const uint32_t words = addresses[i + 1] - addresses[i];
+        if (words != 0) {
+            table.add({addresses[i], words, stmt.file, stmt.line, stmt.column});
+        }
+    }
+    return table;
+}
+
+// ============================================================================
+// Sidecar file
+// ============================================================================
+
+std::string serializeLineTable(const LineTable& table) {
+    std::string data;
+    ByteWriter out(data);
+    data.append(LINE_TABLE_MAGIC, sizeof(LINE_TABLE_MAGIC));
+    out.put(LINE_TABLE_VERSION);
+    out.putVarint(table.getFiles().size());
+    out.putVarint(table.size());
+    for (const std::string& file : table.getFiles()) {
+        out.putString(file);
+    }
+
+    uint32_t end = 0;
+    int32_t line = 0;
+    for (const LineEntry& entry : table.getEntries()) {
+        out.putVarint(entry.address - end);
+        out.putVarint(entry.words);
+        out.putVarint(entry.file);
+        out.putSignedVarint(static_cast<int64_t>(entry.line) - line);
+        out.putVarint(static_cast<uint32_t>(entry.column));
+        end = entry.address + entry.words;
+        line = entry.line;
+    }
+    return data;
+}
+
+bool decodeLineTable(std::string_view data, LineTable& table) {
+    ByteReader in(data.data(), data.size());
+    uint32_t version = 0;
+    uint64_t fileCount = 0;
+    uint64_t entryCount = 0;
+    if (data.size() < sizeof(LINE_TABLE_MAGIC) ||
+        memcmp(data.data(), LINE_TABLE_MAGIC, sizeof(LINE_TABLE_MAGIC)) != 0 ||
+        !in.skip(sizeof(LINE_TABLE_MAGIC)) || !in.get(version) || version != LINE_TABLE_VERSION ||
+        !in.getVarint(fileCount) || !in.getVarint(entryCount) || fileCount == 0 || fileCount > UINT16_MAX + 1u ||
+        entryCount > in.remaining()) {
+        return false;
+    }
+
+    table = LineTable();
+    for (uint64_t i = 0; i < fileCount; i++) {
+        std::string_view file;
+        if (!in.getString(file)) {
+            return false;
+        }
+        table.addFile(std::string(file));
+    }
+
+    uint64_t end = 0;
+    int64_t line = 0;
+    for (uint64_t i = 0; i < entryCount; i++) {
+        uint64_t gap = 0;
+        uint64_t words = 0;
+        uint64_t file = 0;
+        int64_t lineDelta = 0;
+        uint64_t column = 0;
+        if (!in.getVarint(gap) || !in.getVarint(words) || !in.getVarint(file) ||
+            !in.getSignedVarint(lineDelta) || !in.getVarint(column) || words == 0 ||
+            end + gap + words > ADDRESS_SPACE_WORDS || file >= fileCount || column > INT32_MAX) {
+            return false;
+        }
+        line += lineDelta;
+        if (line < 0 || line > INT32_MAX) {
+            return false;
+        }
+        const uint32_t address = static_cast<uint32_t>(end + gap);
+        table.add({address, static_cast<uint32_t>(words), static_cast<uint16_t>(file), static_cast<int32_t>(line),
+                   static_cast<int32_t>(column)});
+        end = address + words;
+    }
+    return in.done();
+}
+
+void writeLineTableFile(const LineTable& table, std::string& path) {
+    if (path.size() < LINE_TABLE_EXTENSION.size() ||
+        std::string_view(path).substr(path.size() - LINE_TABLE_EXTENSION.size()) != LINE_TABLE_EXTENSION) {
+        path += LINE_TABLE_EXTENSION;
+    }
+    OutputBuffer out;
+    out.append(serializeLineTable(table));
+    out.writeToFile(path);
+}
+
+LineTable readLineTableFile(const std::string& path) {
+    SourceFile file(path);
+    LineTable table;
+    if (!decodeLineTable(file.text(), table)) {
+        throw std::runtime_error("Not a valid sbasm line table (version " + std::to_string(LINE_TABLE_VERSION) +
+                                 "): " + path);
+    }
+    return table;
+}
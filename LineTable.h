@@ -0,0 +1,70 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Address to source line table (-g) for the simulator and
+//              trace decoders
+//              Built from the statement addresses the encoder records, one
+//              entry per run of words with the same file, line and column.
+//              Entries are kept in address order with their start addresses
+//              in an array of their own, so a lookup is a binary search over
+//              4-byte keys. The sidecar file stores every field as a delta
+//              from the entry before it, mostly one byte each.
+// ============================================================================
+
+#pragma once
+#include "common.h"
+#include "ast.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+constexpr uint32_t LINE_TABLE_VERSION = 1;     // Bump when the layout changes
+constexpr std::string_view LINE_TABLE_EXTENSION = ".dbg";
+
+struct LineEntry {
+    uint32_t address;       // First word
+    uint32_t words;         // Words from 'address' on with this location
+    uint16_t file;          // Index into LineTable::getFiles()
+    int32_t line;
+    int32_t column;
+};
+
+class LineTable {
+private:
+    std::vector<std::string> files;     // [0] = main source
+    std::vector<uint32_t> starts;       // entries[i].address - the search keys
+    std::vector<LineEntry> entries;
+
+public:
+    void addFile(std::string name) { files.push_back(std::move(name)); }
+
+    // Entries must be added in address order and must not overlap; an
+    // entry continuing the last one at the same location extends it
+    void add(const LineEntry& entry);
+
+    // Entry holding the word at 'address', nullptr if no statement emitted
+    // it (.org gaps, addresses past the end)
+    const LineEntry* find(uint32_t address) const;
+
+    const std::vector<std::string>& getFiles() const { return files; }
+    const std::vector<LineEntry>& getEntries() const { return entries; }
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+};
+
+// Table of an encode with statement addresses recorded:
+// 'addresses' is Encoder::getStatementAddresses()
+LineTable buildLineTable(const ProgramAST& ast, const std::vector<uint32_t>& addresses);
+
+std::string serializeLineTable(const LineTable& table);
+
+// Decode 'data' into 'table'. Returns false if it is not a valid line table
+// of this version.
+bool decodeLineTable(std::string_view data, LineTable& table);
+
+// Write the table to 'path', appending LINE_TABLE_EXTENSION if it does not
+// already end with it. Throws if the file cannot be written.
+void writeLineTableFile(const LineTable& table, std::string& path);
+
+// Throws if the file cannot be read or is not a valid line table
+LineTable readLineTableFile(const std::string& path);
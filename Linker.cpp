@@ -0,0 +1,193 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Linker implementation
+// ============================================================================
+
+#include "Linker.h"
+#include "InstructionEncoder.h"
+#include <algorithm>
+
+namespace {
+
+// Words [first, end) claimed by one input
+struct Extent {
+    uint32_t first;
+    uint32_t end;
+    size_t input;
+};
+
+std::string hexAddress(uint32_t address) {
+    char text[16];
+    snprintf(text, sizeof(text), "0x%04x", address);
+    return text;
+}
+
+} // namespace
+
+void Linker::error(ErrorCode code, std::string message) {
+    diagnostics.push_back({DiagnosticKind::LINK, 0, 0, std::move(message), 0, code});
+}
+
+// Absolute inputs first, each contiguous run of segments one extent. Then
+// every relocatable input at the lowest address where all its words fit.
+bool Linker::place(const std::vector<LinkInput>& inputs) {
+    bases.assign(inputs.size(), 0);
+    std::vector<Extent> used;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        if (!inputs[i].module.absolute) {
+            continue;
+        }
+        for (const Segment& seg : inputs[i].module.image.getSegments()) {
+            if (!used.empty() && used.back().input == i && used.back().end == seg.address) {
+                used.back().end = seg.end();
+            } else {
+                used.push_back({seg.address, seg.end(), i});
+            }
+        }
+    }
+    std::sort(used.begin(), used.end(), [](const Extent& a, const Extent& b) { return a.first < b.first; });
+    bool ok = true;
+    for (size_t i = 1; i < used.size(); i++) {
+        if (used[i].first < used[i - 1].end) {
+            error(ErrorCode::SECTION_OVERLAP, inputs[used[i - 1].input].path + " and " +
+                                              inputs[used[i].input].path + " both use address " +
+                                              hexAddress(used[i].first));
+            ok = false;
+        }
+    }
+    if (!ok) {
+        return false;
+    }
+
+    for (size_t i = 0; i < inputs.size(); i++) {
+        const uint32_t size = inputs[i].module.image.size();
+        if (inputs[i].module.absolute || size == 0) {
+            continue;
+        }
+        uint32_t base = 0;
+        auto next = used.begin();
+        for (; next != used.end() && base + size > next->first; ++next) {
+            base = std::max(base, next->end);
+        }
+        if (static_cast<uint64_t>(base) + size > ADDRESS_SPACE_WORDS) {
+            error(ErrorCode::ADDRESS_SPACE, "No room for " + inputs[i].path + " (" + std::to_string(size) +
+                                            " words) in the 16-bit address space");
+            ok = false;
+            continue;
+        }
+        bases[i] = base;
+        used.insert(next, {base, base + size, i});
+    }
+    return ok;
+}
+
+bool Linker::defineGlobals(const std::vector<LinkInput>& inputs) {
+    bool ok = true;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        const ObjectModule& module = inputs[i].module;
+        for (const ObjectSymbol& sym : module.symbols) {
+            if (sym.binding != SymbolBinding::GLOBAL) {
+                continue;
+            }
+            const SymbolId id = names.intern(sym.name);
+            globals.resize(names.size());
+            GlobalSymbol& global = globals[id];
+            if (global.kind != SymbolKind::UNDEFINED) {
+                error(ErrorCode::DUPLICATE_GLOBAL, "Duplicate global symbol: " + sym.name + " (" +
+                                                   inputs[global.module].path + " and " + inputs[i].path + ")");
+                ok = false;
+                continue;
+            }
+            const bool moves = sym.kind == SymbolKind::LABEL && !module.absolute;
+            global = {sym.kind, sym.value + static_cast<int>(moves ? bases[i] : 0), i};
+        }
+    }
+    return ok;
+}
+
+void Linker::relocate(LinkInput& input, size_t index) {
+    ObjectModule& module = input.module;
+    const uint32_t base = bases[index];
+
+    // Final value of every symbol of the object - imports from the global table
+    std::vector<GlobalSymbol> values(module.symbols.size());
+    for (size_t i = 0; i < module.symbols.size(); i++) {
+        const ObjectSymbol& sym = module.symbols[i];
+        if (sym.binding == SymbolBinding::EXTERN) {
+            const SymbolId id = names.intern(sym.name);
+            globals.resize(names.size());
+            values[i] = globals[id];
+        } else {
+            const bool moves = sym.kind == SymbolKind::LABEL && !module.absolute;
+            values[i] = {sym.kind, sym.value + static_cast<int>(moves ? base : 0), index};
+        }
+    }
+
+    for (const ObjectRelocation& relocation : module.relocations) {
+        const GlobalSymbol& value = values[relocation.symbol];
+        const std::string& name = module.symbols[relocation.symbol].name;
+        const std::string location = "Error at line " + std::to_string(relocation.line) + " of " +
+                                     module.files[relocation.file] + ": ";
+        if (value.kind == SymbolKind::UNDEFINED) {
+            error(ErrorCode::UNDEFINED_SYMBOL, location + "Undefined symbol: " + name);
+            continue;
+        }
+        if (isLabelField(relocation.kind) && value.kind != SymbolKind::LABEL) {
+            error(ErrorCode::UNDEFINED_LABEL, location + "Undefined label: " + name);
+            continue;
+        }
+        EncodeFault fault;
+        const int address = static_cast<int>(base + relocation.address);
+        const uint16_t bits = encodeFieldBits(relocation.kind, relocation.def, value.value, address, fault);
+        if (fault.code != ErrorCode::NONE) {
+            fault.kind = relocation.kind;
+            fault.def = relocation.def;
+            error(fault.code, location + describeFieldFault(fault) + " (" + name + ")");
+            continue;
+        }
+        module.image.patch(relocation.index, bits);
+    }
+}
+
+// Segments of all inputs in address order, the gaps between them zero filled
+void Linker::buildImage(const std::vector<LinkInput>& inputs) {
+    struct Placed {
+        uint32_t address;
+        const Segment* segment;
+        const MemoryImage* source;
+    };
+    std::vector<Placed> placed;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        const MemoryImage& source = inputs[i].module.image;
+        for (const Segment& seg : source.getSegments()) {
+            placed.push_back({seg.address + bases[i], &seg, &source});
+        }
+    }
+    std::sort(placed.begin(), placed.end(), [](const Placed& a, const Placed& b) { return a.address < b.address; });
+
+    for (const Placed& part : placed) {
+        const Segment& seg = *part.segment;
+        image.advanceTo(part.address);
+        if (seg.kind == SegmentKind::FILL) {
+            image.fill(seg.length, seg.fill);
+        } else {
+            const size_t index = image.append(seg.length, seg.kind);
+            memcpy(image.storage() + index, part.source->segmentWords(seg), seg.length * sizeof(uint16_t));
+        }
+    }
+}
+
+bool Linker::link(std::vector<LinkInput>& inputs) {
+    if (!place(inputs) || !defineGlobals(inputs)) {
+        return false;
+    }
+    for (size_t i = 0; i < inputs.size(); i++) {
+        relocate(inputs[i], i);
+    }
+    if (!diagnostics.empty()) {
+        return false;
+    }
+    buildImage(inputs);
+    return true;
+}
@@ -0,0 +1,69 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: sblink - links object files into one memory image
+//              Absolute objects keep their addresses; relocatable objects
+//              are placed in command line order at the lowest address where
+//              they fit. Exported symbols go into one table keyed by
+//              interned name, so each import is looked up once per object,
+//              not once per relocation. Relocated fields are range checked
+//              exactly as the encoder checks them.
+// ============================================================================
+
+#pragma once
+#include "common.h"
+#include "Diagnostics.h"
+#include "MemoryImage.h"
+#include "ObjectFile.h"
+#include "StringInterner.h"
+#include "SymbolTable.h"
+#include <string>
+#include <vector>
+
+struct LinkInput {
+    std::string path;       // For messages
+    ObjectModule module;    // Relocations are patched into its image
+};
+
+class Linker {
+private:
+    struct GlobalSymbol {
+        SymbolKind kind = SymbolKind::UNDEFINED;
+        int value = 0;              // Final address of a label
+        size_t module = 0;          // Exporting input
+    };
+
+    StringInterner names;               // Global symbol names
+    std::vector<GlobalSymbol> globals;  // Indexed by interned name
+    std::vector<uint32_t> bases;        // Per input: address of its first word (0 if absolute)
+    MemoryImage image;
+    std::vector<Diagnostic> diagnostics;
+
+    void error(ErrorCode code, std::string message);
+
+    // Choose every input's base address. Returns false on overlaps or if
+    // an input does not fit.
+    bool place(const std::vector<LinkInput>& inputs);
+
+    // Collect the exports of every input. Returns false on duplicates.
+    bool defineGlobals(const std::vector<LinkInput>& inputs);
+
+    // Patch the relocations of one input
+    void relocate(LinkInput& input, size_t index);
+
+    // Copy every input's words to its place in the image
+    void buildImage(const std::vector<LinkInput>& inputs);
+
+public:
+    // Link 'inputs' into one image. Every error is added to the
+    // diagnostics; returns false if there were any.
+    bool link(std::vector<LinkInput>& inputs);
+
+    // Valid after link() succeeded
+    const MemoryImage& getImage() const { return image; }
+
+    // Address of the first word of input 'index'
+    uint32_t getBase(size_t index) const { return bases[index]; }
+
+    const std::vector<Diagnostic>& getDiagnostics() const { return diagnostics; }
+};
@@ -0,0 +1,156 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: sblink - links sbasm objects (sbasm -c) into a memory image
+//              Only the modules that changed have to be assembled again; the
+//              others are linked from their objects as they are.
+// ============================================================================
+
+#include "common.h"
+#include "Linker.h"
+#include "NumberParser.h"
+#include "ObjectFile.h"
+#include "OutputWriter.h"
+#include <iomanip>
+
+void printHelp(const char* programName) {
+    std::cout << "Usage: " << programName << " object_file... [options]\n"
+              << "Link sbasm objects into one memory image\n\n"
+              << "Options:\n"
+              << "  -o <file>, --output <file>   Specify output file (default: a.<format>)\n"
+              << "  -f <fmt>, --format <fmt>     Output format (default: mif)\n"
+              << "  --no-comments                Omit disassembly comments from the output\n"
+              << "  --depth <words|auto>         Memory depth (default: 256, grown to the next\n"
+              << "                               power of two if the program does not fit)\n"
+              << "  --no-compress                Write every word of the MIF on its own line\n"
+              << "  -v, --verbose                Print where every object was placed\n"
+              << "  -h, --help                   Display this help message\n\n"
+              << "Absolute objects (assembled with .org) keep their addresses, the others\n"
+              << "are placed in command line order at the lowest free address.\n";
+}
+
+int main(int argc, const char* argv[]) {
+    std::string outputFile = "a";   // Extension is added by the output writer
+    OutputOptions outputOptions;
+    int requestedDepth = DEPTH_DEFAULT;
+    bool verbose = false;
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; ) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            printHelp("sblink");
+            return 0;
+        } else if (arg == "-o" || arg == "--output") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: -o requires an output filename" << std::endl;
+                return 1;
+            }
+            outputFile = argv[i + 1];
+            i += 2;
+        } else if (arg == "-f" || arg == "--format") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: -f requires an output format" << std::endl;
+                return 1;
+            }
+            const OutputFormatDef* fmt = getOutputFormatDef(argv[i + 1]);
+            if (fmt == nullptr) {
+                std::cerr << "Error: Unknown output format '" << argv[i + 1] << "'\n"
+                          << "Use -h for help" << std::endl;
+                return 1;
+            }
+            outputOptions.format = fmt->format;
+            i += 2;
+        } else if (arg == "--no-comments") {
+            outputOptions.comments = false;
+            i += 1;
+        } else if (arg == "--no-compress") {
+            outputOptions.compress = false;
+            i += 1;
+        } else if (arg == "--depth") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --depth requires a word count or 'auto'" << std::endl;
+                return 1;
+            }
+            std::string value = argv[i + 1];
+            int64_t depth = 0;
+            if (value == "auto") {
+                requestedDepth = DEPTH_AUTO;
+            } else if (parseNumber(value, depth) && depth >= 1 && depth <= MAX_MEMORY_DEPTH) {
+                requestedDepth = static_cast<int>(depth);
+            } else {
+                std::cerr << "Error: Invalid memory depth '" << value << "'" << std::endl;
+                return 1;
+            }
+            i += 2;
+        } else if (arg == "-v" || arg == "--verbose") {
+            verbose = true;
+            i += 1;
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            std::cerr << "Error: Unexpected argument '" << arg << "'\n"
+                      << "Use -h for help" << std::endl;
+            return 1;
+        } else {
+            inputs.push_back(arg);
+            i += 1;
+        }
+    }
+
+    if (inputs.empty()) {
+        std::cerr << "Error: No object file specified.\n"
+                  << "Usage: " << argv[0] << " object_file... [options]\n"
+                  << "Use -h for help" << std::endl;
+        return 1;
+    }
+
+    try {
+        std::vector<LinkInput> objects;
+        objects.reserve(inputs.size());
+        for (const std::string& path : inputs) {
+            objects.push_back({path, readObjectFile(path)});
+        }
+
+        Linker linker;
+        if (!linker.link(objects)) {
+            for (const Diagnostic& diag : linker.getDiagnostics()) {
+                std::cerr << "\nError: " << diag.message << std::endl;
+            }
+            if (linker.getDiagnostics().size() > 1) {
+                std::cerr << "\n" << linker.getDiagnostics().size() << " errors" << std::endl;
+            }
+            return 1;
+        }
+        const MemoryImage& image = linker.getImage();
+
+        if (verbose) {
+            std::cout << "Placement:\n" << std::hex << std::setfill('0');
+            for (size_t i = 0; i < objects.size(); i++) {
+                const ObjectModule& module = objects[i].module;
+                std::cout << "  " << objects[i].path << ": ";
+                if (module.absolute) {
+                    std::cout << "absolute";
+                } else {
+                    std::cout << "0x" << std::setw(4) << linker.getBase(i) << " - 0x" << std::setw(4)
+                              << linker.getBase(i) + module.image.size();
+                }
+                std::cout << std::dec << " (" << module.image.size() << " words, " << module.relocations.size()
+                          << " relocation(s))\n" << std::hex;
+            }
+            std::cout << std::dec << std::setfill(' ');
+        }
+
+        outputOptions.depth = resolveMemoryDepth(image.size(), requestedDepth);
+        if (requestedDepth == DEPTH_DEFAULT && outputOptions.depth != DEFAULT_MEMORY_DEPTH) {
+            std::cout << "Note: program does not fit in " << DEFAULT_MEMORY_DEPTH
+                      << " words, using DEPTH = " << outputOptions.depth << "\n";
+        }
+        writeOutputFile(image, outputFile, outputOptions);
+        std::cout << "\nLink completed. Output: " << outputFile << " (" << image.size() << " words, "
+                  << objects.size() << " object(s))\n";
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "\nError: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,242 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Listing and symbol map implementation
+// ============================================================================
+
+#include "Listing.h"
+#include "InstructionDef.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+// Segment lookup for addresses that only move forward, like the
+// statements of a program (.org cannot go back)
+class SegmentFinder {
+private:
+    const std::vector<Segment>& segments;
+    size_t index = 0;
+
+public:
+    explicit SegmentFinder(const MemoryImage& image) : segments(image.getSegments()) {}
+
+    // Segment holding 'address', nullptr for a gap
+    const Segment* find(uint32_t address) {
+        while (index < segments.size() && segments[index].end() <= address) {
+            index++;
+        }
+        return index < segments.size() && segments[index].address <= address ? &segments[index] : nullptr;
+    }
+};
+
+void pad(OutputBuffer& out, size_t lineStart, size_t column) {
+    const size_t length = out.size() - lineStart;
+    for (size_t i = length; i < column; i++) {
+        out.put(' ');
+    }
+    if (length >= column) {
+        out.put(' ');
+    }
+}
+
+void rightAligned(OutputBuffer& out, uint64_t value, int width) {
+    int digits = 1;
+    for (uint64_t rest = value / 10; rest != 0; rest /= 10) {
+        digits++;
+    }
+    for (int i = digits; i < width; i++) {
+        out.put(' ');
+    }
+    out.decimal(value);
+}
+
+// Decoded string literal back in source form
+void quoted(OutputBuffer& out, std::string_view text) {
+    out.put('"');
+    for (const char c : text) {
+        switch (c) {
+            case '"':  out.append("\\\""); break;
+            case '\\': out.append("\\\\"); break;
+            case '\n': out.append("\\n"); break;
+            case '\t': out.append("\\t"); break;
+            default:
+                if (c >= 0x20 && c < 0x7F) {
+                    out.put(c);
+                } else {
+                    out.append("\\x");
+                    out.hex(static_cast<uint8_t>(c), 2);
+                }
+                break;
+        }
+    }
+    out.put('"');
+}
+
+// The statement as parsed - macro and .rept bodies are listed expanded
+void appendStatement(const Statement& stmt, OutputBuffer& out) {
+    switch (stmt.type) {
+        case StatementType::LABEL:
+            out.append(stmt.label.name);
+            out.put(':');
+            break;
+
+        case StatementType::INSTRUCTION: {
+            const Instruction& instr = stmt.instruction;
+            out.append("    ");
+            out.append(instr.def->mnemonic);
+            if (!instr.operand1.empty()) {
+                out.put(' ');
+                out.append(instr.operand1);
+            }
+            if (!instr.operand2.empty()) {
+                out.append(", ");
+                out.append(instr.operand2);
+            }
+            break;
+        }
+
+        case StatementType::DIRECTIVE: {
+            const Directive& dir = stmt.directive;
+            out.append("    ");
+            out.append(dir.name);
+            if (dir.valueCount != 0) {
+                for (size_t i = 0; i < dir.count(); i++) {
+                    out.append(i == 0 ? " " : ", ");
+                    out.append(dir.item(i).text);
+                }
+            } else if (dir.name == ".incbin") {
+                out.put(' ');
+                quoted(out, dir.label);
+            } else if (dir.name == ".ascii" || dir.name == ".asciiz" || dir.name == ".include") {
+                out.put(' ');
+                quoted(out, dir.value);
+            } else {
+                if (!dir.label.empty()) {
+                    out.put(' ');
+                    out.append(dir.label);
+                }
+                if (!dir.value.empty()) {
+                    out.put(' ');
+                    out.append(dir.value);
+                }
+            }
+            break;
+        }
+    }
+}
+
+} // namespace
+
+void formatListing(const ProgramAST& ast, const std::vector<uint32_t>& addresses, const MemoryImage& image,
+                   OutputBuffer& out) {
+    if (addresses.size() != ast.size() + 1) {
+        throw std::runtime_error("Listing needs the statement addresses of the encode");
+    }
+    DisassemblyTable disasm;
+    SegmentFinder segments(image);
+    out.reserve(ast.size() * 64);
+
+    out.append("; sbasm listing: ");
+    out.append(ast.fileName(0));
+    out.put('\n');
+    uint16_t file = 0;
+
+    for (size_t i = 0; i < ast.size(); i++) {
+        const Statement& stmt = ast[i];
+        if (stmt.file != file) {
+            file = stmt.file;
+            out.append("\n;\n; ");
+            out.append(ast.fileName(file));
+        }
+        const bool emits = stmt.type != StatementType::LABEL &&
+                           !(stmt.type == StatementType::DIRECTIVE && stmt.directive.name == ".org");
+        const uint32_t address = addresses[i];
+        const uint32_t count = emits ? addresses[i + 1] - address : 0;
+        const uint32_t listed = std::min(count, LISTING_MAX_WORDS);
+
+        for (uint32_t w = 0; w < std::max<uint32_t>(listed, 1); w++) {
+            out.put('\n');
+            const size_t lineStart = out.size();
+            const Segment* seg = nullptr;
+            if (w < listed) {
+                seg = segments.find(address + w);
+                out.hex(address + w, 4);
+                out.append("  ");
+                if (seg != nullptr) {
+                    out.hex(image.wordAt(*seg, address + w), 4);
+                } else {
+                    out.append("----");     // Object output: .org gap, filled by the linker
+                }
+            } else {
+                out.append("          ");
+            }
+            if (w == 0) {
+                out.put(' ');
+                rightAligned(out, static_cast<uint64_t>(stmt.line), 7);
+                out.append("  ");
+                appendStatement(stmt, out);
+            }
+            if (seg != nullptr) {
+                const uint16_t word = image.wordAt(*seg, address + w);
+                pad(out, lineStart, LISTING_COMMENT_COLUMN);
+                out.append("; ");
+                char* text = out.extend(DISASM_MAX_LENGTH);
+                const size_t length = seg->isData() ? formatDataWordInto(word, text)
+                                                    : disasm.format(word, address + w, text);
+                out.shrink(DISASM_MAX_LENGTH - length);
+            }
+        }
+        if (count > listed) {
+            out.append("\n      ... ");
+            out.decimal(count - listed);
+            out.append(" more word(s)");
+        }
+    }
+    out.put('\n');
+}
+
+void formatSymbolMap(const SymbolTable& symbolTable, size_t symbolCount, std::string_view source,
+                     OutputBuffer& out) {
+    std::vector<SymbolId> labels;
+    std::vector<SymbolId> defines;
+    for (SymbolId id = 0; id < static_cast<SymbolId>(symbolCount); id++) {
+        const SymbolKind kind = symbolTable.lookup(id).kind;
+        if (kind == SymbolKind::LABEL) {
+            labels.push_back(id);
+        } else if (kind == SymbolKind::DEFINE) {
+            defines.push_back(id);
+        }
+    }
+    std::sort(labels.begin(), labels.end(), [&](SymbolId a, SymbolId b) {
+        const int x = symbolTable.lookup(a).value;
+        const int y = symbolTable.lookup(b).value;
+        return x != y ? x < y : symbolTable.getName(a) < symbolTable.getName(b);
+    });
+    std::sort(defines.begin(), defines.end(), [&](SymbolId a, SymbolId b) {
+        return symbolTable.getName(a) < symbolTable.getName(b);
+    });
+
+    out.append("; sbasm symbol map: ");
+    out.append(source);
+    out.append("\n\n; Labels\n");
+    for (const SymbolId id : labels) {
+        out.hex(static_cast<uint32_t>(symbolTable.lookup(id).value), 4);
+        out.append("  ");
+        out.append(symbolTable.getName(id));
+        out.put('\n');
+    }
+    out.append("\n; Defines\n");
+    for (const SymbolId id : defines) {
+        const int value = symbolTable.lookup(id).value;
+        out.append(symbolTable.getName(id));
+        out.append(" = ");
+        if (value < 0) {
+            out.put('-');
+        }
+        out.decimal(static_cast<uint64_t>(value < 0 ? -static_cast<int64_t>(value) : value));
+        out.append(" (0x");
+        out.hex(static_cast<uint16_t>(value), 4);
+        out.append(")\n");
+    }
+}
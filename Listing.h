@@ -0,0 +1,41 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Listing (-l) and symbol map (-m) of an assembled program
+//              The encoder records the address of every statement while it
+//              encodes; the listing pairs those addresses with the final
+//              words of the image (fixups patched) and the statements of the
+//              AST, so it is formatted in one walk with no second encode.
+//
+//                  0004  3e05      12      mv r7, #5         ; mv   r7, #0x5
+//
+//              Address, words, source line, the statement as parsed and the
+//              disassembly of each word. Statements of included files and
+//              macro bodies are listed under the name of their file.
+// ============================================================================
+
+#pragma once
+#include "common.h"
+#include "ast.h"
+#include "MemoryImage.h"
+#include "OutputWriter.h"
+#include "SymbolTable.h"
+#include <string_view>
+#include <vector>
+
+// Words listed per statement - longer .fill, .space and .incbin data is
+// cut short with a count of the rest
+constexpr uint32_t LISTING_MAX_WORDS = 8;
+
+// Column of the disassembly comment
+constexpr size_t LISTING_COMMENT_COLUMN = 56;
+
+// 'addresses' is Encoder::getStatementAddresses() of the encode that
+// produced 'image'
+void formatListing(const ProgramAST& ast, const std::vector<uint32_t>& addresses, const MemoryImage& image,
+                   OutputBuffer& out);
+
+// Labels in address order, then defines in name order. 'symbolCount' is
+// the number of interned names.
+void formatSymbolMap(const SymbolTable& symbolTable, size_t symbolCount, std::string_view source,
+                     OutputBuffer& out);
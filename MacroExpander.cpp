@@ -0,0 +1,512 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: .macro and .rept expansion implementation
+// ============================================================================
+
+#include "MacroExpander.h"
+#include "InstructionDef.h"
+#include <algorithm>
+#include <cstring>
+
+// Source text of a token, empty for punctuation
+static std::string_view textOf(const MacroToken& token) {
+    const YYSTYPE& value = token.value;
+    switch (token.type) {
+        case INSTRUCTION:
+            return value.def->mnemonic;
+        case REGISTER:
+            return std::string_view(value.reg.text.data, value.reg.text.length);
+        case NUMBER:
+        case IMMEDIATE:
+        case LABEL_IMMEDIATE:
+            return std::string_view(value.number.text.data, value.number.text.length);
+        case DIRECTIVE:
+        case STRING:
+            return std::string_view(value.text.data, value.text.length);
+        case LABEL:
+        case IDENTIFIER:
+        case IMMEDIATE_SYMBOL:
+        case LABEL_IMMEDIATE_SYMBOL:
+            return std::string_view(value.symbol.text.data, value.symbol.text.length);
+        default:
+            return std::string_view();
+    }
+}
+
+static bool namesSymbol(int type) {
+    return type == LABEL || type == IDENTIFIER || type == IMMEDIATE_SYMBOL || type == LABEL_IMMEDIATE_SYMBOL;
+}
+
+MacroExpander::MacroExpander(ParseContext& context, void* scannerState)
+    : ctx(context), scanner(scannerState), table(*context.macros) {}
+
+MacroToken MacroExpander::scan() {
+    MacroToken token;
+    token.type = scanner_next(&token.value, scanner);
+    token.location = ctx.tokenStart;
+    token.lineStart = token.location.line != lastLine;
+    token.parameter = -1;
+    token.local = -1;
+    lastLine = token.location.line;
+    return token;
+}
+
+MacroToken MacroExpander::read() {
+    if (!frames.empty()) {
+        Frame& frame = frames.back();
+        if (frame.position == frame.tokens->size()) {
+            MacroToken end{};
+            end.type = END;
+            end.location = frame.location;
+            end.lineStart = true;
+            end.parameter = -1;
+            end.local = -1;
+            return end;
+        }
+        MacroToken token = (*frame.tokens)[frame.position++];
+        if (frame.relocate) {
+            token.location = frame.location;
+        }
+        if (token.local >= 0) {
+            token.value.symbol.sym = frame.locals[token.local];
+            token.local = -1;
+        }
+        return token;
+    }
+    if (!hasPending) {
+        pending = scan();
+    }
+    hasPending = pending.type == END;   // The scanner's END is sticky
+    return pending;
+}
+
+bool MacroExpander::continuesLine() {
+    if (!frames.empty()) {
+        const Frame& frame = frames.back();
+        return frame.position < frame.tokens->size() && !(*frame.tokens)[frame.position].lineStart;
+    }
+    if (!hasPending) {
+        pending = scan();
+        hasPending = true;
+    }
+    return pending.type != END && !pending.lineStart;
+}
+
+void MacroExpander::error(const SourceLocation& at, const std::string& message) {
+    ctx.report(DiagnosticKind::PARSE, "Macro error at line " + std::to_string(at.line) + ": " + message, at);
+}
+
+void MacroExpander::expectLineEnd(const MacroToken& directive) {
+    if (!continuesLine()) {
+        return;
+    }
+    error(directive.location, "Unexpected operands after " + std::string(textOf(directive)));
+    while (continuesLine()) {
+        read();
+    }
+}
+
+void MacroExpander::push(std::shared_ptr<const TokenList> tokens, int64_t passes, bool relocate,
+                         const SourceLocation& at, std::shared_ptr<const LocalNames> localNames) {
+    frames.push_back({std::move(tokens), 0, passes, relocate, at, std::move(localNames), {}});
+    renameLocals(frames.back());
+}
+
+void MacroExpander::declareLocals(const MacroToken& directive, LocalNames& locals) {
+    if (!continuesLine()) {
+        error(directive.location, ".local expects label names");
+        return;
+    }
+    for (bool first = true; continuesLine(); first = false) {
+        if (!first) {
+            const MacroToken comma = read();
+            if (comma.type != COMMA || !continuesLine()) {
+                error(comma.location, ".local names must be separated by commas");
+                break;
+            }
+        }
+        const MacroToken name = read();
+        if (name.type != IDENTIFIER) {
+            error(name.location, "'" + std::string(textOf(name)) + "' cannot be used as a local name");
+            break;
+        }
+        if (std::find(locals.begin(), locals.end(), name.value.symbol.sym) != locals.end()) {
+            error(name.location, "Duplicate local '" + std::string(textOf(name)) + "'");
+        } else {
+            locals.push_back(name.value.symbol.sym);
+        }
+    }
+    while (continuesLine()) {
+        read();
+    }
+}
+
+void MacroExpander::markLocals(TokenList& body, const LocalNames& locals) {
+    for (MacroToken& token : body) {
+        if (namesSymbol(token.type) && token.parameter < 0) {
+            auto it = std::find(locals.begin(), locals.end(), token.value.symbol.sym);
+            if (it != locals.end()) {
+                token.local = static_cast<int>(it - locals.begin());
+            }
+        }
+    }
+}
+
+// name@N cannot be written in the source, so it never clashes with a label
+void MacroExpander::renameLocals(Frame& frame) {
+    frame.locals.clear();
+    if (!frame.localNames) {
+        return;
+    }
+    for (SymbolId name : *frame.localNames) {
+        const std::string unique = std::string(ctx.symbols.name(name)) + "@" + std::to_string(++table.renamed);
+        frame.locals.push_back(ctx.symbols.intern(unique));
+    }
+}
+
+// .macro NAME p1, p2 - the header, then the body up to .endm
+void MacroExpander::define(const MacroToken& directive) {
+    used = true;
+    MacroDef def;
+    SymbolId name = NO_SYMBOL;
+    bool valid = false;
+
+    if (continuesLine()) {
+        const MacroToken token = read();
+        if (token.type == IDENTIFIER) {
+            name = token.value.symbol.sym;
+            def.name = textOf(token);
+            valid = true;
+        } else {
+            error(token.location, "'" + std::string(textOf(token)) + "' cannot be used as a macro name");
+        }
+    } else {
+        error(directive.location, ".macro expects a name");
+    }
+
+    while (valid && continuesLine()) {
+        if (!def.parameters.empty()) {
+            const MacroToken comma = read();
+            if (comma.type != COMMA || !continuesLine()) {
+                error(comma.location, "Macro parameters must be separated by commas");
+                valid = false;
+                break;
+            }
+        }
+        const MacroToken param = read();
+        if (param.type != IDENTIFIER) {
+            error(param.location, "'" + std::string(textOf(param)) + "' cannot be used as a parameter name");
+            valid = false;
+        } else if (std::find(def.parameters.begin(), def.parameters.end(), param.value.symbol.sym) !=
+                   def.parameters.end()) {
+            error(param.location, "Duplicate parameter '" + std::string(textOf(param)) + "'");
+            valid = false;
+        } else {
+            def.parameters.push_back(param.value.symbol.sym);
+        }
+    }
+    while (continuesLine()) {
+        read();
+    }
+
+    // The body is recorded even after a bad header, so it is not assembled.
+    // .local lines of nested .rept blocks are left to the block.
+    LocalNames locals;
+    int depth = 0;
+    for (;;) {
+        MacroToken token = read();
+        if (token.type == END) {
+            error(directive.location, "Missing .endm for .macro " + std::string(def.name));
+            return;
+        }
+        if (token.type == DIRECTIVE) {
+            const std::string_view directiveName = textOf(token);
+            if (directiveName == ".endm") {
+                expectLineEnd(token);
+                break;
+            }
+            if (directiveName == ".macro") {
+                error(token.location, ".macro inside the body of " + std::string(def.name));
+                valid = false;
+            } else if (directiveName == ".rept") {
+                depth++;
+            } else if (directiveName == ".endr") {
+                depth--;
+            } else if (directiveName == ".local" && depth == 0) {
+                declareLocals(token, locals);
+                continue;
+            }
+        }
+        if (namesSymbol(token.type)) {
+            auto it = std::find(def.parameters.begin(), def.parameters.end(), token.value.symbol.sym);
+            if (it != def.parameters.end()) {
+                token.parameter = static_cast<int>(it - def.parameters.begin());
+            }
+        }
+        def.body.push_back(token);
+    }
+    for (SymbolId local : locals) {
+        if (std::find(def.parameters.begin(), def.parameters.end(), local) != def.parameters.end()) {
+            error(directive.location, "'" + std::string(ctx.symbols.name(local)) + "' is a parameter of " +
+                                      std::string(def.name) + " and cannot be .local");
+            valid = false;
+        }
+    }
+
+    if (!valid) {
+        return;
+    }
+    if (!locals.empty()) {
+        markLocals(def.body, locals);
+        def.locals = std::make_shared<const LocalNames>(std::move(locals));
+    }
+    const std::string_view defined = def.name;
+    if (!table.macros.try_emplace(name, std::move(def)).second) {
+        error(directive.location, "Macro '" + std::string(defined) + "' is already defined");
+    }
+}
+
+// .rept COUNT - the body up to the matching .endr, replayed COUNT times
+void MacroExpander::repeat(const MacroToken& directive) {
+    int64_t count = -1;
+    if (continuesLine()) {
+        const MacroToken token = read();
+        if (token.type == NUMBER && token.value.number.value.valid) {
+            count = token.value.number.value.value;
+        }
+    }
+    if (count < 0 || count > MAX_REPEAT_COUNT) {
+        error(directive.location, ".rept expects a count from 0 to " + std::to_string(MAX_REPEAT_COUNT));
+        count = 0;
+    }
+    expectLineEnd(directive);
+
+    auto body = std::make_shared<TokenList>();
+    LocalNames locals;
+    int depth = 0;
+    for (;;) {
+        const MacroToken token = read();
+        if (token.type == END) {
+            error(directive.location, "Missing .endr for .rept");
+            return;
+        }
+        if (token.type == DIRECTIVE) {
+            const std::string_view name = textOf(token);
+            if (name == ".rept") {
+                depth++;
+            } else if (name == ".endr" && depth-- == 0) {
+                expectLineEnd(token);
+                break;
+            } else if (name == ".local" && depth == 0) {
+                declareLocals(token, locals);
+                continue;
+            }
+        }
+        body->push_back(token);
+    }
+
+    if (frames.size() >= MAX_MACRO_DEPTH) {
+        error(directive.location, "Macros and .rept blocks are nested more than " +
+                                  std::to_string(MAX_MACRO_DEPTH) + " levels deep");
+        return;
+    }
+    // Already relocated if read from a macro expansion
+    if (count > 0 && !body->empty()) {
+        std::shared_ptr<const LocalNames> localNames;
+        if (!locals.empty()) {
+            markLocals(*body, locals);
+            localNames = std::make_shared<const LocalNames>(std::move(locals));
+        }
+        push(std::move(body), count - 1, false, directive.location, std::move(localNames));
+    }
+}
+
+bool MacroExpander::substitute(const MacroToken& token, const TokenList& argument, TokenList& out) {
+    if (token.type == IDENTIFIER) {
+        for (size_t i = 0; i < argument.size(); i++) {
+            MacroToken copy = argument[i];
+            copy.location = token.location;
+            copy.lineStart = token.lineStart && i == 0;
+            copy.parameter = -1;
+            out.push_back(copy);
+        }
+        return true;
+    }
+    if (argument.size() != 1) {
+        return false;
+    }
+
+    const MacroToken& arg = argument[0];
+    MacroToken copy = token;
+    copy.parameter = -1;
+    if (token.type == LABEL) {
+        if (arg.type != IDENTIFIER) {
+            return false;
+        }
+        copy.value.symbol = arg.value.symbol;
+        out.push_back(copy);
+        return true;
+    }
+
+    // #p and =p - a number or name argument gets the prefix, an argument
+    // that already has it is used as is
+    const bool immediate = token.type == IMMEDIATE_SYMBOL;
+    if (arg.type == (immediate ? IMMEDIATE : LABEL_IMMEDIATE) ||
+        arg.type == (immediate ? IMMEDIATE_SYMBOL : LABEL_IMMEDIATE_SYMBOL)) {
+        copy.type = arg.type;
+        copy.value = arg.value;
+        out.push_back(copy);
+        return true;
+    }
+    if (arg.type != NUMBER && arg.type != IDENTIFIER) {
+        return false;
+    }
+
+    // Error messages show operands with their prefix
+    const std::string_view text = textOf(arg);
+    char* prefixed = ctx.ast.arena.allocateArray<char>(text.size() + 1);
+    prefixed[0] = immediate ? '#' : '=';
+    std::memcpy(prefixed + 1, text.data(), text.size());
+    const TokenText prefixedText{prefixed, static_cast<int>(text.size() + 1)};
+    if (arg.type == NUMBER) {
+        copy.type = immediate ? IMMEDIATE : LABEL_IMMEDIATE;
+        copy.value.number = NumberToken{prefixedText, arg.value.number.value};
+    } else {
+        copy.value.symbol = SymbolToken{prefixedText, arg.value.symbol.sym};
+    }
+    out.push_back(copy);
+    return true;
+}
+
+void MacroExpander::invoke(MacroDef& def, const MacroToken& call) {
+    used = true;
+    table.invocations++;
+
+    // Arguments are the rest of the line, split at commas
+    std::vector<TokenList> arguments;
+    std::string key;
+    if (continuesLine()) {
+        arguments.emplace_back();
+        while (continuesLine()) {
+            const MacroToken token = read();
+            if (token.type == COMMA) {
+                arguments.emplace_back();
+            } else {
+                arguments.back().push_back(token);
+            }
+            // Names by their symbol: a renamed .local keeps its source text
+            key += static_cast<char>(token.type);
+            if (namesSymbol(token.type)) {
+                const SymbolId sym = token.value.symbol.sym;
+                key.append(reinterpret_cast<const char*>(&sym), sizeof(sym));
+            } else {
+                const std::string_view text = textOf(token);
+                key.append(text.data(), text.size());
+                key += '\0';
+            }
+        }
+    }
+
+    const std::string name(def.name);
+    if (arguments.size() != def.parameters.size()) {
+        const size_t expected = def.parameters.size();
+        error(call.location, "'" + name + "' expects " + std::to_string(expected) +
+                             (expected == 1 ? " argument, got " : " arguments, got ") +
+                             std::to_string(arguments.size()));
+        return;
+    }
+    for (size_t i = 0; i < arguments.size(); i++) {
+        if (arguments[i].empty()) {
+            error(call.location, "Argument " + std::to_string(i + 1) + " of '" + name + "' is empty");
+            return;
+        }
+    }
+    if (frames.size() >= MAX_MACRO_DEPTH) {
+        error(call.location, "Macros and .rept blocks are nested more than " +
+                             std::to_string(MAX_MACRO_DEPTH) + " levels deep");
+        return;
+    }
+
+    auto cached = def.expansions.find(key);
+    if (cached != def.expansions.end()) {
+        table.reused++;
+        push(cached->second, 0, true, call.location, def.locals);
+        return;
+    }
+
+    auto expansion = std::make_shared<TokenList>();
+    expansion->reserve(def.body.size());
+    bool valid = true;
+    for (const MacroToken& token : def.body) {
+        if (token.parameter < 0) {
+            expansion->push_back(token);
+        } else if (!substitute(token, arguments[token.parameter], *expansion)) {
+            error(call.location, "Argument " + std::to_string(token.parameter + 1) + " of '" + name +
+                                 "' cannot be used as " + std::string(textOf(token)));
+            valid = false;
+        }
+    }
+    // A failed expansion is dropped, so each invocation reports its error
+    if (valid) {
+        def.expansions.emplace(std::move(key), expansion);
+        push(std::move(expansion), 0, true, call.location, def.locals);
+    }
+}
+
+int MacroExpander::next(YYSTYPE& value, SourceLocation& location) {
+    for (;;) {
+        const MacroToken token = read();
+        if (token.type == END && !frames.empty()) {
+            Frame& frame = frames.back();
+            if (frame.repeat > 0) {
+                frame.repeat--;
+                frame.position = 0;
+                renameLocals(frame);
+            } else {
+                frames.pop_back();
+            }
+            continue;
+        }
+
+        if (token.type == DIRECTIVE) {
+            const std::string_view name = textOf(token);
+            if (name == ".macro") {
+                define(token);
+                continue;
+            }
+            if (name == ".rept") {
+                repeat(token);
+                continue;
+            }
+            if (name == ".endm" || name == ".endr") {
+                error(token.location, std::string(name) + (name == ".endm" ? " without .macro" : " without .rept"));
+                expectLineEnd(token);
+                continue;
+            }
+            if (name == ".local") {
+                error(token.location, ".local outside a .macro or .rept body");
+                while (continuesLine()) {
+                    read();
+                }
+                continue;
+            }
+        } else if (token.type == IDENTIFIER && (token.lineStart || lastType == LABEL)) {
+            // A statement starting with a name - no other statement does
+            auto it = table.macros.find(token.value.symbol.sym);
+            if (it != table.macros.end()) {
+                invoke(it->second, token);
+                continue;
+            }
+        }
+
+        value = token.value;
+        location = token.location;
+        lastType = token.type;
+        return token.type;
+    }
+}
+
+int yylex(YYSTYPE* lval, SourceLocation* lloc, MacroExpander& tokens) {
+    return tokens.next(*lval, *lloc);
+}
@@ -0,0 +1,138 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: .macro and .rept expansion between the scanner and the parser
+//
+//                  .macro NAME p1, p2      .rept COUNT
+//                  ...                     ...
+//                  .endm                   .endr
+//
+//              Bodies are recorded as scanned tokens and replayed into the
+//              parser, so no source text is rebuilt and rescanned. A
+//              parameter is substituted where the body names it as p, #p,
+//              =p or p:. A macro is invoked by its name at the start of a
+//              statement, with the arguments as the rest of the line.
+//              Each distinct argument list is expanded once per macro and
+//              replayed from then on. Expanded statements take the
+//              location of the invocation, .rept bodies keep their own.
+//              Names listed by .local in a body are renamed to name@N, a
+//              fresh N for every expansion and every .rept pass.
+// ============================================================================
+
+#pragma once
+#include "common.h"
+#include "parser.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+constexpr size_t MAX_MACRO_DEPTH = 64;          // Nested invocations and .rept blocks
+constexpr int64_t MAX_REPEAT_COUNT = 65536;     // One word per pass fills the address space
+
+struct MacroToken {
+    int type;
+    YYSTYPE value;
+    SourceLocation location;
+    bool lineStart;             // First token on its source line
+    int parameter;              // Macro parameter it names, -1 if none
+    int local;                  // .local name of its body it names, -1 if none
+};
+
+using TokenList = std::vector<MacroToken>;
+using LocalNames = std::vector<SymbolId>;
+
+struct MacroDef {
+    std::string_view name;
+    std::vector<SymbolId> parameters;
+    TokenList body;
+    std::shared_ptr<const LocalNames> locals;
+    std::unordered_map<std::string, std::shared_ptr<const TokenList>> expansions;  // By argument tokens
+};
+
+// Macros of one assembly - shared by the main source and its includes
+class MacroTable {
+private:
+    std::unordered_map<SymbolId, MacroDef> macros;
+    size_t invocations = 0;
+    size_t reused = 0;          // Invocations replayed from an earlier expansion
+    size_t renamed = 0;         // .local names made so far - numbers the next one
+
+    friend class MacroExpander;
+
+public:
+    const MacroDef* find(SymbolId name) const {
+        auto it = macros.find(name);
+        return it == macros.end() ? nullptr : &it->second;
+    }
+
+    size_t size() const { return macros.size(); }
+    size_t getInvocations() const { return invocations; }
+    size_t getReused() const { return reused; }
+};
+
+// Token source of one yyparse() - reads the scanner and replays macro and
+// .rept bodies in its place
+class MacroExpander {
+private:
+    // Body being replayed
+    struct Frame {
+        std::shared_ptr<const TokenList> tokens;
+        size_t position;
+        int64_t repeat;             // Passes left after this one
+        bool relocate;              // Tokens take 'location' (macro expansions)
+        SourceLocation location;
+        std::shared_ptr<const LocalNames> localNames;   // .local names of the body
+        LocalNames locals;          // Their names in this pass
+    };
+
+    ParseContext& ctx;
+    void* scanner;
+    MacroTable& table;
+    std::vector<Frame> frames;
+    MacroToken pending;             // Scanned ahead by continuesLine()
+    bool hasPending = false;
+    int lastLine = 0;               // Line of the last scanned token
+    int lastType = END;             // Last token handed to the parser
+    bool used = false;
+
+    MacroToken scan();
+
+    // Next token of the innermost source - END at the end of a body
+    MacroToken read();
+
+    // Whether the next token of the innermost source is on the current line
+    bool continuesLine();
+
+    void error(const SourceLocation& at, const std::string& message);
+
+    // Report and drop the rest of the line after 'directive'
+    void expectLineEnd(const MacroToken& directive);
+
+    // .local a, b - adds the names to 'locals'
+    void declareLocals(const MacroToken& directive, LocalNames& locals);
+
+    // Mark the tokens of 'body' that name one of 'locals'
+    static void markLocals(TokenList& body, const LocalNames& locals);
+
+    // Fresh names for the .local names of 'frame'
+    void renameLocals(Frame& frame);
+
+    void define(const MacroToken& directive);
+    void repeat(const MacroToken& directive);
+    void invoke(MacroDef& def, const MacroToken& call);
+
+    // Append the argument for 'token' to 'out', adapted to its prefix
+    bool substitute(const MacroToken& token, const TokenList& argument, TokenList& out);
+
+    void push(std::shared_ptr<const TokenList> tokens, int64_t passes, bool relocate, const SourceLocation& at,
+              std::shared_ptr<const LocalNames> localNames);
+
+public:
+    MacroExpander(ParseContext& context, void* scannerState);
+
+    int next(YYSTYPE& value, SourceLocation& location);
+
+    // A macro was defined or invoked - the parse depends on more than the file
+    bool usedMacros() const { return used; }
+};
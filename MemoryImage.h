@@ -0,0 +1,158 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Sparse memory image built by the encoder
+//              The image is a list of contiguous segments. Code and data
+//              segments own their words, fill segments (.space, .org padding)
+//              only store a value and a length - memory and time scale with
+//              the emitted words, not with the address span.
+// ============================================================================
+
+#pragma once
+#include "common.h"
+#include <vector>
+#include <stdexcept>
+
+constexpr uint32_t ADDRESS_SPACE_WORDS = 0x10000;   // 16-bit word address space
+
+enum class SegmentKind : uint8_t {
+    CODE,   // Encoded instructions
+    DATA,   // .word, .ascii, .asciiz
+    FILL    // .space and .org padding - one repeated value, no storage
+};
+
+struct Segment {
+    uint32_t address;   // First word address
+    uint32_t length;    // Length in words
+    uint32_t offset;    // Index of the first word in MemoryImage::words (CODE/DATA)
+    uint16_t fill;      // Repeated value (FILL)
+    SegmentKind kind;
+
+    uint32_t end() const { return address + length; }
+    bool isData() const { return kind != SegmentKind::CODE; }
+};
+
+class MemoryImage {
+private:
+    std::vector<Segment> segments;
+    std::vector<uint16_t> words;    // Backing store of all CODE/DATA segments
+    uint32_t endAddress = 0;
+
+    void checkSpace(uint64_t count) const {
+        if (endAddress + count > ADDRESS_SPACE_WORDS) {
+            throw std::runtime_error("Program exceeds the 16-bit address space (" +
+                                     std::to_string(endAddress + count) + " words)");
+        }
+    }
+
+    // True if the next word cannot extend the last segment (kind change or
+    // a skipTo() gap)
+    bool startsSegment(SegmentKind kind) const {
+        return segments.empty() || segments.back().kind != kind || segments.back().end() != endAddress;
+    }
+
+public:
+    // Address one past the last word - the span the writers cover
+    uint32_t size() const { return endAddress; }
+    bool empty() const { return endAddress == 0; }
+
+    // Number of words actually stored (excluding fills)
+    size_t storedWords() const { return words.size(); }
+
+    const std::vector<Segment>& getSegments() const { return segments; }
+
+    void reserve(size_t wordCount) { words.reserve(wordCount); }
+
+    void clear() {
+        segments.clear();
+        words.clear();
+        endAddress = 0;
+    }
+
+    // Append one CODE or DATA word at the current end address
+    void emit(uint16_t word, SegmentKind kind) {
+        checkSpace(1);
+        if (startsSegment(kind)) {
+            segments.push_back({endAddress, 0, static_cast<uint32_t>(words.size()), 0, kind});
+        }
+        words.push_back(word);
+        segments.back().length++;
+        endAddress++;
+    }
+
+    // Append 'count' zeroed CODE or DATA words to be written in place later.
+    // Returns the backing index of the first word.
+    size_t append(uint32_t count, SegmentKind kind) {
+        const size_t index = words.size();
+        if (count == 0) {
+            return index;
+        }
+        checkSpace(count);
+        if (startsSegment(kind)) {
+            segments.push_back({endAddress, 0, static_cast<uint32_t>(index), 0, kind});
+        }
+        words.resize(index + count);
+        segments.back().length += count;
+        endAddress += count;
+        return index;
+    }
+
+    // Append 'count' copies of 'value' without storing them
+    void fill(uint64_t count, uint16_t value = 0) {
+        if (count == 0) {
+            return;
+        }
+        checkSpace(count);
+        Segment* last = startsSegment(SegmentKind::FILL) ? nullptr : &segments.back();
+        if (last != nullptr && last->fill == value) {
+            last->length += static_cast<uint32_t>(count);
+        } else {
+            segments.push_back({endAddress, static_cast<uint32_t>(count), 0, value, SegmentKind::FILL});
+        }
+        endAddress += static_cast<uint32_t>(count);
+    }
+
+    // Pad with zeros up to 'address' (.org)
+    void advanceTo(uint64_t address) {
+        if (address > endAddress) {
+            fill(address - endAddress);
+        }
+    }
+
+    // Move the end address to 'address' without filling the words in
+    // between - only for relocatable objects, whose gaps the linker fills.
+    // Writers expect contiguous segments.
+    void skipTo(uint32_t address) {
+        if (address > endAddress) {
+            checkSpace(address - endAddress);
+            endAddress = address;
+        }
+    }
+
+    // OR 'bits' into a stored word by backing index (fixups)
+    void patch(size_t index, uint16_t bits) { words[index] |= bits; }
+
+    // Writable backing store for words reserved with append()
+    uint16_t* storage() { return words.data(); }
+
+    // Word at 'address' inside segment 'seg'
+    uint16_t wordAt(const Segment& seg, uint32_t address) const {
+        return seg.kind == SegmentKind::FILL ? seg.fill : words[seg.offset + (address - seg.address)];
+    }
+
+    // Direct access to the stored words of a CODE/DATA segment
+    const uint16_t* segmentWords(const Segment& seg) const {
+        return words.data() + seg.offset;
+    }
+
+    // Call fn(address, word, isData) for every address in order
+    template <typename Fn>
+    void forEachWord(Fn&& fn) const {
+        for (const Segment& seg : segments) {
+            const bool data = seg.isData();
+            for (uint32_t i = 0; i < seg.length; i++) {
+                fn(seg.address + i, wordAt(seg, seg.address + i), data);
+            }
+        }
+    }
+};
@@ -0,0 +1,55 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Numeric literal parsing shared by the scanners and main
+//              Numbers are converted once, when they are scanned, so the
+//              encoder passes never parse text. No allocation, no
+//              exceptions.
+// ============================================================================
+
+#pragma once
+#include "common.h"
+#include <charconv>
+#include <limits>
+#include <string_view>
+
+// Parse all of 'text' as a number: decimal with an optional '-', 0x hex,
+// 0b binary, or octal with a leading 0 (as the encoder's former
+// std::stoll(text, nullptr, 0) read it). Returns false if anything but the
+// number is left over or the value does not fit int64_t.
+inline bool parseNumber(std::string_view text, int64_t& value) {
+    const char* first = text.data();
+    const char* last = first + text.size();
+    const bool negative = first != last && *first == '-';
+    if (negative) {
+        first++;
+    }
+
+    int base = 10;
+    if (last - first > 2 && first[0] == '0' && (first[1] == 'x' || first[1] == 'X')) {
+        base = 16;
+        first += 2;
+    } else if (last - first > 2 && first[0] == '0' && (first[1] == 'b' || first[1] == 'B')) {
+        base = 2;
+        first += 2;
+    } else if (last - first > 1 && first[0] == '0') {
+        base = 8;
+        first++;
+    }
+    if (first == last) {
+        return false;
+    }
+
+    uint64_t magnitude = 0;
+    const auto [end, error] = std::from_chars(first, last, magnitude, base);
+    if (error != std::errc() || end != last) {
+        return false;
+    }
+    constexpr uint64_t maxPositive = static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
+    if (magnitude > maxPositive + (negative ? 1 : 0)) {
+        return false;
+    }
+    // -(magnitude - 1) - 1 also covers INT64_MIN
+    value = negative ? -static_cast<int64_t>(magnitude - 1) - 1 : static_cast<int64_t>(magnitude);
+    return true;
+}
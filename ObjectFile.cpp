@@ -0,0 +1,251 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Object file implementation
+//
+// Layout (native byte order, like the parse cache):
+//   header       "SBOB", version, flags, file count, segment count,
+//                symbol count, relocation count
+//   files        one string per source file
+//   segments     address, length, kind, then the fill value (FILL) or
+//                'length' words (CODE, DATA), in address order
+//   symbols      name, binding, kind, value
+//   relocations  word index, address, symbol index, kind, mnemonic index,
+//                file, line
+// ============================================================================
+
+#include "ObjectFile.h"
+#include "ByteStream.h"
+#include "InstructionDef.h"
+#include "OutputWriter.h"
+#include "SourceFile.h"
+#include <stdexcept>
+
+static const char OBJECT_MAGIC[4] = {'S', 'B', 'O', 'B'};
+constexpr uint16_t NO_MNEMONIC = 0xFFFF;
+
+enum : uint8_t {
+    OBJECT_ABSOLUTE = 1 << 0
+};
+
+ObjectModule buildObject(const ProgramAST& ast, const SymbolTable& symbolTable, const Encoder& encoder) {
+    ObjectModule module;
+    module.absolute = encoder.isAbsoluteModule();
+    module.image = encoder.getImage();
+    for (size_t i = 0; i < ast.fileCount(); i++) {
+        module.files.push_back(ast.fileName(static_cast<uint16_t>(i)));
+    }
+
+    // Every symbol once - exports first, so a symbol that is exported and
+    // relocated is GLOBAL. Exports the module does not define are imports.
+    std::unordered_map<SymbolId, uint32_t> indices;
+    const auto add = [&](SymbolId id, SymbolBinding binding) {
+        auto [it, inserted] = indices.emplace(id, static_cast<uint32_t>(module.symbols.size()));
+        if (inserted) {
+            const Symbol sym = symbolTable.lookup(id);
+            module.symbols.push_back({std::string(symbolTable.getName(id)),
+                                      sym.kind == SymbolKind::UNDEFINED ? SymbolBinding::EXTERN : binding,
+                                      sym.kind, sym.value});
+        }
+        return it->second;
+    };
+    for (const Statement& stmt : ast) {
+        if (stmt.type == StatementType::DIRECTIVE && stmt.directive.name == ".global") {
+            for (size_t i = 0; i < stmt.directive.count(); i++) {
+                add(stmt.directive.item(i).symbol, SymbolBinding::GLOBAL);
+            }
+        }
+    }
+    for (const Fixup& relocation : encoder.getRelocations()) {
+        module.relocations.push_back({relocation.index, relocation.address,
+                                      add(relocation.symbol, SymbolBinding::LOCAL), relocation.kind,
+                                      relocation.def, relocation.stmt->file, relocation.stmt->line});
+    }
+    return module;
+}
+
+// ============================================================================
+// Writing
+// ============================================================================
+
+std::string serializeObject(const ObjectModule& module) {
+    const MemoryImage& image = module.image;
+    std::string data;
+    ByteWriter out(data);
+    data.append(OBJECT_MAGIC, sizeof(OBJECT_MAGIC));
+    out.put(OBJECT_VERSION);
+    out.put(static_cast<uint8_t>(module.absolute ? OBJECT_ABSOLUTE : 0));
+    out.put(static_cast<uint32_t>(module.files.size()));
+    out.put(static_cast<uint32_t>(image.getSegments().size()));
+    out.put(static_cast<uint32_t>(module.symbols.size()));
+    out.put(static_cast<uint32_t>(module.relocations.size()));
+
+    for (const std::string& file : module.files) {
+        out.putString(file);
+    }
+    for (const Segment& seg : image.getSegments()) {
+        out.put(seg.address);
+        out.put(seg.length);
+        out.put(static_cast<uint8_t>(seg.kind));
+        if (seg.kind == SegmentKind::FILL) {
+            out.put(seg.fill);
+        } else {
+            out.putBytes(image.segmentWords(seg), seg.length * sizeof(uint16_t));
+        }
+    }
+    for (const ObjectSymbol& sym : module.symbols) {
+        out.putString(sym.name);
+        out.put(static_cast<uint8_t>(sym.binding));
+        out.put(static_cast<uint8_t>(sym.kind));
+        out.put(sym.value);
+    }
+    for (const ObjectRelocation& relocation : module.relocations) {
+        out.put(relocation.index);
+        out.put(relocation.address);
+        out.put(relocation.symbol);
+        out.put(static_cast<uint8_t>(relocation.kind));
+        out.put(relocation.def ? static_cast<uint16_t>(relocation.def - INSTRUCTIONS) : NO_MNEMONIC);
+        out.put(relocation.file);
+        out.put(relocation.line);
+    }
+    return data;
+}
+
+void writeObjectFile(const ObjectModule& module, std::string& path) {
+    if (path.size() < OBJECT_EXTENSION.size() ||
+        std::string_view(path).substr(path.size() - OBJECT_EXTENSION.size()) != OBJECT_EXTENSION) {
+        path += OBJECT_EXTENSION;
+    }
+    OutputBuffer out;
+    out.append(serializeObject(module));
+    out.writeToFile(path);
+}
+
+// ============================================================================
+// Loading
+// ============================================================================
+
+namespace {
+
+// Segments must be in address order and inside the address space; the
+// image is rebuilt with the same backing store order, so relocation word
+// indices stay valid
+bool readSegment(ByteReader& in, MemoryImage& image) {
+    uint32_t address = 0;
+    uint32_t length = 0;
+    uint8_t kind = 0;
+    if (!in.get(address) || !in.get(length) || !in.get(kind) || kind > static_cast<uint8_t>(SegmentKind::FILL) ||
+        address < image.size() || length == 0 || static_cast<uint64_t>(address) + length > ADDRESS_SPACE_WORDS) {
+        return false;
+    }
+    image.skipTo(address);
+    if (static_cast<SegmentKind>(kind) == SegmentKind::FILL) {
+        uint16_t fill = 0;
+        if (!in.get(fill)) {
+            return false;
+        }
+        image.fill(length, fill);
+        return true;
+    }
+    if (in.remaining() / sizeof(uint16_t) < length) {
+        return false;
+    }
+    const size_t index = image.append(length, static_cast<SegmentKind>(kind));
+    return in.getBytes(image.storage() + index, length * sizeof(uint16_t));
+}
+
+bool readSymbol(ByteReader& in, ObjectSymbol& sym) {
+    std::string_view name;
+    uint8_t binding = 0;
+    uint8_t kind = 0;
+    if (!in.getString(name) || !in.get(binding) || !in.get(kind) || !in.get(sym.value) ||
+        binding > static_cast<uint8_t>(SymbolBinding::EXTERN) || kind > static_cast<uint8_t>(SymbolKind::DEFINE)) {
+        return false;
+    }
+    sym.name = std::string(name);
+    sym.binding = static_cast<SymbolBinding>(binding);
+    sym.kind = static_cast<SymbolKind>(kind);
+    return (sym.binding == SymbolBinding::EXTERN) == (sym.kind == SymbolKind::UNDEFINED);
+}
+
+bool readRelocation(ByteReader& in, const ObjectModule& module, ObjectRelocation& relocation) {
+    uint8_t kind = 0;
+    uint16_t mnemonic = 0;
+    if (!in.get(relocation.index) || !in.get(relocation.address) || !in.get(relocation.symbol) ||
+        !in.get(kind) || !in.get(mnemonic) || !in.get(relocation.file) || !in.get(relocation.line) ||
+        kind > static_cast<uint8_t>(FixupKind::ADDRESS) || relocation.index >= module.image.storedWords() ||
+        relocation.symbol >= module.symbols.size() || relocation.file >= module.files.size() ||
+        (mnemonic != NO_MNEMONIC && mnemonic >= std::size(INSTRUCTIONS))) {
+        return false;
+    }
+    relocation.kind = static_cast<FixupKind>(kind);
+    relocation.def = mnemonic == NO_MNEMONIC ? nullptr : &INSTRUCTIONS[mnemonic];
+    // Every field but .word checks its range against the instruction
+    return relocation.def != nullptr || relocation.kind == FixupKind::WORD;
+}
+
+} // namespace
+
+bool decodeObject(std::string_view data, ObjectModule& module) {
+    ByteReader in(data.data(), data.size());
+    uint32_t version = 0;
+    uint8_t flags = 0;
+    uint32_t fileCount = 0;
+    uint32_t segmentCount = 0;
+    uint32_t symbolCount = 0;
+    uint32_t relocationCount = 0;
+    if (data.size() < sizeof(OBJECT_MAGIC) || memcmp(data.data(), OBJECT_MAGIC, sizeof(OBJECT_MAGIC)) != 0 ||
+        !in.skip(sizeof(OBJECT_MAGIC)) || !in.get(version) || !in.get(flags) || !in.get(fileCount) ||
+        !in.get(segmentCount) || !in.get(symbolCount) || !in.get(relocationCount) ||
+        version != OBJECT_VERSION || fileCount == 0 || fileCount > UINT16_MAX + 1u) {
+        return false;
+    }
+
+    // Counts are checked against the bytes left before anything is sized by them
+    module = ObjectModule();
+    module.absolute = (flags & OBJECT_ABSOLUTE) != 0;
+    for (uint32_t i = 0; i < fileCount; i++) {
+        std::string_view file;
+        if (!in.getString(file)) {
+            return false;
+        }
+        module.files.emplace_back(file);
+    }
+    if (segmentCount > in.remaining()) {
+        return false;
+    }
+    for (uint32_t i = 0; i < segmentCount; i++) {
+        if (!readSegment(in, module.image)) {
+            return false;
+        }
+    }
+    if (symbolCount > in.remaining()) {
+        return false;
+    }
+    module.symbols.resize(symbolCount);
+    for (ObjectSymbol& sym : module.symbols) {
+        if (!readSymbol(in, sym)) {
+            return false;
+        }
+    }
+    if (relocationCount > in.remaining()) {
+        return false;
+    }
+    module.relocations.resize(relocationCount);
+    for (ObjectRelocation& relocation : module.relocations) {
+        if (!readRelocation(in, module, relocation)) {
+            return false;
+        }
+    }
+    return in.done();
+}
+
+ObjectModule readObjectFile(const std::string& path) {
+    SourceFile file(path);
+    ObjectModule module;
+    if (!decodeObject(file.text(), module)) {
+        throw std::runtime_error("Not a valid sbasm object (version " + std::to_string(OBJECT_VERSION) +
+                                 "): " + path);
+    }
+    return module;
+}
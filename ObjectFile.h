@@ -0,0 +1,71 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Relocatable object files (sbasm -c) for sblink
+//              An object holds the encoded words of one module, the symbols
+//              it exports with .global and the relocations the linker has to
+//              fill in: fields naming a label of the module, which moves with
+//              it, and fields naming a symbol of another module. A module
+//              without .org is relocatable and placed by the linker; one with
+//              .org is absolute and keeps its addresses.
+// ============================================================================
+
+#pragma once
+#include "common.h"
+#include "ast.h"
+#include "InstructionEncoder.h"
+#include "MemoryImage.h"
+#include "SymbolTable.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+constexpr uint32_t OBJECT_VERSION = 1;     // Bump when the layout changes
+constexpr std::string_view OBJECT_EXTENSION = ".o";
+
+enum class SymbolBinding : uint8_t {
+    LOCAL,      // Label of the module named by a relocation
+    GLOBAL,     // Exported with .global
+    EXTERN      // Defined by another module
+};
+
+struct ObjectSymbol {
+    std::string name;
+    SymbolBinding binding;
+    SymbolKind kind;        // UNDEFINED for EXTERN
+    int32_t value;          // Labels of a relocatable module: offset from its start
+};
+
+struct ObjectRelocation {
+    uint32_t index;                 // Word index in the image's backing store
+    uint32_t address;               // Word address, from the module start unless absolute
+    uint32_t symbol;                // Index into ObjectModule::symbols
+    FixupKind kind;
+    const InstructionDef* def;      // Instruction for range checks, nullptr for .word
+    uint16_t file;                  // Index into ObjectModule::files
+    int32_t line;
+};
+
+struct ObjectModule {
+    bool absolute = false;              // Uses .org - placed at its own addresses
+    MemoryImage image;                  // Relocated fields cleared, .org gaps not filled
+    std::vector<std::string> files;     // Source files, [0] = main source
+    std::vector<ObjectSymbol> symbols;
+    std::vector<ObjectRelocation> relocations;
+};
+
+// Object of a successful encode() with object output enabled
+ObjectModule buildObject(const ProgramAST& ast, const SymbolTable& symbolTable, const Encoder& encoder);
+
+std::string serializeObject(const ObjectModule& module);
+
+// Decode 'data' into 'module'. Returns false if it is not a valid object of
+// this version.
+bool decodeObject(std::string_view data, ObjectModule& module);
+
+// Write the object to 'path', appending OBJECT_EXTENSION if it does not
+// already end with it. Throws if the file cannot be written.
+void writeObjectFile(const ObjectModule& module, std::string& path);
+
+// Throws if the file cannot be read or is not a valid object
+ObjectModule readObjectFile(const std::string& path);
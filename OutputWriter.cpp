@@ -0,0 +1,409 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Output writer implementations (MIF, Intel HEX, Verilog, binary)
+// ============================================================================
+
+#include "OutputWriter.h"
+#include "InstructionDef.h"
+#include <cstdio>
+#include <stdexcept>
+
+// ============================================================================
+// OutputBuffer
+// ============================================================================
+
+void OutputBuffer::hex(uint32_t value, int width, char fill) {
+    static const char digits[] = "0123456789abcdef";
+    char tmp[8];
+    int n = 0;
+    do {
+        tmp[n++] = digits[value & 0xF];
+        value >>= 4;
+    } while (value != 0);
+
+    char* p = extend(width > n ? width : n);
+    for (int i = n; i < width; i++) {
+        *p++ = fill;
+    }
+    while (n > 0) {
+        *p++ = tmp[--n];
+    }
+}
+
+void OutputBuffer::hexUpper(uint32_t value, int width) {
+    static const char digits[] = "0123456789ABCDEF";
+    char* p = extend(width);
+    for (int i = width - 1; i >= 0; i--) {
+        p[i] = digits[value & 0xF];
+        value >>= 4;
+    }
+}
+
+void OutputBuffer::decimal(uint64_t value) {
+    char tmp[20];
+    int n = 0;
+    do {
+        tmp[n++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    char* p = extend(n);
+    while (n > 0) {
+        *p++ = tmp[--n];
+    }
+}
+
+void OutputBuffer::writeToFile(const std::string& path) const {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        throw std::runtime_error("Could not open output file: " + path);
+    }
+    size_t written = fwrite(data.data(), 1, data.size(), file);
+    if (fclose(file) != 0 || written != data.size()) {
+        throw std::runtime_error("Failed to write output file: " + path);
+    }
+}
+
+// ============================================================================
+// Shared helpers
+// ============================================================================
+
+// Disassembly or data comment for one word into the buffer
+static void appendComment(uint16_t word, uint32_t address, bool data,
+                          DisassemblyTable& disasm, OutputBuffer& out)
+{
+    char* text = out.extend(DISASM_MAX_LENGTH);
+    size_t length = data ? formatDataWordInto(word, text) : disasm.format(word, address, text);
+    out.shrink(DISASM_MAX_LENGTH - length);
+}
+
+// Sequential reader over the image segments
+class ImageCursor {
+private:
+    const MemoryImage& image;
+    const std::vector<Segment>& segments;
+    size_t index = 0;
+    uint32_t address = 0;
+
+public:
+    explicit ImageCursor(const MemoryImage& img) : image(img), segments(img.getSegments()) {}
+
+    bool done() const { return index >= segments.size(); }
+    uint32_t getAddress() const { return address; }
+    const Segment& segment() const { return segments[index]; }
+    uint16_t word() const { return image.wordAt(segments[index], address); }
+    bool isData() const { return segments[index].isData(); }
+
+    // Words left in the current segment
+    uint32_t remaining() const { return segments[index].end() - address; }
+
+    // Move forward 'count' words, crossing segment boundaries as needed
+    void skip(uint32_t count) {
+        while (count > 0 && !done()) {
+            const uint32_t step = count < remaining() ? count : remaining();
+            address += step;
+            count -= step;
+            if (address == segments[index].end()) {
+                index++;
+            }
+        }
+    }
+};
+
+// Number of consecutive words equal to 'word' with the same data flag,
+// starting at the cursor. Fill segments are measured without walking them.
+static uint32_t measureRun(ImageCursor cursor, uint16_t word, bool data) {
+    uint32_t run = 0;
+    while (!cursor.done() && cursor.isData() == data) {
+        const Segment& seg = cursor.segment();
+        if (seg.kind == SegmentKind::FILL) {
+            if (seg.fill != word) {
+                break;
+            }
+            const uint32_t count = cursor.remaining();
+            run += count;
+            cursor.skip(count);
+        } else {
+            if (cursor.word() != word) {
+                break;
+            }
+            run++;
+            cursor.skip(1);
+        }
+    }
+    return run;
+}
+
+// ============================================================================
+// Memory depth
+// ============================================================================
+
+static int nextPowerOfTwo(size_t value) {
+    size_t depth = 1;
+    while (depth < value) {
+        depth <<= 1;
+    }
+    return static_cast<int>(depth);
+}
+
+int resolveMemoryDepth(size_t imageSize, int requested) {
+    if (imageSize > static_cast<size_t>(MAX_MEMORY_DEPTH)) {
+        throw std::runtime_error("Program size " + std::to_string(imageSize) +
+                                 " words exceeds the 16-bit address space");
+    }
+    if (requested == DEPTH_AUTO) {
+        return nextPowerOfTwo(imageSize);
+    }
+    if (requested == DEPTH_DEFAULT) {
+        return imageSize <= static_cast<size_t>(DEFAULT_MEMORY_DEPTH) ? DEFAULT_MEMORY_DEPTH
+                                                                      : nextPowerOfTwo(imageSize);
+    }
+    if (requested < 1 || requested > MAX_MEMORY_DEPTH) {
+        throw std::runtime_error("Memory depth must be between 1 and " + std::to_string(MAX_MEMORY_DEPTH));
+    }
+    if (imageSize > static_cast<size_t>(requested)) {
+        throw std::runtime_error("Program size " + std::to_string(imageSize) +
+                                 " words exceeds memory depth " + std::to_string(requested));
+    }
+    return requested;
+}
+
+// ============================================================================
+// MIF Writer - Uses disassembly from InstructionDef.h
+// ============================================================================
+
+void writeMIF(const MemoryImage& image, const OutputOptions& options, OutputBuffer& out) {
+    const size_t size = image.size();
+    const size_t depth = static_cast<size_t>(options.depth);
+    const size_t lines = options.compress ? image.storedWords() + image.getSegments().size() : size;
+    out.reserve(128 + lines * (options.comments ? 64 : 16));
+
+    // MIF header
+    out.append("WIDTH = 16;\n");
+    out.append("DEPTH = ");
+    out.decimal(options.depth);
+    out.append(";\n");
+    out.append("ADDRESS_RADIX = HEX;\n");
+    out.append("DATA_RADIX = HEX;\n\n");
+    out.append("CONTENT\n");
+    out.append("BEGIN\n");
+
+    // Write each word, optionally with disassembly comment. Runs of the same
+    // word (.space/.org padding) become a single [first..last] range line.
+    DisassemblyTable disasm;
+    ImageCursor cursor(image);
+    size_t next = 0;
+    while (!cursor.done()) {
+        const size_t i = cursor.getAddress();
+        const uint16_t word = cursor.word();
+        const bool data = cursor.isData();
+
+        // Branch comments depend on the address, so those words stay separate
+        size_t run = 1;
+        if (options.compress && (data || !options.comments || !isBranchWord(word))) {
+            run = measureRun(cursor, word, data);
+        }
+
+        // A trailing run of zeros absorbs the zero fill up to DEPTH
+        size_t last = i + run - 1;
+        if (options.compress && word == 0 && i + run == size && size < depth) {
+            last = depth - 1;
+        }
+
+        if (last - i + 1 >= MIF_MIN_RUN) {
+            out.put('[');
+            out.hex(static_cast<uint32_t>(i), 1);
+            out.append("..");
+            out.hex(static_cast<uint32_t>(last), 1);
+            out.append("] : ");
+        } else {
+            // Address column
+            run = 1;
+            last = i;
+            out.hex(static_cast<uint32_t>(i), 3, ' ');
+            out.append("    : ");
+        }
+
+        // Data column
+        out.hex(word, 4);
+        out.put(';');
+
+        if (options.comments) {
+            out.append("        % ");
+            appendComment(word, static_cast<uint32_t>(i), data, disasm, out);
+            out.append(" %");
+        }
+        out.put('\n');
+
+        cursor.skip(static_cast<uint32_t>(run));
+        next = last + 1;
+    }
+
+    // Fill remaining addresses with zeros
+    if (next < depth) {
+        out.put('[');
+        out.hex(static_cast<uint32_t>(next), 1);
+        out.append("..");
+        out.hex(static_cast<uint32_t>(depth - 1), 1);
+        out.append("] : 0000;\n");
+    }
+
+    out.append("END;\n");
+}
+
+// ============================================================================
+// Intel HEX Writer - word addressed, as used by Quartus for 16-bit memories
+// ============================================================================
+
+static void appendHexRecord(OutputBuffer& out, uint8_t type, uint16_t address,
+                            const uint8_t* bytes, size_t count)
+{
+    uint8_t checksum = static_cast<uint8_t>(count) + (address >> 8) + (address & 0xFF) + type;
+    out.put(':');
+    out.hexUpper(static_cast<uint32_t>(count), 2);
+    out.hexUpper(address, 4);
+    out.hexUpper(type, 2);
+    for (size_t i = 0; i < count; i++) {
+        out.hexUpper(bytes[i], 2);
+        checksum += bytes[i];
+    }
+    out.hexUpper(static_cast<uint8_t>(-checksum), 2);
+    out.put('\n');
+}
+
+void writeIntelHex(const MemoryImage& image, const OutputOptions&, OutputBuffer& out) {
+    constexpr size_t WORDS_PER_RECORD = 8;
+    out.reserve(64 + (image.size() / WORDS_PER_RECORD + 1) * 48);
+
+    uint8_t bytes[WORDS_PER_RECORD * 2];
+    size_t count = 0;
+    uint32_t base = 0;
+    uint32_t upper = 0;
+
+    auto flush = [&]() {
+        // Extended linear address record when crossing a 64K word boundary
+        if ((base >> 16) != upper) {
+            upper = base >> 16;
+            uint8_t ext[2] = {static_cast<uint8_t>(upper >> 8), static_cast<uint8_t>(upper)};
+            appendHexRecord(out, 0x04, 0, ext, 2);
+        }
+        appendHexRecord(out, 0x00, static_cast<uint16_t>(base & 0xFFFF), bytes, count);
+        base += static_cast<uint32_t>(count / 2);
+        count = 0;
+    };
+
+    image.forEachWord([&](uint32_t, uint16_t word, bool) {
+        bytes[count++] = static_cast<uint8_t>(word >> 8);    // Big-endian words
+        bytes[count++] = static_cast<uint8_t>(word & 0xFF);
+        if (count == sizeof(bytes)) {
+            flush();
+        }
+    });
+    if (count > 0) {
+        flush();
+    }
+
+    appendHexRecord(out, 0x01, 0, nullptr, 0);
+}
+
+// ============================================================================
+// Verilog $readmemh Writer
+// ============================================================================
+
+void writeVerilogHex(const MemoryImage& image, const OutputOptions& options, OutputBuffer& out) {
+    out.reserve(64 + image.size() * (options.comments ? 48 : 5));
+
+    out.append("// qCore memory image: ");
+    out.decimal(image.size());
+    out.append(" of ");
+    out.decimal(options.depth);
+    out.append(" words\n");
+
+    DisassemblyTable disasm;
+    image.forEachWord([&](uint32_t address, uint16_t word, bool data) {
+        out.hex(word, 4);
+        if (options.comments) {
+            out.append("  // ");
+            out.hex(address, 3, ' ');
+            out.append(": ");
+            appendComment(word, address, data, disasm, out);
+        }
+        out.put('\n');
+    });
+}
+
+// ============================================================================
+// Raw Binary Writer
+// ============================================================================
+
+void writeBinary(const MemoryImage& image, const OutputOptions&, OutputBuffer& out) {
+    char* p = out.extend(static_cast<size_t>(image.size()) * 2);
+    for (const Segment& seg : image.getSegments()) {
+        if (seg.kind == SegmentKind::FILL) {
+            for (uint32_t i = 0; i < seg.length; i++) {
+                *p++ = static_cast<char>(seg.fill & 0xFF);
+                *p++ = static_cast<char>(seg.fill >> 8);
+            }
+            continue;
+        }
+        const uint16_t* words = image.segmentWords(seg);
+        for (uint32_t i = 0; i < seg.length; i++) {
+            *p++ = static_cast<char>(words[i] & 0xFF);
+            *p++ = static_cast<char>(words[i] >> 8);
+        }
+    }
+}
+
+// ============================================================================
+// Format lookup and file output
+// ============================================================================
+
+const OutputFormatDef* getOutputFormatDef(std::string_view name) {
+    for (const auto& def : OUTPUT_FORMATS) {
+        if (def.name == name) {
+            return &def;
+        }
+    }
+    return nullptr;
+}
+
+const OutputFormatDef* getOutputFormatDef(OutputFormat format) {
+    for (const auto& def : OUTPUT_FORMATS) {
+        if (def.format == format) {
+            return &def;
+        }
+    }
+    return nullptr;
+}
+
+static const OutputFormatDef& requireFormatDef(OutputFormat format) {
+    const OutputFormatDef* def = getOutputFormatDef(format);
+    if (def == nullptr) {
+        throw std::runtime_error("Unsupported output format");
+    }
+    return *def;
+}
+
+void addOutputExtension(std::string& outputFile, OutputFormat format) {
+    const std::string_view ext = requireFormatDef(format).extension;
+    if (outputFile.size() < ext.size() ||
+        std::string_view(outputFile).substr(outputFile.size() - ext.size()) != ext) {
+        outputFile += ext;
+    }
+}
+
+void formatOutput(const MemoryImage& image, const OutputOptions& options, OutputBuffer& out) {
+    requireFormatDef(options.format).write(image, options, out);
+}
+
+void writeOutputFile(const MemoryImage& image,
+                     std::string& outputFile,
+                     const OutputOptions& options)
+{
+    addOutputExtension(outputFile, options.format);
+
+    OutputBuffer out;
+    formatOutput(image, options, out);
+    out.writeToFile(outputFile);
+}
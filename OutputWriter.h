@@ -0,0 +1,122 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Output writers for assembled memory images
+//              Data-driven format table - to add a new output format, write a
+//              writer function and add an entry to OUTPUT_FORMATS.
+//              All writers format into one OutputBuffer that is flushed to
+//              disk with a single write.
+// ============================================================================
+
+#pragma once
+#include "common.h"
+#include "MemoryImage.h"
+#include <vector>
+#include <string_view>
+
+// Growable byte buffer with hand-rolled number formatting (no iostreams)
+class OutputBuffer {
+private:
+    std::vector<char> data;
+
+public:
+    void reserve(size_t bytes) { data.reserve(bytes); }
+    size_t size() const { return data.size(); }
+    const char* bytes() const { return data.data(); }
+    void clear() { data.clear(); }
+
+    bool operator==(const OutputBuffer& other) const { return data == other.data; }
+    bool operator!=(const OutputBuffer& other) const { return data != other.data; }
+
+    void put(char c) { data.push_back(c); }
+
+    void append(const char* text, size_t length) {
+        data.insert(data.end(), text, text + length);
+    }
+
+    void append(std::string_view text) { append(text.data(), text.size()); }
+
+    // Space for 'length' bytes to be filled in place, returns start pointer
+    char* extend(size_t length) {
+        data.resize(data.size() + length);
+        return data.data() + data.size() - length;
+    }
+
+    // Drop the last 'length' bytes (unused part of an extend())
+    void shrink(size_t length) { data.resize(data.size() - length); }
+
+    // Lowercase hex, left-padded with 'fill' to at least 'width' digits
+    void hex(uint32_t value, int width, char fill = '0');
+
+    // Uppercase hex with exactly 'width' digits (Intel HEX records)
+    void hexUpper(uint32_t value, int width);
+
+    void decimal(uint64_t value);
+
+    // Write the whole buffer with a single write call
+    void writeToFile(const std::string& path) const;
+};
+
+enum class OutputFormat {
+    MIF,            // Quartus Memory Initialization File
+    INTEL_HEX,      // Intel HEX, one address per 16-bit word
+    VERILOG_HEX,    // Verilog $readmemh, one word per line
+    BINARY          // Raw little-endian 16-bit words
+};
+
+constexpr int DEFAULT_MEMORY_DEPTH = 256;     // Used when the image fits and no --depth is given
+constexpr int MAX_MEMORY_DEPTH = ADDRESS_SPACE_WORDS;   // 16-bit word address space
+constexpr int DEPTH_DEFAULT = -1;            // No --depth: DEFAULT_MEMORY_DEPTH, grown if needed
+constexpr int DEPTH_AUTO = 0;                // --depth auto: next power of two that fits
+
+constexpr size_t MIF_MIN_RUN = 4;            // Shortest run written as an [a..b] range
+
+struct OutputOptions {
+    OutputFormat format = OutputFormat::MIF;
+    int depth = DEFAULT_MEMORY_DEPTH;   // Memory depth in words
+    bool comments = true;               // Disassembly comments (MIF, Verilog)
+    bool compress = true;               // Run-length compress repeated words (MIF)
+};
+
+// Final memory depth for an image of 'imageSize' words. 'requested' is an
+// explicit depth, DEPTH_DEFAULT or DEPTH_AUTO. Throws if the image does not fit.
+int resolveMemoryDepth(size_t imageSize, int requested);
+
+using OutputWriterFn = void (*)(const MemoryImage& image,
+                                const OutputOptions& options,
+                                OutputBuffer& out);
+
+struct OutputFormatDef {
+    std::string_view name;          // Command line name (-f <name>)
+    OutputFormat format;
+    std::string_view extension;     // Appended to the output file if missing
+    OutputWriterFn write;
+    std::string_view description;
+};
+
+void writeMIF(const MemoryImage& image, const OutputOptions& options, OutputBuffer& out);
+void writeIntelHex(const MemoryImage& image, const OutputOptions& options, OutputBuffer& out);
+void writeVerilogHex(const MemoryImage& image, const OutputOptions& options, OutputBuffer& out);
+void writeBinary(const MemoryImage& image, const OutputOptions& options, OutputBuffer& out);
+
+inline const OutputFormatDef OUTPUT_FORMATS[] = {
+    {"mif",  OutputFormat::MIF,         ".mif", writeMIF,        "Quartus Memory Initialization File"},
+    {"hex",  OutputFormat::INTEL_HEX,   ".hex", writeIntelHex,   "Intel HEX (word addressed)"},
+    {"mem",  OutputFormat::VERILOG_HEX, ".mem", writeVerilogHex, "Verilog $readmemh hex file"},
+    {"bin",  OutputFormat::BINARY,      ".bin", writeBinary,     "Raw binary, little-endian 16-bit words"},
+};
+
+const OutputFormatDef* getOutputFormatDef(std::string_view name);
+const OutputFormatDef* getOutputFormatDef(OutputFormat format);
+
+// Append the format's extension to 'outputFile' if it does not already end with it
+void addOutputExtension(std::string& outputFile, OutputFormat format);
+
+// Format the image into 'out' without writing it
+void formatOutput(const MemoryImage& image, const OutputOptions& options, OutputBuffer& out);
+
+// Format the image and write it to 'outputFile'. The format's extension is
+// appended to the file name if it does not already end with it.
+void writeOutputFile(const MemoryImage& image,
+                     std::string& outputFile,
+                     const OutputOptions& options);
@@ -0,0 +1,48 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Minimal worker pool helpers
+//              Work items are handed out through an atomic counter, so
+//              workers that finish early pick up the remaining items.
+// ============================================================================
+
+#pragma once
+#include "common.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Worker count for 'requested' threads, 0 = one per hardware thread
+inline unsigned resolveThreadCount(unsigned requested, size_t items) {
+    unsigned threads = requested != 0 ? requested : std::thread::hardware_concurrency();
+    if (threads == 0) {
+        threads = 1;
+    }
+    if (items < threads) {
+        threads = static_cast<unsigned>(items > 0 ? items : 1);
+    }
+    return threads;
+}
+
+// Call fn(i) for every i in [0, count) on up to 'threads' workers.
+// fn must not throw; the calling thread is one of the workers.
+template <typename Fn>
+void parallelFor(size_t count, unsigned threads, Fn&& fn) {
+    threads = resolveThreadCount(threads, count);
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+            fn(i);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (unsigned t = 1; t < threads; t++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+}
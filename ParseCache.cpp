@@ -0,0 +1,356 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Parse cache implementation
+//
+// Entry layout (native byte order - the cache is local to one machine):
+//   header   "SBPC", version, content hash, content size,
+//            symbol count, statement count
+//   symbols  one string per symbol referenced by the entry
+//   stream   type, line, column, then per type:
+//            INSTRUCTION  mnemonic index, reg1, reg2, flags, operand1,
+//                         operand2, symbol1, symbol2, number2
+//            DIRECTIVE    name, label, value, labelSymbol, valueSymbol,
+//                         number, value count, per value: text,
+//                         symbol, number
+//                         (.incbin: the value is empty)
+//            LABEL        name, symbol
+// Strings are a 32-bit length followed by the bytes, symbols are indices
+// into the entry's symbol list or -1. Numbers are a valid byte followed by
+// the 64-bit value.
+// ============================================================================
+
+#include "ParseCache.h"
+#include "InstructionDef.h"
+#include "ByteStream.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+
+static const char PARSE_CACHE_MAGIC[4] = {'S', 'B', 'P', 'C'};
+constexpr uint16_t NO_MNEMONIC = 0xFFFF;
+
+enum : uint8_t {
+    FLAG_COMMA          = 1 << 0,
+    FLAG_LABEL_IMMEDIATE = 1 << 1,
+    FLAG_IMMEDIATE      = 1 << 2
+};
+
+uint64_t hashContent(std::string_view text) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+std::string parseCachePath(const std::string& directory, uint64_t hash) {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.sbc", static_cast<unsigned long long>(hash));
+    return (std::filesystem::path(directory) / name).string();
+}
+
+// ============================================================================
+// Writing
+// ============================================================================
+
+namespace {
+
+// Maps interned symbols to the entry's own dense symbol list
+class SymbolMap {
+private:
+    const StringInterner& names;
+    std::unordered_map<SymbolId, int32_t> indices;
+
+public:
+    std::vector<SymbolId> order;
+
+    explicit SymbolMap(const StringInterner& interner) : names(interner) {}
+
+    int32_t index(SymbolId id) {
+        if (id == NO_SYMBOL) {
+            return -1;
+        }
+        auto [it, inserted] = indices.emplace(id, static_cast<int32_t>(order.size()));
+        if (inserted) {
+            order.push_back(id);
+        }
+        return it->second;
+    }
+
+    std::string_view name(SymbolId id) const { return names.name(id); }
+};
+
+void putNumber(ByteWriter& out, NumberLiteral number) {
+    out.put(static_cast<uint8_t>(number.valid));
+    out.put(number.value);
+}
+
+void writeStatement(ByteWriter& out, SymbolMap& symbols, const Statement& stmt) {
+    out.put(static_cast<uint8_t>(stmt.type));
+    out.put(static_cast<int32_t>(stmt.line));
+    out.put(static_cast<int32_t>(stmt.column));
+
+    switch (stmt.type) {
+        case StatementType::INSTRUCTION: {
+            const Instruction& instr = stmt.instruction;
+            out.put(instr.def ? static_cast<uint16_t>(instr.def - INSTRUCTIONS) : NO_MNEMONIC);
+            out.put(instr.reg1);
+            out.put(instr.reg2);
+            out.put(static_cast<uint8_t>((instr.hasComma ? FLAG_COMMA : 0) |
+                                         (instr.isLabelImmediate ? FLAG_LABEL_IMMEDIATE : 0) |
+                                         (instr.isImmediate ? FLAG_IMMEDIATE : 0)));
+            out.putString(instr.operand1);
+            out.putString(instr.operand2);
+            out.put(symbols.index(instr.symbol1));
+            out.put(symbols.index(instr.symbol2));
+            putNumber(out, instr.number2);
+            break;
+        }
+        case StatementType::DIRECTIVE: {
+            const Directive& dir = stmt.directive;
+            out.putString(dir.name);
+            out.putString(dir.label);
+            out.putString(dir.name == ".incbin" ? std::string_view() : dir.value);
+            out.put(symbols.index(dir.labelSymbol));
+            out.put(symbols.index(dir.valueSymbol));
+            putNumber(out, dir.number);
+            out.put(dir.valueCount);
+            for (uint32_t i = 0; i < dir.valueCount; i++) {
+                out.putString(dir.values[i].text);
+                out.put(symbols.index(dir.values[i].symbol));
+                putNumber(out, dir.values[i].number);
+            }
+            break;
+        }
+        case StatementType::LABEL:
+            out.putString(stmt.label.name);
+            out.put(symbols.index(stmt.label.symbol));
+            break;
+    }
+}
+
+} // namespace
+
+std::string serializeParseCache(uint64_t hash, size_t contentSize,
+                                const ProgramAST& ast, const StringInterner& symbols,
+                                const std::vector<StatementRange>& ranges)
+{
+    // Stream first - it decides which symbols the entry needs
+    std::string stream;
+    ByteWriter streamOut(stream);
+    SymbolMap symbolMap(symbols);
+    uint32_t statementCount = 0;
+    for (const StatementRange& range : ranges) {
+        for (size_t i = range.first; i < range.second; i++) {
+            writeStatement(streamOut, symbolMap, ast[i]);
+            statementCount++;
+        }
+    }
+
+    std::string entry;
+    ByteWriter out(entry);
+    entry.append(PARSE_CACHE_MAGIC, sizeof(PARSE_CACHE_MAGIC));
+    out.put(PARSE_CACHE_VERSION);
+    out.put(hash);
+    out.put(static_cast<uint64_t>(contentSize));
+    out.put(static_cast<uint32_t>(symbolMap.order.size()));
+    out.put(statementCount);
+    for (SymbolId id : symbolMap.order) {
+        out.putString(symbolMap.name(id));
+    }
+    entry += stream;
+    return entry;
+}
+
+void writeParseCache(const std::string& path, const std::string& entry) {
+    std::error_code ec;
+    const std::filesystem::path target(path);
+    std::filesystem::create_directories(target.parent_path(), ec);
+
+    // Unique temporary per writer thread, then an atomic rename
+    const std::string temp = path + ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return;
+        }
+        file.write(entry.data(), static_cast<std::streamsize>(entry.size()));
+        if (!file) {
+            file.close();
+            std::filesystem::remove(temp, ec);
+            return;
+        }
+    }
+    std::filesystem::rename(temp, target, ec);
+    if (ec) {
+        std::filesystem::remove(temp, ec);
+    }
+}
+
+// ============================================================================
+// Loading
+// ============================================================================
+
+namespace {
+
+bool getSymbol(ByteReader& in, const std::vector<SymbolId>& symbols, SymbolId& id) {
+    int32_t index = 0;
+    if (!in.get(index) || index < -1 || index >= static_cast<int32_t>(symbols.size())) {
+        return false;
+    }
+    id = index < 0 ? NO_SYMBOL : symbols[index];
+    return true;
+}
+
+bool getNumber(ByteReader& in, NumberLiteral& number) {
+    uint8_t valid = 0;
+    if (!in.get(valid) || valid > 1 || !in.get(number.value)) {
+        return false;
+    }
+    number.valid = valid != 0;
+    return true;
+}
+
+bool readStatement(ByteReader& in, const std::vector<SymbolId>& symbols, uint16_t file, Arena& arena,
+                   std::vector<Statement>& statements)
+{
+    uint8_t type = 0;
+    int32_t line = 0;
+    int32_t column = 0;
+    if (!in.get(type) || !in.get(line) || !in.get(column) ||
+        type > static_cast<uint8_t>(StatementType::LABEL)) {
+        return false;
+    }
+    Statement stmt(static_cast<StatementType>(type), line, column, file);
+
+    switch (stmt.type) {
+        case StatementType::INSTRUCTION: {
+            Instruction& instr = stmt.instruction;
+            uint16_t mnemonic = 0;
+            uint8_t flags = 0;
+            if (!in.get(mnemonic) || !in.get(instr.reg1) || !in.get(instr.reg2) || !in.get(flags) ||
+                !in.getString(instr.operand1) || !in.getString(instr.operand2) ||
+                !getSymbol(in, symbols, instr.symbol1) || !getSymbol(in, symbols, instr.symbol2) ||
+                !getNumber(in, instr.number2)) {
+                return false;
+            }
+            if (mnemonic != NO_MNEMONIC && mnemonic >= std::size(INSTRUCTIONS)) {
+                return false;
+            }
+            instr.def = mnemonic == NO_MNEMONIC ? nullptr : &INSTRUCTIONS[mnemonic];
+            instr.hasComma = (flags & FLAG_COMMA) != 0;
+            instr.isLabelImmediate = (flags & FLAG_LABEL_IMMEDIATE) != 0;
+            instr.isImmediate = (flags & FLAG_IMMEDIATE) != 0;
+            break;
+        }
+        case StatementType::DIRECTIVE: {
+            Directive& dir = stmt.directive;
+            if (!in.getString(dir.name) || !in.getString(dir.label) || !in.getString(dir.value) ||
+                !getSymbol(in, symbols, dir.labelSymbol) || !getSymbol(in, symbols, dir.valueSymbol) ||
+                !getNumber(in, dir.number) || !in.get(dir.valueCount)) {
+                return false;
+            }
+            dir.values = nullptr;
+            if (dir.valueCount != 0) {
+                if (dir.valueCount > in.remaining()) {
+                    return false;
+                }
+                DataValue* values = arena.allocateArray<DataValue>(dir.valueCount);
+                for (uint32_t i = 0; i < dir.valueCount; i++) {
+                    if (!in.getString(values[i].text) || !getSymbol(in, symbols, values[i].symbol) ||
+                        !getNumber(in, values[i].number)) {
+                        return false;
+                    }
+                }
+                dir.values = values;
+            }
+            break;
+        }
+        case StatementType::LABEL:
+            if (!in.getString(stmt.label.name) || !getSymbol(in, symbols, stmt.label.symbol)) {
+                return false;
+            }
+            break;
+    }
+    statements.push_back(stmt);
+    return true;
+}
+
+} // namespace
+
+bool decodeParseCache(std::string_view entry, uint64_t hash, size_t contentSize,
+                      ParseContext& ctx, IncludeHandler& includes)
+{
+    ByteReader in(entry.data(), entry.size());
+    uint32_t version = 0;
+    uint64_t entryHash = 0;
+    uint64_t entrySize = 0;
+    uint32_t symbolCount = 0;
+    uint32_t statementCount = 0;
+    if (entry.size() < sizeof(PARSE_CACHE_MAGIC) ||
+        memcmp(entry.data(), PARSE_CACHE_MAGIC, sizeof(PARSE_CACHE_MAGIC)) != 0 ||
+        !in.skip(sizeof(PARSE_CACHE_MAGIC)) || !in.get(version) || !in.get(entryHash) ||
+        !in.get(entrySize) || !in.get(symbolCount) || !in.get(statementCount) ||
+        version != PARSE_CACHE_VERSION || entryHash != hash || entrySize != contentSize) {
+        return false;
+    }
+
+    // Decode the whole entry before touching the AST, so a damaged entry
+    // falls back to parsing without leaving statements behind
+    std::vector<SymbolId> symbols;
+    symbols.reserve(symbolCount);
+    for (uint32_t i = 0; i < symbolCount; i++) {
+        std::string_view name;
+        if (!in.getString(name)) {
+            return false;
+        }
+        symbols.push_back(ctx.symbols.intern(name));
+    }
+
+    std::vector<Statement> statements;
+    statements.reserve(statementCount);
+    for (uint32_t i = 0; i < statementCount; i++) {
+        if (!readStatement(in, symbols, ctx.file, ctx.ast.arena, statements)) {
+            return false;
+        }
+    }
+    if (!in.done()) {
+        return false;
+    }
+
+    for (Statement& stmt : statements) {
+        const bool directive = stmt.type == StatementType::DIRECTIVE;
+        if (directive && stmt.directive.name == ".incbin") {
+            stmt.directive.value = includes.incbin(ctx, stmt.directive.label, stmt.line);
+        }
+        ctx.ast.append(stmt);
+        if (directive && stmt.directive.name == ".include") {
+            includes.include(ctx, stmt.directive.value, stmt.line);
+        }
+    }
+    return true;
+}
+
+std::unique_ptr<SourceFile> loadParseCache(const std::string& path, uint64_t hash, size_t contentSize,
+                                           ParseContext& ctx, IncludeHandler& includes)
+{
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(path, ec)) {
+        return nullptr;
+    }
+    std::unique_ptr<SourceFile> entry;
+    try {
+        entry = std::make_unique<SourceFile>(path);
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+    if (!decodeParseCache(entry->text(), hash, contentSize, ctx, includes)) {
+        return nullptr;
+    }
+    return entry;
+}
@@ -0,0 +1,98 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Persistent parse cache for included files
+//              An entry stores the statement stream of one file, keyed by a
+//              hash of its content. Registers, mnemonics and symbols are
+//              already resolved, so loading an entry is a bounds-checked copy
+//              with no scanning or parsing. Nested .include statements are
+//              kept in the stream and expanded again on load, so every file
+//              has its own entry. .incbin statements store the file name,
+//              not the bytes; the file is read again on load.
+// ============================================================================
+
+#pragma once
+#include "common.h"
+#include "ast.h"
+#include "ParseContext.h"
+#include "SourceFile.h"
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+constexpr uint32_t PARSE_CACHE_VERSION = 3;    // Bump when the entry layout or AST changes
+
+// Statement index range [first, last)
+using StatementRange = std::pair<size_t, size_t>;
+
+// 64-bit FNV-1a hash of a file's content
+uint64_t hashContent(std::string_view text);
+
+// Entry path for content 'hash' in 'directory'
+std::string parseCachePath(const std::string& directory, uint64_t hash);
+
+// Entry holding the statements in 'ranges' for content 'hash' of
+// 'contentSize' bytes
+std::string serializeParseCache(uint64_t hash, size_t contentSize,
+                                const ProgramAST& ast, const StringInterner& symbols,
+                                const std::vector<StatementRange>& ranges);
+
+// Write an entry to a temporary file and rename it, so concurrent writers
+// and readers never see a partial entry. Failures are ignored - the cache
+// is only an accelerator.
+void writeParseCache(const std::string& path, const std::string& entry);
+
+// Decode 'entry' into ctx.ast, calling includes.include() right after every
+// .include statement and loading .incbin files again with includes.incbin().
+// The statements point into 'entry', which must outlive the AST. Returns
+// false (and adds nothing) if the entry is damaged or not for this content.
+bool decodeParseCache(std::string_view entry, uint64_t hash, size_t contentSize,
+                      ParseContext& ctx, IncludeHandler& includes);
+
+// Map the entry at 'path' and decode it. Returns the mapping, which must be
+// kept alive, or nullptr if there is no valid entry.
+std::unique_ptr<SourceFile> loadParseCache(const std::string& path, uint64_t hash, size_t contentSize,
+                                           ParseContext& ctx, IncludeHandler& includes);
+
+// In-process cache used by --watch, so unchanged includes are not parsed
+// again between runs even without a cache directory. Not thread-safe.
+class ParseCacheMemory {
+private:
+    struct Entry {
+        std::string data;
+        bool used = false;
+    };
+    std::unordered_map<uint64_t, Entry> entries;   // Node based - entry data never moves
+
+public:
+    // Entry for content 'hash', marked as used, or nullptr
+    const std::string* find(uint64_t hash) {
+        auto it = entries.find(hash);
+        if (it == entries.end()) {
+            return nullptr;
+        }
+        it->second.used = true;
+        return &it->second.data;
+    }
+
+    // Existing entries are kept - ASTs may point into them
+    void store(uint64_t hash, std::string data) {
+        entries.emplace(hash, Entry{std::move(data), true});
+    }
+
+    // Drop the entries not used since the last prune(). Only call this once
+    // no AST points into them any more.
+    void prune() {
+        for (auto it = entries.begin(); it != entries.end(); ) {
+            if (!it->second.used) {
+                it = entries.erase(it);
+            } else {
+                it->second.used = false;
+                ++it;
+            }
+        }
+    }
+
+    size_t size() const { return entries.size(); }
+};
@@ -0,0 +1,73 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Per-assembly state shared by the scanner and the parser
+//              Everything the scanner and parser used to keep in globals
+//              lives here, so independent assemblies can run concurrently.
+// ============================================================================
+
+#pragma once
+#include "common.h"
+#include "ast.h"
+#include "StringInterner.h"
+#include "Diagnostics.h"
+#include <string>
+#include <vector>
+
+struct ParseContext;
+class MacroTable;
+
+// Location of a token, and of the statement starting with it
+struct SourceLocation {
+    int line;
+    int column;
+};
+
+// Expands .include directives - called by the parser right after the
+// .include statement at 'line' has been added, so the included statements
+// follow it. Also loads the files of .incbin directives.
+class IncludeHandler {
+public:
+    virtual ~IncludeHandler() = default;
+    virtual void include(ParseContext& ctx, std::string_view path, int line) = 0;
+
+    // Bytes of the .incbin file 'path', which stay valid as long as the
+    // handler. Reports an error and returns an empty view on failure.
+    virtual std::string_view incbin(ParseContext& ctx, std::string_view path, int line) = 0;
+};
+
+struct ParseContext {
+    ProgramAST& ast;
+    StringInterner& symbols;
+    std::vector<Diagnostic>& diagnostics;
+    IncludeHandler* includes = nullptr;     // nullptr: .include is an error
+    MacroTable* macros = nullptr;           // Shared with included files
+    uint16_t file = 0;                      // Statement::file of new statements
+    std::string fileName;                   // Prefix for diagnostics, empty for the main source
+    int line = 1;                           // Scanner position
+    int column = 1;
+    SourceLocation tokenStart = {1, 1};     // Start of the last scanned token
+    std::vector<DataValue> values;          // Value list being parsed (.word 1, 2, 3)
+
+    ParseContext(ProgramAST& a, StringInterner& s, std::vector<Diagnostic>& d)
+        : ast(a), symbols(s), diagnostics(d) {}
+
+    // At the scanner position
+    void report(DiagnosticKind kind, std::string message) {
+        report(kind, std::move(message), SourceLocation{line, column});
+    }
+
+    void report(DiagnosticKind kind, std::string message, const SourceLocation& at) {
+        if (!fileName.empty()) {
+            message = fileName + ": " + message;
+        }
+        diagnostics.push_back({kind, at.line, at.column, std::move(message)});
+    }
+};
+
+// Implemented by the selected scanner (lexer.l or FastScanner.cpp), which
+// also provides scanner_next() (declared in parser.h). The buffer is
+// scanned in place: its last two bytes must be NUL, and it must outlive the
+// AST (tokens point into it).
+void* scanner_create(ParseContext& ctx, char* base, size_t size);
+void scanner_destroy(void* scanner);
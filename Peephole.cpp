@@ -0,0 +1,192 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Peephole optimizer implementation
+// ============================================================================
+
+#include "Peephole.h"
+#include <algorithm>
+
+namespace {
+
+const InstructionDef* const MV_DEF   = getInstructionDef("mv");
+const InstructionDef* const ADD_DEF  = getInstructionDef("add");
+const InstructionDef* const PUSH_DEF = getInstructionDef("push");
+const InstructionDef* const POP_DEF  = getInstructionDef("pop");
+
+constexpr uint8_t BRANCH_LINK = 7;      // Condition code of bl
+
+// The statement stream as the rules see it - dropped statements are skipped
+class PeepholeScan {
+private:
+    const ProgramAST& ast;
+    const std::vector<char>& removed;
+
+public:
+    PeepholeScan(const ProgramAST& program, const std::vector<char>& drops) : ast(program), removed(drops) {}
+
+    const Statement& operator[](size_t i) const { return ast[i]; }
+    size_t size() const { return ast.size(); }
+
+    // Statements that emit nothing and do not change the address
+    bool isTransparent(size_t i) const {
+        const Statement& stmt = ast[i];
+        return removed[i] || (stmt.type == StatementType::DIRECTIVE &&
+                              (stmt.directive.name == ".define" || stmt.directive.name == ".loopbound"));
+    }
+
+    // Index of the next statement after 'i' that is not transparent, or
+    // NO_STATEMENT. With 'crossLabels' false a label stops the search too.
+    size_t next(size_t i, bool crossLabels) const {
+        for (size_t j = i + 1; j < ast.size(); j++) {
+            if (isTransparent(j) || (crossLabels && ast[j].type == StatementType::LABEL)) {
+                continue;
+            }
+            return j;
+        }
+        return NO_STATEMENT;
+    }
+};
+
+bool isInstruction(const Statement& stmt, const InstructionDef* def) {
+    return stmt.type == StatementType::INSTRUCTION && stmt.instruction.def == def;
+}
+
+// True if the instruction certainly sets the flags from its result
+bool writesFlags(const InstructionDef* def) {
+    return def->format == InstrFormat::REG_IMM_OR_REG && def != MV_DEF;
+}
+
+// True if the instruction may change the program counter
+bool writesPC(const Statement& stmt) {
+    const Instruction& instr = stmt.instruction;
+    switch (instr.def->format) {
+        case InstrFormat::BRANCH:
+        case InstrFormat::NO_OPERAND:
+            return true;
+        default:
+            return instr.reg1 == PC_REGISTER;
+    }
+}
+
+// True if no instruction can read the flags left by statement 'i': on the
+// straight-line path after it, another instruction sets them before any
+// conditional branch, jump or data word. Flags are never assumed dead
+// across a jump or at the end of the program.
+bool flagsDeadAfter(const PeepholeScan& scan, size_t i) {
+    for (size_t j = scan.next(i, true); j != NO_STATEMENT; j = scan.next(j, true)) {
+        const Statement& stmt = scan[j];
+        if (stmt.type != StatementType::INSTRUCTION || stmt.instruction.def == nullptr) {
+            return false;
+        }
+        if (writesFlags(stmt.instruction.def)) {
+            return true;
+        }
+        if (writesPC(stmt)) {
+            return false;
+        }
+    }
+    return false;
+}
+
+// Rules - each returns true if statement 'i' (already known to have the
+// rule's format) can be dropped, setting 'second' if another one goes too
+
+bool matchSelfMove(const PeepholeScan& scan, size_t i, size_t&) {
+    const Instruction& instr = scan[i].instruction;
+    return instr.def == MV_DEF && !instr.isImmediate && !instr.isLabelImmediate &&
+           instr.reg1 != NO_REGISTER && instr.reg1 == instr.reg2;
+}
+
+bool matchAddZero(const PeepholeScan& scan, size_t i, size_t&) {
+    const Instruction& instr = scan[i].instruction;
+    return instr.def == ADD_DEF && instr.reg1 != NO_REGISTER && instr.isImmediate && !instr.isLabelImmediate &&
+           instr.symbol2 == NO_SYMBOL && instr.number2.valid && instr.number2.value == 0 && flagsDeadAfter(scan, i);
+}
+
+bool matchPushPop(const PeepholeScan& scan, size_t i, size_t& second) {
+    const Instruction& instr = scan[i].instruction;
+    if (instr.def != PUSH_DEF || instr.reg1 == NO_REGISTER || instr.reg1 == PC_REGISTER ||
+        instr.reg1 == instr.def->extraData) {
+        return false;
+    }
+    // Adjacent - a label in between could be jumped to
+    const size_t j = scan.next(i, false);
+    if (j == NO_STATEMENT || !isInstruction(scan[j], POP_DEF) || scan[j].instruction.reg1 != instr.reg1) {
+        return false;
+    }
+    second = j;
+    return true;
+}
+
+bool matchBranchToNext(const PeepholeScan& scan, size_t i, size_t&) {
+    const Instruction& instr = scan[i].instruction;
+    if (instr.def->extraData == BRANCH_LINK || instr.symbol1 == NO_SYMBOL) {
+        return false;
+    }
+    // The target label must sit between the branch and the next word
+    for (size_t j = i + 1; j < scan.size(); j++) {
+        if (scan.isTransparent(j)) {
+            continue;
+        }
+        if (scan[j].type != StatementType::LABEL) {
+            return false;
+        }
+        if (scan[j].label.symbol == instr.symbol1) {
+            return true;
+        }
+    }
+    return false;
+}
+
+struct PeepholeRule {
+    const char* name;
+    InstrFormat format;
+    bool (*match)(const PeepholeScan& scan, size_t i, size_t& second);
+};
+
+constexpr PeepholeRule PEEPHOLE_RULES[] = {
+    {"redundant mv rX, rX",         InstrFormat::REG_IMM_OR_REG, matchSelfMove},
+    {"add rX, #0 with dead flags",  InstrFormat::REG_IMM_OR_REG, matchAddZero},
+    {"push rX; pop rX",             InstrFormat::REG_ONLY,       matchPushPop},
+    {"branch to next instruction",  InstrFormat::BRANCH,         matchBranchToNext},
+};
+
+} // namespace
+
+std::vector<PeepholeRewrite> findPeepholeRewrites(const ProgramAST& ast, std::vector<char>& removed) {
+    removed.assign(ast.size(), 0);
+    const PeepholeScan scan(ast, removed);
+    std::vector<PeepholeRewrite> rewrites;
+
+    for (bool changed = true; changed; ) {
+        changed = false;
+        for (size_t i = 0; i < ast.size(); i++) {
+            const Statement& stmt = ast[i];
+            if (removed[i] || stmt.type != StatementType::INSTRUCTION || stmt.instruction.def == nullptr) {
+                continue;
+            }
+            const InstructionDef* def = stmt.instruction.def;
+            for (const PeepholeRule& rule : PEEPHOLE_RULES) {
+                size_t second = NO_STATEMENT;
+                if (rule.format != def->format || !rule.match(scan, i, second)) {
+                    continue;
+                }
+                PeepholeRewrite rewrite{rule.name, i, second, 1, def->cycles};
+                removed[i] = 1;
+                if (second != NO_STATEMENT) {
+                    removed[second] = 1;
+                    rewrite.words++;
+                    rewrite.cycles += ast[second].instruction.def->cycles;
+                }
+                rewrites.push_back(rewrite);
+                changed = true;
+                break;
+            }
+        }
+    }
+
+    std::sort(rewrites.begin(), rewrites.end(),
+              [](const PeepholeRewrite& a, const PeepholeRewrite& b) { return a.first < b.first; });
+    return rewrites;
+}
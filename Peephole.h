@@ -0,0 +1,33 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Peephole optimizer (-O)
+//              Finds instructions that have no effect and can be dropped
+//              before encoding. Rules are matched statement by statement and
+//              keyed by instruction format. They only look at the statement
+//              stream, never at addresses: the encoder lays the program out
+//              again without the dropped statements, so labels, branch
+//              offsets and =label loads move with the code.
+// ============================================================================
+
+#pragma once
+#include "common.h"
+#include "ast.h"
+#include "InstructionDef.h"
+#include <vector>
+
+constexpr size_t NO_STATEMENT = static_cast<size_t>(-1);
+
+// One applied rewrite - 'first' and 'second' (or NO_STATEMENT) are dropped
+struct PeepholeRewrite {
+    const char* rule;
+    size_t first;
+    size_t second;
+    int words;          // Words saved
+    int cycles;         // Cycles saved each time the code runs
+};
+
+// Mark the statements the rules drop in 'removed' (one entry per
+// statement) and return the rewrites in statement order. Rules are applied
+// again until none matches, so a drop can enable another one.
+std::vector<PeepholeRewrite> findPeepholeRewrites(const ProgramAST& ast, std::vector<char>& removed);
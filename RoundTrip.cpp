@@ -0,0 +1,298 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: sbasm_roundtrip - checks the disassembler against the encoder
+//              over the whole 16-bit instruction space
+//              Every word is disassembled, the text is assembled again
+//              through the library and the result compared with the word:
+//
+//                  exact     the same word
+//                  alias     a word that differs only in the don't-care
+//                            bits of its form (DONT_CARE_BITS)
+//                  mismatch  a word that differs in any other bit
+//                  rejected  the text does not assemble
+//
+//              Branch targets are printed as addresses; the text is given a
+//              label at the target instead. A .word disassembly must give
+//              the word back exactly.
+//
+//              The other direction is checked for every instruction with an
+//              immediate: each value from -1024 to 1023 that assembles must
+//              decode to the same instruction and value. A value that
+//              encodes into a different instruction (cmp r0, #-1 used to
+//              become halt) corrupts the image without any error.
+//
+//              Exits non-zero on any failure, so it can gate changes to the
+//              instruction table.
+//
+//                  sbasm_roundtrip [-j <n>] [-v]
+// ============================================================================
+
+#include "Assembler.h"
+#include "InstructionDef.h"
+#include "NumberParser.h"
+#include "Parallel.h"
+#include <chrono>
+#include <map>
+
+namespace {
+
+// Address every word is assembled at - branch targets reach 256 words back
+constexpr uint32_t ROUNDTRIP_ADDRESS = 0x100;
+
+// Failures printed per mnemonic without -v
+constexpr size_t ROUNDTRIP_EXAMPLES = 3;
+
+// Immediates tried per instruction: [-IMMEDIATE_SWEEP, IMMEDIATE_SWEEP)
+constexpr int64_t IMMEDIATE_SWEEP = 1024;
+
+// Bits of each instruction form that the ISA leaves unused, first match
+// wins. Written from the encodings rather than from decodeWord(), so a
+// decoder that drops a bit that matters shows up as a mismatch.
+struct DontCare {
+    uint16_t mask;          // Bits that select the form
+    uint16_t match;
+    uint16_t ignored;
+    const char* form;
+};
+
+constexpr DontCare DONT_CARE_BITS[] = {
+    {0xE1F0, 0xE1F0, 0x1E0F, "halt            111-  ---1 1111 ----"},
+    {0xE180, 0xE180, 0x1010, "shift #imm      111-  XXX1 1TT- IIII"},
+    {0xE180, 0xE100, 0x1018, "shift rY        111-  XXX1 0TT- -YYY"},
+    {0xF100, 0xF000, 0x0000, "cmp #imm        1111  XXX0 IIII IIII"},
+    {0xF100, 0xE000, 0x00F8, "cmp rY          1110  XXX0 ---- -YYY"},
+    {0xF000, 0x3000, 0x0100, "mvt             0011  XXX- IIII IIII"},
+    {0xF000, 0x2000, 0x0000, "branch          0010  CCCI IIII IIII"},
+    {0xC000, 0x8000, 0x01F8, "ld/st/push/pop  10OS  XXX- ---- -YYY"},
+    {0x1000, 0x0000, 0x01F8, "alu rY          OOO0  XXX- ---- -YYY"},
+    {0x0000, 0x0000, 0x0000, "alu #imm        OOO1  XXXI IIII IIII"},
+};
+
+constexpr uint16_t dontCareBits(uint16_t word) {
+    for (const DontCare& form : DONT_CARE_BITS) {
+        if ((word & form.mask) == form.match) {
+            return form.ignored;
+        }
+    }
+    return 0;
+}
+
+enum class Outcome : uint8_t {
+    EXACT,
+    ALIAS,
+    MISMATCH,
+    REJECTED
+};
+
+struct WordResult {
+    Outcome outcome = Outcome::EXACT;
+    uint16_t reassembled = 0;
+    std::string message;        // First diagnostic of a rejected word
+};
+
+std::string disassembleAt(uint16_t word) {
+    return disassembleInstruction(word, ROUNDTRIP_ADDRESS);
+}
+
+// Source for the disassembly of 'word' at ROUNDTRIP_ADDRESS
+std::string sourceFor(uint16_t word) {
+    const std::string text = disassembleAt(word);
+    const std::string org = ".org " + std::to_string(ROUNDTRIP_ADDRESS) + "\n";
+    if (!isBranchWord(word)) {
+        return org + text + "\n";
+    }
+    // "beq 0x1a3" - the mnemonic branches to a label at the target
+    const std::string branch = text.substr(0, text.find(' ')) + " target\n";
+    const uint32_t target = branchTarget(word, ROUNDTRIP_ADDRESS);
+    if (target <= ROUNDTRIP_ADDRESS) {
+        return ".org " + std::to_string(target) + "\ntarget:\n" + org + branch;
+    }
+    return org + branch + ".org " + std::to_string(target) + "\ntarget:\n";
+}
+
+WordResult check(uint16_t word) {
+    WordResult result;
+    std::string source = sourceFor(word);
+    source.append(2, '\0');
+
+    Assembler assembler;
+    if (!assembler.assemble(source.data(), source.size())) {
+        result.outcome = Outcome::REJECTED;
+        const std::vector<Diagnostic>& diagnostics = assembler.getDiagnostics();
+        result.message = diagnostics.empty() ? "assembly failed" : diagnostics[0].message;
+        return result;
+    }
+
+    const MemoryImage& image = assembler.getImage();
+    bool found = false;
+    // Words the assembler has no syntax for disassemble as .word, a DATA word
+    for (const Segment& seg : image.getSegments()) {
+        if (seg.kind != SegmentKind::FILL && seg.address == ROUNDTRIP_ADDRESS && seg.length == 1) {
+            result.reassembled = image.wordAt(seg, ROUNDTRIP_ADDRESS);
+            found = true;
+        }
+    }
+    if (!found) {
+        result.outcome = Outcome::MISMATCH;
+        result.message = "not assembled to one word";
+    } else if (result.reassembled == word) {
+        result.outcome = Outcome::EXACT;
+    } else {
+        const uint16_t ignored = dontCareBits(word);
+        result.outcome = dontCareBits(result.reassembled) == ignored && ((result.reassembled ^ word) & ~ignored) == 0
+                             ? Outcome::ALIAS
+                             : Outcome::MISMATCH;
+    }
+    return result;
+}
+
+// Single word assembled from 'text' at ROUNDTRIP_ADDRESS, false if the text
+// is rejected
+bool assembleWord(const std::string& text, uint16_t& word) {
+    std::string source = ".org " + std::to_string(ROUNDTRIP_ADDRESS) + "\n" + text + "\n";
+    source.append(2, '\0');
+    Assembler assembler;
+    if (!assembler.assemble(source.data(), source.size())) {
+        return false;
+    }
+    const MemoryImage& image = assembler.getImage();
+    const Segment& seg = image.getSegments().back();
+    if (seg.kind != SegmentKind::CODE || seg.address != ROUNDTRIP_ADDRESS || seg.length != 1) {
+        return false;
+    }
+    word = image.wordAt(seg, ROUNDTRIP_ADDRESS);
+    return true;
+}
+
+// "mnemonic r1, #value" for every value of the sweep. Returns the number of
+// values accepted; failures are added to 'failures'.
+size_t sweepImmediates(const InstructionDef& def, std::vector<std::string>& failures) {
+    size_t accepted = 0;
+    for (int64_t value = -IMMEDIATE_SWEEP; value < IMMEDIATE_SWEEP; value++) {
+        const std::string text = std::string(def.mnemonic) + " r1, #" + std::to_string(value);
+        uint16_t word = 0;
+        if (!assembleWord(text, word)) {
+            continue;
+        }
+        accepted++;
+        // mvt keeps the low byte of what was written
+        const DecodedWord decoded = decodeWord(word);
+        const int64_t expected = def.format == InstrFormat::REG_IMM ? (value & 0xFF) : value;
+        if (getDecodedDef(decoded) != &def || !decoded.immediate || decoded.rX != 1 || decoded.value != expected) {
+            char hex[8];
+            snprintf(hex, sizeof(hex), "0x%04x", word);
+            failures.push_back(text + "  -> " + hex + "  " + disassembleAt(word));
+        }
+    }
+    return accepted;
+}
+
+void printHelp() {
+    std::cout << "Usage: sbasm_roundtrip [options]\n"
+              << "Disassemble every 16-bit word, assemble the text again and compare\n\n"
+              << "Options:\n"
+              << "  -j <n>, --jobs <n>    Worker threads (default: all cores)\n"
+              << "  -v, --verbose         Print every failing word\n"
+              << "  -h, --help            Display this help message\n";
+}
+
+} // namespace
+
+int main(int argc, const char* argv[]) {
+    unsigned threads = 0;
+    bool verbose = false;
+    for (int i = 1; i < argc; ) {
+        const std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            printHelp();
+            return 0;
+        } else if (arg == "-j" || arg == "--jobs") {
+            int64_t count = 0;
+            if (i + 1 >= argc || !parseNumber(argv[i + 1], count) || count < 1 || count > 1024) {
+                std::cerr << "Error: -j requires a thread count" << std::endl;
+                return 1;
+            }
+            threads = static_cast<unsigned>(count);
+            i += 2;
+        } else if (arg == "-v" || arg == "--verbose") {
+            verbose = true;
+            i += 1;
+        } else {
+            std::cerr << "Error: Unexpected argument '" << arg << "'\n"
+                      << "Use -h for help" << std::endl;
+            return 1;
+        }
+    }
+
+    // One work item per 256 words - an item is a few hundred assemblies
+    constexpr size_t WORDS = 0x10000;
+    constexpr size_t BLOCK = 256;
+    std::vector<WordResult> results(WORDS);
+    const auto start = std::chrono::steady_clock::now();
+    parallelFor(WORDS / BLOCK, threads, [&](size_t block) {
+        for (size_t word = block * BLOCK; word < (block + 1) * BLOCK; word++) {
+            results[word] = check(static_cast<uint16_t>(word));
+        }
+    });
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Failures grouped by the mnemonic of the original word
+    size_t counts[4] = {};
+    std::map<std::string, std::vector<uint16_t>> failures;
+    for (size_t word = 0; word < WORDS; word++) {
+        const WordResult& result = results[word];
+        counts[static_cast<int>(result.outcome)]++;
+        if (result.outcome == Outcome::MISMATCH || result.outcome == Outcome::REJECTED) {
+            const DecodedWord decoded = decodeWord(static_cast<uint16_t>(word));
+            failures[std::string(getDecodedDef(decoded)->mnemonic)].push_back(static_cast<uint16_t>(word));
+        }
+    }
+
+    std::cout << std::hex << std::setfill('0');
+    for (const auto& [mnemonic, words] : failures) {
+        std::cout << mnemonic << ": " << std::dec << words.size() << " word(s)\n" << std::hex;
+        for (size_t i = 0; i < words.size() && (verbose || i < ROUNDTRIP_EXAMPLES); i++) {
+            const WordResult& result = results[words[i]];
+            std::cout << "  0x" << std::setw(4) << words[i] << "  " << disassembleAt(words[i]) << "  -> ";
+            if (result.outcome == Outcome::REJECTED) {
+                std::cout << result.message << "\n";
+            } else {
+                std::cout << "0x" << std::setw(4) << result.reassembled << "  " << disassembleAt(result.reassembled)
+                          << "\n";
+            }
+        }
+    }
+    std::cout << std::dec << std::setfill(' ');
+
+    // Source to word: immediates the encoder accepts
+    std::vector<std::vector<std::string>> sweepFailures(std::size(INSTRUCTIONS));
+    std::vector<size_t> sweepAccepted(std::size(INSTRUCTIONS), 0);
+    parallelFor(std::size(INSTRUCTIONS), threads, [&](size_t i) {
+        const InstructionDef& def = INSTRUCTIONS[i];
+        if (def.format == InstrFormat::REG_IMM || def.format == InstrFormat::REG_IMM_OR_REG ||
+            def.format == InstrFormat::SHIFT) {
+            sweepAccepted[i] = sweepImmediates(def, sweepFailures[i]);
+        }
+    });
+    size_t immediates = 0;
+    size_t wrongImmediates = 0;
+    for (size_t i = 0; i < std::size(INSTRUCTIONS); i++) {
+        immediates += sweepAccepted[i];
+        wrongImmediates += sweepFailures[i].size();
+        if (!sweepFailures[i].empty()) {
+            std::cout << INSTRUCTIONS[i].mnemonic << " #immediate: " << sweepFailures[i].size() << " value(s)\n";
+        }
+        for (size_t k = 0; k < sweepFailures[i].size() && (verbose || k < ROUNDTRIP_EXAMPLES); k++) {
+            std::cout << "  " << sweepFailures[i][k] << "\n";
+        }
+    }
+    const double total = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Round trip: " << counts[0] << " exact, " << counts[1] << " alias, " << counts[2] << " mismatch, "
+              << counts[3] << " rejected (" << static_cast<int>(seconds * 1000) << " ms)\n"
+              << "Immediates: " << immediates << " accepted, " << wrongImmediates << " encoded wrong\n"
+              << "Total: " << static_cast<int>(total * 1000) << " ms on "
+              << resolveThreadCount(threads, WORDS / BLOCK) << " worker(s)\n";
+    return counts[2] + counts[3] + wrongImmediates == 0 ? 0 : 1;
+}
@@ -0,0 +1,392 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: qCore simulator implementation
+// ============================================================================
+
+#include "Simulator.h"
+#include "InstructionDef.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SBASM_SIM_THREADED 1     // Labels as values - one indirect jump per instruction
+#endif
+
+namespace {
+
+constexpr uint32_t ADDRESS_SPACE = 0x10000;
+constexpr uint64_t NEVER = std::numeric_limits<uint64_t>::max();
+
+// Micro-op handlers - the order matches the dispatch table in run()
+enum Handler : uint8_t {
+    MV_REG, MV_IMM, MVT,
+    ADD_REG, ADD_IMM, SUB_REG, SUB_IMM, AND_REG, AND_IMM, CMP_REG, CMP_IMM,
+    LD, ST, PUSH, POP, POP_PC,
+    LSL, LSR, ASR, ROR,
+    B, BEQ, BNE, BCC, BCS, BPL, BMI, BL,
+    HALT, FAULT
+};
+
+// Everything run() changes, so the loop and the event handling share it
+struct Machine {
+    uint16_t r[8] = {};
+    bool z = false, n = false, c = false;
+    uint16_t* memory;
+    Simulator::MicroOp* ops;
+    uint32_t ramWords;
+    uint16_t switches;
+
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    uint64_t maxCycles;
+    uint64_t nextEvent = 0;     // Cycle of the next limit, timer or interrupt check
+
+    uint16_t leds = 0;
+    uint16_t hex[SIM_HEX_DIGITS] = {};
+
+    // Interval timer
+    uint32_t timerData = 0;     // Reload value from the two data registers
+    uint32_t timerCount = 0;    // Count while stopped
+    bool timerRunning = false;
+    uint64_t timerDeadline = NEVER;
+    bool interruptPending = false;
+
+    // Active interrupt
+    bool inInterrupt = false;
+    uint16_t interruptSlot = 0;             // Stack slot holding the return address
+    bool savedZ = false, savedN = false, savedC = false;
+    uint64_t interrupts = 0;
+
+    void schedule() {
+        nextEvent = maxCycles;
+        if (timerRunning && timerDeadline < nextEvent) {
+            nextEvent = timerDeadline;
+        }
+        if (interruptPending && !inInterrupt) {
+            nextEvent = cycles;
+        }
+    }
+
+    uint32_t timerValue() const {
+        return timerRunning ? static_cast<uint32_t>(timerDeadline - cycles) : timerCount;
+    }
+
+    uint16_t load(uint16_t address) const {
+        if (address < ramWords) {
+            return memory[address];
+        }
+        if (address == SIM_SWITCH_ADDRESS) {
+            return switches;
+        }
+        if (address == SIM_LED_ADDRESS) {
+            return leds;
+        }
+        if (address >= SIM_HEX_ADDRESS && address < SIM_HEX_ADDRESS + SIM_HEX_DIGITS) {
+            return hex[address - SIM_HEX_ADDRESS];
+        }
+        if (address == SIM_TIMER_LOW_ADDRESS) {
+            return static_cast<uint16_t>(timerValue() & 0xFFFF);
+        }
+        if (address == SIM_TIMER_HIGH_ADDRESS) {
+            return static_cast<uint16_t>(timerValue() >> 16);
+        }
+        return 0;   // Unmapped
+    }
+
+    void writeTimerControl(uint16_t command) {
+        switch (command) {
+            case 1:     // INIT
+                timerCount = timerData;
+                timerRunning = false;
+                interruptPending = false;
+                break;
+            case 2:     // START
+                if (!timerRunning && timerCount != 0) {
+                    timerRunning = true;
+                    timerDeadline = cycles + timerCount;
+                }
+                break;
+            case 3:     // ACK
+                interruptPending = false;
+                break;
+            default:
+                break;
+        }
+        schedule();
+    }
+
+    void store(uint16_t address, uint16_t value);
+
+    // Timer expiry, interrupt entry and the cycle limit, checked between
+    // instructions. Returns false once the cycle limit is reached.
+    bool handleEvent() {
+        while (timerRunning && cycles >= timerDeadline) {
+            interruptPending = true;
+            timerCount = timerData;
+            if (timerData == 0) {
+                timerRunning = false;
+            } else {
+                timerDeadline += timerData;
+            }
+        }
+        if (cycles >= maxCycles) {
+            return false;
+        }
+        if (interruptPending && !inInterrupt) {
+            r[5]--;
+            store(r[5], r[7]);
+            interruptSlot = r[5];
+            savedZ = z;
+            savedN = n;
+            savedC = c;
+            inInterrupt = true;
+            r[7] = SIM_ISR_ADDRESS;
+            cycles += SIM_INTERRUPT_CYCLES;
+            interrupts++;
+        }
+        schedule();
+        return true;
+    }
+
+    void setZN(uint16_t value) {
+        z = value == 0;
+        n = (value & 0x8000) != 0;
+    }
+
+    uint16_t add(uint16_t a, uint16_t b) {
+        const uint32_t sum = static_cast<uint32_t>(a) + b;
+        c = sum > 0xFFFF;
+        setZN(static_cast<uint16_t>(sum));
+        return static_cast<uint16_t>(sum);
+    }
+
+    uint16_t subtract(uint16_t a, uint16_t b) {
+        const uint32_t difference = static_cast<uint32_t>(a) + static_cast<uint16_t>(~b) + 1;
+        c = difference > 0xFFFF;
+        setZN(static_cast<uint16_t>(difference));
+        return static_cast<uint16_t>(difference);
+    }
+};
+
+void Machine::store(uint16_t address, uint16_t value) {
+    if (address < ramWords) {
+        memory[address] = value;
+        ops[address] = Simulator::predecodeWord(value);
+        return;
+    }
+    if (address == SIM_LED_ADDRESS) {
+        leds = value;
+    } else if (address >= SIM_HEX_ADDRESS && address < SIM_HEX_ADDRESS + SIM_HEX_DIGITS) {
+        hex[address - SIM_HEX_ADDRESS] = value;
+    } else if (address == SIM_TIMER_LOW_ADDRESS) {
+        timerData = (timerData & 0xFFFF0000u) | value;
+    } else if (address == SIM_TIMER_HIGH_ADDRESS) {
+        timerData = (timerData & 0x0000FFFFu) | (static_cast<uint32_t>(value) << 16);
+    } else if (address == SIM_TIMER_CONTROL_ADDRESS) {
+        writeTimerControl(value);
+    }
+}
+
+SimResult collectResult(const Machine& m, StopReason reason) {
+    SimResult result;
+    result.reason = reason;
+    result.cycles = m.cycles;
+    result.instructions = m.instructions;
+    result.interrupts = m.interrupts;
+    memcpy(result.registers, m.r, sizeof(result.registers));
+    result.z = m.z;
+    result.n = m.n;
+    result.c = m.c;
+    result.leds = m.leds;
+    memcpy(result.hex, m.hex, sizeof(result.hex));
+    result.faultAddress = m.r[7];
+    return result;
+}
+
+} // namespace
+
+Simulator::MicroOp Simulator::predecodeWord(uint16_t word) {
+    const DecodedWord decoded = decodeWord(word);
+    const uint8_t cycles = static_cast<uint8_t>(getDecodedDef(decoded)->cycles);
+    MicroOp op{FAULT, decoded.rX, decoded.rY, cycles, decoded.value};
+
+    switch (decoded.op) {
+        case Operation::MV:   op.handler = decoded.immediate ? MV_IMM : MV_REG; break;
+        case Operation::MVT:  op.handler = MVT; break;
+        case Operation::ADD:  op.handler = decoded.immediate ? ADD_IMM : ADD_REG; break;
+        case Operation::SUB:  op.handler = decoded.immediate ? SUB_IMM : SUB_REG; break;
+        case Operation::AND:  op.handler = decoded.immediate ? AND_IMM : AND_REG; break;
+        case Operation::CMP:  op.handler = decoded.immediate ? CMP_IMM : CMP_REG; break;
+        case Operation::LD:   op.handler = LD; break;
+        case Operation::ST:   op.handler = ST; break;
+        case Operation::PUSH: op.handler = PUSH; break;
+        case Operation::POP:  op.handler = decoded.rX == PC_REGISTER ? POP_PC : POP; break;
+        case Operation::LSL:  op.handler = LSL; break;
+        case Operation::LSR:  op.handler = LSR; break;
+        case Operation::ASR:  op.handler = ASR; break;
+        case Operation::ROR:  op.handler = ROR; break;
+        case Operation::BRANCH: op.handler = static_cast<uint8_t>(B + decoded.rX); break;
+        case Operation::HALT: op.handler = HALT; break;
+    }
+
+    // Shifts by a register are marked with a negative amount
+    if (op.handler >= LSL && op.handler <= ROR && !decoded.immediate) {
+        op.value = -1;
+    }
+    return op;
+}
+
+Simulator::Simulator(const MemoryImage& image)
+    : ramWords(std::max<uint32_t>(SIM_RAM_WORDS, image.size())),
+      initial(new uint16_t[ADDRESS_SPACE]()),
+      memory(new uint16_t[ADDRESS_SPACE]()),
+      ops(new MicroOp[ADDRESS_SPACE])
+{
+    if (image.size() > SIM_IO_BASE) {
+        throw std::runtime_error("Program does not fit below the I/O region at 0x1000 (" +
+                                 std::to_string(image.size()) + " words)");
+    }
+    image.forEachWord([&](uint32_t address, uint16_t word, bool) {
+        initial[address] = word;
+    });
+}
+
+SimResult Simulator::run(uint64_t maxCycles) {
+    memcpy(memory.get(), initial.get(), ADDRESS_SPACE * sizeof(uint16_t));
+    for (uint32_t address = 0; address < ADDRESS_SPACE; address++) {
+        ops[address] = address < ramWords ? predecodeWord(memory[address]) : MicroOp{FAULT, 0, 0, 0, 0};
+    }
+
+    Machine m;
+    m.memory = memory.get();
+    m.ops = ops.get();
+    m.ramWords = ramWords;
+    m.switches = switches;
+    m.maxCycles = maxCycles;
+    m.schedule();
+
+    uint16_t* const r = m.r;
+    const MicroOp* op = nullptr;
+    StopReason reason = StopReason::CYCLE_LIMIT;
+
+#ifdef SBASM_SIM_THREADED
+    static void* const dispatch[] = {
+        &&L_MV_REG, &&L_MV_IMM, &&L_MVT,
+        &&L_ADD_REG, &&L_ADD_IMM, &&L_SUB_REG, &&L_SUB_IMM, &&L_AND_REG, &&L_AND_IMM, &&L_CMP_REG, &&L_CMP_IMM,
+        &&L_LD, &&L_ST, &&L_PUSH, &&L_POP, &&L_POP_PC,
+        &&L_LSL, &&L_LSR, &&L_ASR, &&L_ROR,
+        &&L_B, &&L_BEQ, &&L_BNE, &&L_BCC, &&L_BCS, &&L_BPL, &&L_BMI, &&L_BL,
+        &&L_HALT, &&L_FAULT
+    };
+    static_assert(sizeof(dispatch) / sizeof(dispatch[0]) == FAULT + 1, "Dispatch table out of sync");
+
+#define HANDLER(name) L_##name:
+#define NEXT()                                          \
+    do {                                                \
+        if (m.cycles >= m.nextEvent && !m.handleEvent()) \
+            goto stop;                                  \
+        op = &m.ops[r[7]++];                            \
+        m.cycles += op->cycles;                         \
+        m.instructions++;                               \
+        goto *dispatch[op->handler];                    \
+    } while (0)
+
+    NEXT();
+#else
+#define HANDLER(name) case name:
+#define NEXT() continue
+
+    for (;;) {
+        if (m.cycles >= m.nextEvent && !m.handleEvent()) {
+            goto stop;
+        }
+        op = &m.ops[r[7]++];
+        m.cycles += op->cycles;
+        m.instructions++;
+        switch (op->handler) {
+#endif
+
+    HANDLER(MV_REG)  r[op->rX] = r[op->rY]; NEXT();
+    HANDLER(MV_IMM)  r[op->rX] = static_cast<uint16_t>(op->value); NEXT();
+    HANDLER(MVT)     r[op->rX] = static_cast<uint16_t>(op->value << 8); NEXT();
+    HANDLER(ADD_REG) r[op->rX] = m.add(r[op->rX], r[op->rY]); NEXT();
+    HANDLER(ADD_IMM) r[op->rX] = m.add(r[op->rX], static_cast<uint16_t>(op->value)); NEXT();
+    HANDLER(SUB_REG) r[op->rX] = m.subtract(r[op->rX], r[op->rY]); NEXT();
+    HANDLER(SUB_IMM) r[op->rX] = m.subtract(r[op->rX], static_cast<uint16_t>(op->value)); NEXT();
+    HANDLER(AND_REG) r[op->rX] &= r[op->rY]; m.c = false; m.setZN(r[op->rX]); NEXT();
+    HANDLER(AND_IMM) r[op->rX] &= static_cast<uint16_t>(op->value); m.c = false; m.setZN(r[op->rX]); NEXT();
+    HANDLER(CMP_REG) m.subtract(r[op->rX], r[op->rY]); NEXT();
+    HANDLER(CMP_IMM) m.subtract(r[op->rX], static_cast<uint16_t>(op->value)); NEXT();
+
+    HANDLER(LD)      r[op->rX] = m.load(r[op->rY]); NEXT();
+    HANDLER(ST)      m.store(r[op->rY], r[op->rX]); NEXT();
+    HANDLER(PUSH) {
+        const uint16_t value = r[op->rX];
+        r[op->rY]--;
+        m.store(r[op->rY], value);
+        NEXT();
+    }
+    HANDLER(POP) {
+        const uint16_t value = m.load(r[op->rY]);
+        r[op->rY]++;
+        r[op->rX] = value;
+        NEXT();
+    }
+    HANDLER(POP_PC) {
+        const uint16_t slot = r[op->rY];
+        r[op->rY]++;
+        r[7] = m.load(slot);
+        if (m.inInterrupt && slot == m.interruptSlot) {
+            m.z = m.savedZ;
+            m.n = m.savedN;
+            m.c = m.savedC;
+            m.inInterrupt = false;
+            m.schedule();
+        }
+        NEXT();
+    }
+
+#define SHIFT_AMOUNT() (op->value >= 0 ? op->value : (r[op->rY] & 0xF))
+    HANDLER(LSL) r[op->rX] = static_cast<uint16_t>(r[op->rX] << SHIFT_AMOUNT()); m.setZN(r[op->rX]); NEXT();
+    HANDLER(LSR) r[op->rX] = static_cast<uint16_t>(r[op->rX] >> SHIFT_AMOUNT()); m.setZN(r[op->rX]); NEXT();
+    HANDLER(ASR) r[op->rX] = static_cast<uint16_t>(static_cast<int16_t>(r[op->rX]) >> SHIFT_AMOUNT()); m.setZN(r[op->rX]); NEXT();
+    HANDLER(ROR) {
+        const int amount = SHIFT_AMOUNT();
+        const uint16_t value = r[op->rX];
+        r[op->rX] = amount == 0 ? value : static_cast<uint16_t>((value >> amount) | (value << (16 - amount)));
+        m.setZN(r[op->rX]);
+        NEXT();
+    }
+#undef SHIFT_AMOUNT
+
+    HANDLER(B)   r[7] += op->value; NEXT();
+    HANDLER(BEQ) if (m.z) r[7] += op->value; NEXT();
+    HANDLER(BNE) if (!m.z) r[7] += op->value; NEXT();
+    HANDLER(BCC) if (!m.c) r[7] += op->value; NEXT();
+    HANDLER(BCS) if (m.c) r[7] += op->value; NEXT();
+    HANDLER(BPL) if (!m.n) r[7] += op->value; NEXT();
+    HANDLER(BMI) if (m.n) r[7] += op->value; NEXT();
+    HANDLER(BL)  r[6] = r[7]; r[7] += op->value; NEXT();
+
+    HANDLER(HALT)
+        reason = StopReason::HALT;
+        goto stop;
+
+    HANDLER(FAULT)
+        m.instructions--;
+        r[7]--;
+        reason = StopReason::FETCH_FAULT;
+        goto stop;
+
+#ifndef SBASM_SIM_THREADED
+        }
+    }
+#endif
+#undef HANDLER
+#undef NEXT
+
+stop:
+    return collectResult(m, reason);
+}
@@ -0,0 +1,95 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Cycle-counting qCore simulator (--run)
+//              Executes an assembled image on the DE10-Lite memory map from
+//              the --doc reference: program memory, LEDs, 7-segment display,
+//              switches and the interval timer with its ISR at 0x0064.
+//              Every memory word is predecoded once into a micro-op (and
+//              again when a store changes it), and the interpreter loop
+//              dispatches through a computed-goto table where the compiler
+//              supports it. Instruction cycles come from the cycles column of
+//              the instruction table.
+//
+//              Processor model:
+//              - 9-bit immediates are sign extended, mvt rX, #b sets rX to
+//                b << 8, reading pc gives the address of the next word
+//              - add, sub, and, cmp set Z, N and C (carry out; for sub and
+//                cmp C=1 means no borrow), shifts set Z and N
+//              - a timer interrupt pushes pc, saves the flags and jumps to
+//                0x0064; the pop pc that takes that stack slot returns and
+//                restores the flags. Interrupts are not nested.
+//              - the timer counts down one per cycle from its data registers
+//                once started, raises the interrupt at zero and reloads
+// ============================================================================
+
+#pragma once
+#include "common.h"
+#include "MemoryImage.h"
+#include <memory>
+#include <string>
+
+constexpr uint32_t SIM_RAM_WORDS = 0x400;            // DE10-Lite program/data memory
+constexpr uint32_t SIM_IO_BASE = 0x1000;             // Programs larger than this overlap the I/O
+constexpr uint16_t SIM_LED_ADDRESS = 0x1000;
+constexpr uint16_t SIM_HEX_ADDRESS = 0x2000;
+constexpr int SIM_HEX_DIGITS = 6;
+constexpr uint16_t SIM_SWITCH_ADDRESS = 0x3000;
+constexpr uint16_t SIM_TIMER_LOW_ADDRESS = 0x4000;
+constexpr uint16_t SIM_TIMER_HIGH_ADDRESS = 0x4001;
+constexpr uint16_t SIM_TIMER_CONTROL_ADDRESS = 0x5000;
+constexpr uint16_t SIM_ISR_ADDRESS = 0x0064;
+constexpr int SIM_INTERRUPT_CYCLES = 6;              // Entry costs as much as a push
+constexpr uint64_t SIM_DEFAULT_MAX_CYCLES = 100000000;
+
+enum class StopReason : uint8_t {
+    HALT,           // halt executed
+    CYCLE_LIMIT,    // maxCycles reached
+    FETCH_FAULT     // pc left program memory
+};
+
+struct SimResult {
+    StopReason reason;
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    uint64_t interrupts = 0;
+    uint16_t registers[8] = {};
+    bool z = false, n = false, c = false;
+    uint16_t leds = 0;
+    uint16_t hex[SIM_HEX_DIGITS] = {};
+    uint16_t faultAddress = 0;      // pc of a FETCH_FAULT
+};
+
+class Simulator {
+public:
+    // One predecoded memory word
+    struct MicroOp {
+        uint8_t handler;
+        uint8_t rX;
+        uint8_t rY;
+        uint8_t cycles;
+        int16_t value;
+    };
+
+private:
+    uint32_t ramWords;
+    std::unique_ptr<uint16_t[]> initial;    // Image as loaded, every run starts from it
+    std::unique_ptr<uint16_t[]> memory;     // Program/data memory
+    std::unique_ptr<MicroOp[]> ops;         // One per address - fetches need no bounds check
+    uint16_t switches = 0;
+
+public:
+    // Micro-op for a word in program memory
+    static MicroOp predecodeWord(uint16_t word);
+
+    // Memory is the DE10-Lite's 1024 words, or the image size if larger.
+    // Throws if the image reaches into the I/O region.
+    explicit Simulator(const MemoryImage& image);
+
+    void setSwitches(uint16_t value) { switches = value; }
+    uint32_t getMemoryWords() const { return ramWords; }
+
+    // Run from address 0 with cleared registers until halt, a fetch outside
+    // memory or 'maxCycles'
+    SimResult run(uint64_t maxCycles);
+};
@@ -0,0 +1,86 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Memory-mapped source file implementation
+// ============================================================================
+
+#include "SourceFile.h"
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SBASM_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+void SourceFile::readFallback(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        throw std::runtime_error("Could not open file '" + path + "'");
+    }
+    buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    if (in.bad()) {
+        throw std::runtime_error("Failed to read file '" + path + "'");
+    }
+    length = buffer.size();
+    buffer.push_back('\0');    // Flex requires two trailing NULs
+    buffer.push_back('\0');
+    base = buffer.data();
+}
+
+SourceFile::SourceFile(const std::string& path) {
+#ifdef SBASM_HAVE_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open file '" + path + "'");
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0) {
+        ::close(fd);
+        readFallback(path);
+        return;
+    }
+
+    // Reserve the file size plus the two NULs as zeroed anonymous memory,
+    // then map the file copy-on-write over its start. The scanner writes
+    // temporary terminators into the text, so the mapping must be writable.
+    // Bytes past the end of the file read as zero either way.
+    const size_t fileSize = static_cast<size_t>(info.st_size);
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t total = (fileSize + 2 + page - 1) / page * page;
+
+    void* region = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region != MAP_FAILED) {
+        void* file = mmap(region, fileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0);
+        if (file == MAP_FAILED) {
+            munmap(region, total);
+            region = MAP_FAILED;
+        }
+    }
+    ::close(fd);
+
+    if (region == MAP_FAILED) {
+        readFallback(path);
+        return;
+    }
+
+    base = static_cast<char*>(region);
+    length = fileSize;
+    mappedSize = total;
+#else
+    readFallback(path);
+#endif
+}
+
+SourceFile::~SourceFile() {
+#ifdef SBASM_HAVE_MMAP
+    if (mappedSize != 0) {
+        munmap(base, mappedSize);
+    }
+#endif
+}
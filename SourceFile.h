@@ -0,0 +1,42 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Assembly source loaded for in-place scanning
+//              Regular files are memory-mapped copy-on-write, everything
+//              else (pipes, unsupported platforms) is read into memory.
+//              Either way the text is followed by the two NUL bytes the
+//              scanner needs, and tokens stay zero-copy views into it.
+// ============================================================================
+
+#pragma once
+#include "common.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+class SourceFile {
+private:
+    char* base = nullptr;       // Start of the text
+    size_t length = 0;          // Text length, excluding the trailing NULs
+    size_t mappedSize = 0;      // Size of the mapping, 0 if not mapped
+    std::vector<char> buffer;   // Storage when the file could not be mapped
+
+    void readFallback(const std::string& path);
+
+public:
+    // Throws std::runtime_error if the file cannot be opened or read
+    explicit SourceFile(const std::string& path);
+    ~SourceFile();
+
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+
+    // Writable scan buffer - the text followed by two NUL bytes
+    char* data() { return base; }
+    size_t bufferSize() const { return length + 2; }
+
+    size_t size() const { return length; }
+    std::string_view text() const { return std::string_view(base, length); }
+
+    bool isMapped() const { return mappedSize != 0; }
+};
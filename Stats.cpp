@@ -0,0 +1,124 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: --stats report writers
+// ============================================================================
+
+#include "Stats.h"
+#include <iomanip>
+
+namespace {
+
+// Format: {JSON key, text label, field}
+struct StatsCounterDef {
+    std::string_view key;
+    std::string_view label;
+    size_t AssemblyStats::*field;
+};
+
+struct StatsGroupDef {
+    std::string_view key;
+    std::string_view label;
+    const StatsCounterDef* counters;
+    size_t count;
+};
+
+constexpr StatsCounterDef PROGRAM_COUNTERS[] = {
+    {"bytes",            "Source bytes",          &AssemblyStats::sourceBytes},
+    {"includedFiles",    "Included files parsed", &AssemblyStats::includedFiles},
+    {"cachedFiles",      "Included from cache",   &AssemblyStats::cachedFiles},
+    {"statements",       "Statements",            &AssemblyStats::statements},
+    {"instructions",     "Instructions",          &AssemblyStats::instructions},
+    {"directives",       "Directives",            &AssemblyStats::directives},
+    {"labels",           "Labels",                &AssemblyStats::labels},
+    {"macroInvocations", "Macro invocations",     &AssemblyStats::macroInvocations},
+    {"macroReplays",     "Macro expansions reused", &AssemblyStats::macroReplays},
+};
+
+constexpr StatsCounterDef SYMBOL_COUNTERS[] = {
+    {"symbols",       "Symbols",              &AssemblyStats::symbols},
+    {"nameLookups",   "Name lookups",         &AssemblyStats::nameLookups},
+    {"symbolLookups", "Symbol table lookups", &AssemblyStats::symbolLookups},
+};
+
+constexpr StatsCounterDef MEMORY_COUNTERS[] = {
+    {"arenaAllocations", "Arena allocations", &AssemblyStats::arenaAllocations},
+    {"arenaBlocks",      "Arena blocks",      &AssemblyStats::arenaBlocks},
+    {"arenaBytes",       "Arena bytes",       &AssemblyStats::arenaBytes},
+};
+
+constexpr StatsCounterDef ENCODE_COUNTERS[] = {
+    {"layoutPasses",         "Layout passes",         &AssemblyStats::layoutPasses},
+    {"encodePasses",         "Encode passes",         &AssemblyStats::encodePasses},
+    {"fixups",               "Fixups",                &AssemblyStats::fixups},
+    {"expandedInstructions", "Expanded instructions", &AssemblyStats::expandedInstructions},
+    {"relaxedBranches",      "Relaxed branches",      &AssemblyStats::relaxedBranches},
+    {"shortLoads",           "Short loads",           &AssemblyStats::shortLoads},
+    {"peepholeRewrites",     "Peephole rewrites",     &AssemblyStats::peepholeRewrites},
+    {"words",                "Words",                 &AssemblyStats::words},
+};
+
+constexpr StatsGroupDef STATS_GROUPS[] = {
+    {"program", "Program",  PROGRAM_COUNTERS, std::size(PROGRAM_COUNTERS)},
+    {"symbols", "Symbols",  SYMBOL_COUNTERS, std::size(SYMBOL_COUNTERS)},
+    {"memory",  "Memory",   MEMORY_COUNTERS, std::size(MEMORY_COUNTERS)},
+    {"encode",  "Encoding", ENCODE_COUNTERS, std::size(ENCODE_COUNTERS)},
+};
+
+double milliseconds(uint64_t nanos) {
+    return static_cast<double>(nanos) / 1e6;
+}
+
+} // namespace
+
+uint64_t AssemblyStats::totalNanos() const {
+    uint64_t total = 0;
+    for (uint64_t nanos : phaseNanos) {
+        total += nanos;
+    }
+    return total;
+}
+
+void writeStatsText(const AssemblyStats& stats, std::ostream& out) {
+    const uint64_t total = stats.totalNanos();
+    out << "\n=== Statistics ===\n" << std::fixed << std::setprecision(3);
+    for (const StatsPhaseDef& def : STATS_PHASES) {
+        const uint64_t nanos = stats.phaseNanos[static_cast<size_t>(def.phase)];
+        out << "  " << std::left << std::setw(24) << def.name << std::right << std::setw(10)
+            << milliseconds(nanos) << " ms";
+        if (total > 0) {
+            out << std::setprecision(1) << std::setw(7) << 100.0 * static_cast<double>(nanos) / total
+                << " %" << std::setprecision(3);
+        }
+        out << "\n";
+    }
+    out << "  " << std::left << std::setw(24) << "total" << std::right << std::setw(10)
+        << milliseconds(total) << " ms\n" << std::defaultfloat;
+
+    for (const StatsGroupDef& group : STATS_GROUPS) {
+        out << group.label << ":\n";
+        for (size_t i = 0; i < group.count; i++) {
+            const StatsCounterDef& counter = group.counters[i];
+            out << "  " << std::left << std::setw(24) << counter.label << std::right << std::setw(10)
+                << stats.*counter.field << "\n";
+        }
+    }
+}
+
+void writeStatsJson(const AssemblyStats& stats, const std::string& source, std::ostream& out) {
+    out << "{\n  \"source\": " << jsonString(source) << ",\n  \"phases\": {";
+    for (size_t i = 0; i < STATS_PHASE_COUNT; i++) {
+        out << (i == 0 ? "\n" : ",\n") << "    \"" << STATS_PHASES[i].name << "Nanos\": "
+            << stats.phaseNanos[static_cast<size_t>(STATS_PHASES[i].phase)];
+    }
+    out << ",\n    \"totalNanos\": " << stats.totalNanos() << "\n  }";
+    for (const StatsGroupDef& group : STATS_GROUPS) {
+        out << ",\n  \"" << group.key << "\": {";
+        for (size_t i = 0; i < group.count; i++) {
+            const StatsCounterDef& counter = group.counters[i];
+            out << (i == 0 ? "\n" : ",\n") << "    \"" << counter.key << "\": " << stats.*counter.field;
+        }
+        out << "\n  }";
+    }
+    out << "\n}\n";
+}
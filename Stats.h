@@ -0,0 +1,95 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Phase timings and work counters of one assembly (--stats)
+//              Phases are timed with one clock read at each end, and the
+//              counters are plain increments or are derived from the AST
+//              and image afterwards, so collecting them costs nothing
+//              measurable. They are only printed on request.
+// ============================================================================
+
+#pragma once
+#include "common.h"
+#include <chrono>
+#include <iterator>
+#include <string_view>
+
+// Adds the time until it goes out of scope to 'total', in nanoseconds
+class ScopedTimer {
+private:
+    uint64_t& total;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit ScopedTimer(uint64_t& target) : total(target), start(std::chrono::steady_clock::now()) {}
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    ~ScopedTimer() {
+        total += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+};
+
+enum class StatsPhase : uint8_t {
+    PARSE,      // Scanning, macro expansion and yyparse, includes included
+    LAYOUT,     // Encoder passes that only size statements and place labels
+    ENCODE,     // Encoder passes that emit words and patch fixups
+    OUTPUT      // Writing the output file
+};
+
+struct StatsPhaseDef {
+    StatsPhase phase;
+    std::string_view name;
+};
+
+inline constexpr StatsPhaseDef STATS_PHASES[] = {
+    {StatsPhase::PARSE,  "parse"},
+    {StatsPhase::LAYOUT, "layout"},
+    {StatsPhase::ENCODE, "encode"},
+    {StatsPhase::OUTPUT, "output"},
+};
+
+constexpr size_t STATS_PHASE_COUNT = std::size(STATS_PHASES);
+
+struct AssemblyStats {
+    uint64_t phaseNanos[STATS_PHASE_COUNT] = {};    // Indexed by StatsPhase
+
+    // Source
+    size_t sourceBytes = 0;             // Main source only
+    size_t includedFiles = 0;           // Scanned and parsed
+    size_t cachedFiles = 0;             // Loaded from the parse cache
+    size_t statements = 0;
+    size_t instructions = 0;
+    size_t directives = 0;
+    size_t labels = 0;
+    size_t macroInvocations = 0;
+    size_t macroReplays = 0;            // Invocations reusing an earlier expansion
+
+    // Symbols
+    size_t symbols = 0;                 // Distinct names
+    size_t nameLookups = 0;             // Names interned by the scanner
+    size_t symbolLookups = 0;           // Symbol table reads by the encoder
+
+    // Memory - AST and name arenas
+    size_t arenaAllocations = 0;
+    size_t arenaBlocks = 0;
+    size_t arenaBytes = 0;
+
+    // Encoding
+    size_t layoutPasses = 0;
+    size_t encodePasses = 0;
+    size_t fixups = 0;
+    size_t expandedInstructions = 0;    // Encoded into more than one word
+    size_t relaxedBranches = 0;
+    size_t shortLoads = 0;
+    size_t peepholeRewrites = 0;
+    size_t words = 0;
+
+    uint64_t& phase(StatsPhase p) { return phaseNanos[static_cast<size_t>(p)]; }
+    uint64_t totalNanos() const;
+};
+
+void writeStatsText(const AssemblyStats& stats, std::ostream& out);
+void writeStatsJson(const AssemblyStats& stats, const std::string& source, std::ostream& out);
@@ -0,0 +1,53 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: String interning for symbol names
+//              The lexer interns every identifier once and hands out a dense
+//              SymbolId; everything downstream works with the ID only.
+// ============================================================================
+
+#pragma once
+#include "common.h"
+#include "Arena.h"
+#include <vector>
+#include <string_view>
+
+using SymbolId = int32_t;
+constexpr SymbolId NO_SYMBOL = -1;
+
+class StringInterner {
+private:
+    Arena storage;                                        // Owns the name characters
+    std::unordered_map<std::string_view, SymbolId> ids;  // Keys point into 'storage'
+    std::vector<std::string_view> names;                 // Indexed by SymbolId
+    size_t lookups = 0;                                   // intern() calls (--stats)
+
+public:
+    SymbolId intern(std::string_view text) {
+        lookups++;
+        auto it = ids.find(text);
+        if (it != ids.end()) {
+            return it->second;
+        }
+        SymbolId id = static_cast<SymbolId>(names.size());
+        std::string_view stored = storage.copyString(text);
+        ids.emplace(stored, id);
+        names.push_back(stored);
+        return id;
+    }
+
+    SymbolId intern(const char* text, size_t length) {
+        return intern(std::string_view(text, length));
+    }
+
+    std::string_view name(SymbolId id) const {
+        if (id < 0 || static_cast<size_t>(id) >= names.size()) {
+            return std::string_view();
+        }
+        return names[id];
+    }
+
+    size_t size() const { return names.size(); }
+    size_t getLookups() const { return lookups; }
+    const Arena& getStorage() const { return storage; }
+};
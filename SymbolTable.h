@@ -2,52 +2,81 @@
 // Author: LeonW
 // Date: February 3, 2025
 // Description: Symbol table for managing labels and defines
+//              Dense vector indexed by interned SymbolId - one lookup per use
 // ============================================================================
 
 #pragma once
 #include "common.h"
+#include "StringInterner.h"
+#include <vector>
+#include <algorithm>
+
+enum class SymbolKind : uint8_t {
+    UNDEFINED,
+    LABEL,
+    DEFINE
+};
+
+struct Symbol {
+    SymbolKind kind = SymbolKind::UNDEFINED;
+    int value = 0;
+};
 
 class SymbolTable {
 private:
-    std::unordered_map<std::string, int> labels;
-    std::unordered_map<std::string, int> defines;
+    const StringInterner& names;
+    std::vector<Symbol> symbols;
 
-public:
-    void addLabel(const std::string& name, int address) {
-        if (labels.find(name) != labels.end()) {
-            throw std::runtime_error("Duplicate label: " + name);
+    // False if the symbol already has a definition
+    bool define(SymbolId id, SymbolKind kind, int value) {
+        if (id < 0) {
+            return false;
+        }
+        if (static_cast<size_t>(id) >= symbols.size()) {
+            symbols.resize(std::max(names.size(), static_cast<size_t>(id) + 1));
+        }
+        Symbol& sym = symbols[id];
+        if (sym.kind != SymbolKind::UNDEFINED) {
+            return false;
         }
-        labels[name] = address;
+        sym.kind = kind;
+        sym.value = value;
+        return true;
     }
 
-    void addDefine(const std::string& name, int value) {
-        if (defines.find(name) != defines.end()) {
-            throw std::runtime_error("Duplicate define: " + name);
-        }
-        defines[name] = value;
+public:
+    explicit SymbolTable(const StringInterner& interner) : names(interner) {}
+
+    // Both return false for a duplicate definition
+    bool addLabel(SymbolId id, int address) {
+        return define(id, SymbolKind::LABEL, address);
     }
 
-    int getLabelAddress(const std::string& name) const {
-        auto it = labels.find(name);
-        if (it == labels.end()) {
-            throw std::runtime_error("Undefined label: " + name);
-        }
-        return it->second;
+    bool addDefine(SymbolId id, int value) {
+        return define(id, SymbolKind::DEFINE, value);
+    }
+
+    // Forget all definitions (before encoding the program again)
+    void clear() {
+        symbols.clear();
     }
 
-    int getDefineValue(const std::string& name) const {
-        auto it = defines.find(name);
-        if (it == defines.end()) {
-            throw std::runtime_error("Undefined symbol: " + name);
+    // Combined lookup - kind is UNDEFINED if the symbol has no value yet
+    Symbol lookup(SymbolId id) const {
+        if (id < 0 || static_cast<size_t>(id) >= symbols.size()) {
+            return Symbol();
         }
-        return it->second;
+        return symbols[id];
     }
 
-    bool hasLabel(const std::string& name) const {
-        return labels.find(name) != labels.end();
+    // False if 'id' is not a defined label
+    bool getLabelAddress(SymbolId id, int& address) const {
+        const Symbol sym = lookup(id);
+        address = sym.value;
+        return sym.kind == SymbolKind::LABEL;
     }
 
-    bool hasDefine(const std::string& name) const {
-        return defines.find(name) != defines.end();
+    std::string_view getName(SymbolId id) const {
+        return names.name(id);
     }
 };
@@ -0,0 +1,619 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Static timing analysis implementation
+// ============================================================================
+
+#include "Timing.h"
+#include "InstructionDef.h"
+#include "Simulator.h"
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+constexpr uint8_t LINK_REGISTER = 6;
+constexpr size_t NO_NODE = static_cast<size_t>(-1);
+
+uint64_t addCycles(uint64_t a, uint64_t b) {
+    return (a == TIMING_UNBOUNDED || b == TIMING_UNBOUNDED || a > TIMING_UNBOUNDED - 1 - b) ? TIMING_UNBOUNDED : a + b;
+}
+
+uint64_t mulCycles(uint64_t a, uint64_t count) {
+    if (a == TIMING_UNBOUNDED || count == 0 || (a != 0 && count > (TIMING_UNBOUNDED - 1) / a)) {
+        return TIMING_UNBOUNDED;
+    }
+    return a * count;
+}
+
+std::string hexAddress(uint32_t address) {
+    std::ostringstream out;
+    out << "0x" << std::hex << std::setw(4) << std::setfill('0') << address;
+    return out.str();
+}
+
+// Control flow of one instruction word
+struct Flow {
+    BlockExit exit;                 // FALLTHROUGH for instructions that do not end a block
+    uint32_t target = NO_ADDRESS;
+};
+
+struct LoopBound {
+    uint64_t count;
+    const Statement* stmt;
+    bool used = false;
+};
+
+class TimingAnalysis {
+private:
+    const ProgramAST& ast;
+    const SymbolTable& symbols;
+    std::vector<uint16_t> words;
+    std::vector<char> code;
+    std::map<uint32_t, std::string> labels;         // First label at each address
+    std::map<uint32_t, LoopBound> bounds;           // By header address
+    std::vector<size_t> blockAt;                    // Block index by start address
+    std::map<uint32_t, size_t> routineAt;
+    std::vector<char> routineState;                 // 0 new, 1 in progress, 2 done
+    TimingReport report;
+
+    bool isCode(uint32_t address) const { return address < code.size() && code[address]; }
+
+    std::string labelOrAddress(uint32_t address) const {
+        const auto it = labels.find(address);
+        return it != labels.end() ? it->second : hexAddress(address);
+    }
+
+    std::string location(const Statement& stmt) const {
+        std::string text = "line " + std::to_string(stmt.line);
+        if (stmt.file != 0) {
+            text += " of " + std::string(ast.fileName(stmt.file));
+        }
+        return text;
+    }
+
+    Flow classify(uint32_t address) const {
+        const DecodedWord decoded = decodeWord(words[address]);
+        switch (decoded.op) {
+            case Operation::BRANCH: {
+                const uint32_t target = branchTarget(words[address], address) & 0xFFFF;
+                if (decoded.rX == 0) return {BlockExit::JUMP, target};
+                if (decoded.rX == 7) return {BlockExit::CALL, target};
+                return {BlockExit::BRANCH, target};
+            }
+            case Operation::HALT:
+                return {BlockExit::HALT};
+            case Operation::CMP:
+            case Operation::ST:
+            case Operation::PUSH:
+                return {BlockExit::FALLTHROUGH};
+            default:
+                break;
+        }
+        if (decoded.rX != PC_REGISTER) {
+            return {BlockExit::FALLTHROUGH};
+        }
+        if (decoded.op == Operation::POP ||
+            (decoded.op == Operation::MV && !decoded.immediate && decoded.rY == LINK_REGISTER)) {
+            return {BlockExit::RETURN};
+        }
+        // ld pc, [pc] reads the word after it - a long branch
+        if (decoded.op == Operation::LD && decoded.rY == PC_REGISTER && address + 1 < words.size() &&
+            !isCode(address + 1)) {
+            return {BlockExit::JUMP, words[address + 1]};
+        }
+        return {BlockExit::INDIRECT};
+    }
+
+    void collectAnnotations() {
+        for (const Statement& stmt : ast) {
+            if (stmt.type == StatementType::LABEL) {
+                const Symbol sym = symbols.lookup(stmt.label.symbol);
+                labels.emplace(static_cast<uint32_t>(sym.value), std::string(stmt.label.name));
+                continue;
+            }
+            if (stmt.type != StatementType::DIRECTIVE || stmt.directive.name != ".loopbound") {
+                continue;
+            }
+            const Directive& dir = stmt.directive;
+            const Symbol sym = symbols.lookup(dir.labelSymbol);
+            if (dir.labelSymbol == NO_SYMBOL || sym.kind != SymbolKind::LABEL) {
+                throw std::runtime_error("Error at " + location(stmt) + ": .loopbound expects a label and a count" +
+                                         (dir.label.empty() ? "" : ", '" + std::string(dir.label) + "' is not a label"));
+            }
+            if (!dir.number.valid || dir.number.value <= 0) {
+                throw std::runtime_error("Error at " + location(stmt) + ": invalid .loopbound count '" +
+                                         std::string(dir.value) + "'");
+            }
+            const uint32_t header = static_cast<uint32_t>(sym.value);
+            const uint64_t count = static_cast<uint64_t>(dir.number.value);
+            if (!bounds.emplace(header, LoopBound{count, &stmt}).second) {
+                throw std::runtime_error("Error at " + location(stmt) + ": second .loopbound for '" +
+                                         std::string(dir.label) + "'");
+            }
+        }
+    }
+
+    // Walk all code reachable from the routine entries and split it into
+    // basic blocks
+    void buildBlocks(std::vector<uint32_t> entries) {
+        std::vector<char> visited(words.size(), 0);
+        std::vector<char> leader(words.size(), 0);
+        std::vector<Flow> flows(words.size());
+        std::vector<uint32_t> calls;
+
+        std::vector<uint32_t> pending;
+        for (uint32_t entry : entries) {
+            leader[entry] = 1;
+            pending.push_back(entry);
+        }
+        while (!pending.empty()) {
+            const uint32_t address = pending.back();
+            pending.pop_back();
+            if (visited[address]) {
+                continue;
+            }
+            visited[address] = 1;
+
+            Flow& flow = flows[address] = classify(address);
+            bool fault = false;
+            auto follow = [&](uint32_t next, bool isLeader) {
+                if (!isCode(next)) {
+                    fault = true;
+                    return;
+                }
+                leader[next] |= isLeader;
+                pending.push_back(next);
+            };
+            switch (flow.exit) {
+                case BlockExit::FALLTHROUGH:
+                    follow(address + 1, false);
+                    break;
+                case BlockExit::BRANCH:
+                    follow(flow.target, true);
+                    follow(address + 1, true);
+                    break;
+                case BlockExit::JUMP:
+                    follow(flow.target, true);
+                    break;
+                case BlockExit::CALL:
+                    if (isCode(flow.target)) {
+                        calls.push_back(flow.target);
+                    }
+                    follow(flow.target, true);
+                    follow(address + 1, true);
+                    break;
+                default:
+                    break;
+            }
+            if (fault) {
+                flow.exit = BlockExit::FAULT;
+            }
+        }
+        for (const auto& [address, name] : labels) {
+            if (address < words.size() && visited[address]) {
+                leader[address] = 1;
+            }
+        }
+
+        // Blocks in address order
+        blockAt.assign(words.size(), NO_NODE);
+        TimingBlock* open = nullptr;
+        for (uint32_t address = 0; address < words.size(); address++) {
+            if (!visited[address]) {
+                open = nullptr;
+                continue;
+            }
+            if (open == nullptr || leader[address]) {
+                if (open != nullptr) {
+                    open->exit = BlockExit::FALLTHROUGH;
+                    open->successors.push_back(address);
+                }
+                blockAt[address] = report.blocks.size();
+                TimingBlock block;
+                block.start = address;
+                block.end = address;
+                block.cycles = 0;
+                block.exit = BlockExit::FALLTHROUGH;
+                const auto label = labels.find(address);
+                if (label != labels.end()) {
+                    block.label = label->second;
+                }
+                report.blocks.push_back(std::move(block));
+                open = &report.blocks.back();
+            }
+            const Flow& flow = flows[address];
+            open->end = address + 1;
+            open->cycles += getDecodedDef(decodeWord(words[address]))->cycles;
+            if (flow.exit == BlockExit::FALLTHROUGH) {
+                continue;
+            }
+            open->exit = flow.exit;
+            open->target = flow.target;
+            switch (flow.exit) {
+                case BlockExit::BRANCH:
+                    open->successors = {flow.target, address + 1};
+                    break;
+                case BlockExit::JUMP:
+                    open->successors = {flow.target};
+                    break;
+                case BlockExit::CALL:
+                    open->successors = {address + 1};
+                    break;
+                default:
+                    break;
+            }
+            open = nullptr;
+        }
+
+        // Routines: the entries, then every bl target
+        entries.insert(entries.end(), calls.begin(), calls.end());
+        for (uint32_t entry : entries) {
+            if (routineAt.count(entry) == 0) {
+                routineAt.emplace(entry, 0);
+            }
+        }
+        for (auto& [address, index] : routineAt) {
+            index = report.routines.size();
+            TimingRoutine routine;
+            routine.name = labelOrAddress(address);
+            routine.address = address;
+            routine.interrupt = address == SIM_ISR_ADDRESS;
+            report.routines.push_back(routine);
+        }
+        routineState.assign(report.routines.size(), 0);
+    }
+
+    // Longest path from 'start' through the nodes marked in 'region', with
+    // collapsed loops represented by their header. Edges into 'excluded'
+    // (the header of the loop being costed) are not followed.
+    uint64_t longestPath(size_t start, const std::vector<char>& region, size_t excluded,
+                         const std::vector<std::vector<size_t>>& succ, const std::vector<size_t>& parent,
+                         const std::vector<uint64_t>& cost) const
+    {
+        const size_t n = succ.size();
+        auto rep = [&](size_t node) {
+            while (parent[node] != node) node = parent[node];
+            return node;
+        };
+        std::vector<std::vector<size_t>> edges(n);
+        for (size_t node = 0; node < n; node++) {
+            const size_t from = rep(node);
+            if (!region[from]) {
+                continue;
+            }
+            for (size_t next : succ[node]) {
+                const size_t to = rep(next);
+                if (to != from && region[to] && to != excluded) {
+                    edges[from].push_back(to);
+                }
+            }
+        }
+
+        // Post-order over the DAG, the remaining edges cannot form a cycle
+        // once every loop has been collapsed
+        std::vector<uint64_t> best(n, 0);
+        std::vector<char> state(n, 0);
+        std::vector<std::pair<size_t, size_t>> stack{{start, 0}};
+        state[start] = 1;
+        while (!stack.empty()) {
+            auto& [node, edge] = stack.back();
+            if (edge < edges[node].size()) {
+                const size_t next = edges[node][edge++];
+                if (state[next] == 1) {
+                    return TIMING_UNBOUNDED;
+                }
+                if (state[next] == 0) {
+                    state[next] = 1;
+                    stack.push_back({next, 0});
+                }
+                continue;
+            }
+            uint64_t tail = 0;
+            for (size_t next : edges[node]) {
+                tail = std::max(tail, best[next]);
+            }
+            best[node] = addCycles(cost[node], tail);
+            state[node] = 2;
+            stack.pop_back();
+        }
+        return best[start];
+    }
+
+    void analyzeRoutine(size_t index) {
+        routineState[index] = 1;
+        TimingRoutine& routine = report.routines[index];
+        auto unbounded = [&](const std::string& reason) {
+            if (routine.reason.empty()) {
+                routine.reason = reason;
+            }
+        };
+
+        // Blocks of the routine - calls continue after the callee
+        std::vector<size_t> nodes;
+        std::map<size_t, size_t> local;
+        std::vector<size_t> pending{blockAt[routine.address]};
+        while (!pending.empty()) {
+            const size_t block = pending.back();
+            pending.pop_back();
+            if (local.count(block) != 0) {
+                continue;
+            }
+            local.emplace(block, nodes.size());
+            nodes.push_back(block);
+            for (uint32_t next : report.blocks[block].successors) {
+                pending.push_back(blockAt[next]);
+            }
+        }
+
+        for (size_t block : nodes) {
+            routine.blocks.push_back(report.blocks[block].start);
+        }
+        std::sort(routine.blocks.begin(), routine.blocks.end());
+
+        const size_t n = nodes.size();
+        std::vector<std::vector<size_t>> succ(n);
+        std::vector<std::vector<size_t>> pred(n);
+        std::vector<uint64_t> cost(n);
+        for (size_t i = 0; i < n; i++) {
+            const TimingBlock& block = report.blocks[nodes[i]];
+            for (uint32_t next : block.successors) {
+                const size_t j = local[blockAt[next]];
+                succ[i].push_back(j);
+                pred[j].push_back(i);
+            }
+            cost[i] = block.cycles;
+            switch (block.exit) {
+                case BlockExit::CALL: {
+                    const size_t callee = routineAt.at(block.target);
+                    const std::string& name = report.routines[callee].name;
+                    if (std::find(routine.calls.begin(), routine.calls.end(), name) == routine.calls.end()) {
+                        routine.calls.push_back(name);
+                    }
+                    if (routineState[callee] == 0) {
+                        analyzeRoutine(callee);
+                    }
+                    const TimingRoutine& target = report.routines[callee];
+                    if (routineState[callee] == 1) {
+                        unbounded("recursive call to " + name + " at " + hexAddress(block.end - 1));
+                        cost[i] = TIMING_UNBOUNDED;
+                    } else if (!target.bounded()) {
+                        unbounded("calls unbounded routine " + name);
+                        cost[i] = TIMING_UNBOUNDED;
+                    } else {
+                        cost[i] = addCycles(cost[i], target.worstCaseCycles);
+                    }
+                    break;
+                }
+                case BlockExit::INDIRECT:
+                    unbounded("computed jump at " + hexAddress(block.end - 1));
+                    cost[i] = TIMING_UNBOUNDED;
+                    break;
+                case BlockExit::FAULT:
+                    unbounded("runs into data or past the image at " + hexAddress(block.end - 1));
+                    cost[i] = TIMING_UNBOUNDED;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        // Back edges - an edge to a block still on the depth-first stack
+        std::map<size_t, std::vector<size_t>> latches;
+        {
+            std::vector<char> state(n, 0);
+            std::vector<std::pair<size_t, size_t>> stack{{0, 0}};
+            state[0] = 1;
+            while (!stack.empty()) {
+                auto& [node, edge] = stack.back();
+                if (edge < succ[node].size()) {
+                    const size_t next = succ[node][edge++];
+                    if (state[next] == 1) {
+                        latches[next].push_back(node);
+                    } else if (state[next] == 0) {
+                        state[next] = 1;
+                        stack.push_back({next, 0});
+                    }
+                    continue;
+                }
+                state[node] = 2;
+                stack.pop_back();
+            }
+        }
+
+        // Natural loop of each header: the blocks that reach a latch
+        // without passing the header
+        struct Loop {
+            size_t header;
+            std::vector<char> body;
+            size_t size;
+        };
+        std::vector<Loop> loops;
+        for (const auto& [header, from] : latches) {
+            Loop loop{header, std::vector<char>(n, 0), 1};
+            loop.body[header] = 1;
+            std::vector<size_t> work(from.begin(), from.end());
+            while (!work.empty()) {
+                const size_t node = work.back();
+                work.pop_back();
+                if (loop.body[node]) {
+                    continue;
+                }
+                loop.body[node] = 1;
+                loop.size++;
+                work.insert(work.end(), pred[node].begin(), pred[node].end());
+            }
+            // Only the header may be entered from outside
+            bool reducible = !loop.body[0] || header == 0;
+            for (size_t node = 0; node < n && reducible; node++) {
+                if (loop.body[node] && node != header) {
+                    for (size_t p : pred[node]) {
+                        reducible &= loop.body[p] != 0;
+                    }
+                }
+            }
+            const uint32_t address = report.blocks[nodes[header]].start;
+            auto bound = bounds.find(address);
+            if (bound != bounds.end()) {
+                bound->second.used = true;
+            }
+            if (!reducible) {
+                unbounded("loop at " + labelOrAddress(address) + " is entered other than through its header");
+                routineState[index] = 2;
+                return;
+            }
+            loops.push_back(std::move(loop));
+        }
+        std::sort(loops.begin(), loops.end(), [](const Loop& a, const Loop& b) { return a.size < b.size; });
+
+        // Cost loops innermost first, then collapse each into its header
+        std::vector<size_t> parent(n);
+        for (size_t i = 0; i < n; i++) {
+            parent[i] = i;
+        }
+        for (const Loop& loop : loops) {
+            const uint32_t address = report.blocks[nodes[loop.header]].start;
+            const auto bound = bounds.find(address);
+            const uint64_t count = bound != bounds.end() ? bound->second.count : 0;
+            const uint64_t iteration = longestPath(loop.header, loop.body, loop.header, succ, parent, cost);
+            routine.loops.push_back({address, labelOrAddress(address), count, iteration});
+            if (count == 0) {
+                unbounded("loop at " + labelOrAddress(address) + " has no .loopbound");
+            }
+
+            cost[loop.header] = mulCycles(iteration, count);
+            for (size_t node = 0; node < n; node++) {
+                if (loop.body[node] && node != loop.header) {
+                    size_t top = node;
+                    while (parent[top] != top) top = parent[top];
+                    if (top != loop.header) {
+                        parent[top] = loop.header;
+                    }
+                }
+            }
+        }
+
+        const std::vector<char> all(n, 1);
+        routine.worstCaseCycles = longestPath(0, all, NO_NODE, succ, parent, cost);
+        if (routine.bounded() && routine.interrupt) {
+            routine.worstCaseCycles = addCycles(routine.worstCaseCycles, SIM_INTERRUPT_CYCLES);
+        }
+        if (!routine.bounded()) {
+            unbounded("irreducible control flow");
+        }
+        routineState[index] = 2;
+    }
+
+public:
+    TimingAnalysis(const MemoryImage& image, const ProgramAST& program, const SymbolTable& table)
+        : ast(program), symbols(table), words(image.size()), code(image.size(), 0)
+    {
+        image.forEachWord([&](uint32_t address, uint16_t word, bool data) {
+            words[address] = word;
+            code[address] = !data;
+        });
+    }
+
+    TimingReport run() {
+        collectAnnotations();
+
+        std::vector<uint32_t> entries;
+        if (isCode(0)) {
+            entries.push_back(0);
+        }
+        if (isCode(SIM_ISR_ADDRESS) && labels.count(SIM_ISR_ADDRESS) != 0) {
+            entries.push_back(SIM_ISR_ADDRESS);
+        }
+        buildBlocks(entries);
+        for (size_t i = 0; i < report.routines.size(); i++) {
+            if (routineState[i] == 0) {
+                analyzeRoutine(i);
+            }
+        }
+
+        for (const auto& [address, bound] : bounds) {
+            if (!bound.used) {
+                throw std::runtime_error("Error at " + location(*bound.stmt) + ": .loopbound label '" +
+                                         std::string(bound.stmt->directive.label) +
+                                         "' is not the header of a reachable loop");
+            }
+        }
+        return std::move(report);
+    }
+};
+
+const char* exitName(BlockExit exit) {
+    switch (exit) {
+        case BlockExit::FALLTHROUGH: return "fallthrough";
+        case BlockExit::BRANCH:      return "branch";
+        case BlockExit::JUMP:        return "jump";
+        case BlockExit::CALL:        return "call";
+        case BlockExit::RETURN:      return "return";
+        case BlockExit::HALT:        return "halt";
+        case BlockExit::INDIRECT:    return "indirect";
+        case BlockExit::FAULT:       return "fault";
+    }
+    return "";
+}
+
+std::string jsonCycles(uint64_t cycles) {
+    return cycles == TIMING_UNBOUNDED ? "null" : std::to_string(cycles);
+}
+
+} // namespace
+
+TimingReport analyzeTiming(const MemoryImage& image, const ProgramAST& ast, const SymbolTable& symbols) {
+    return TimingAnalysis(image, ast, symbols).run();
+}
+
+void writeTimingJson(const TimingReport& report, const std::string& source, std::ostream& out) {
+    out << "{\n  \"source\": " << jsonString(source) << ",\n  \"blocks\": [";
+    for (size_t i = 0; i < report.blocks.size(); i++) {
+        const TimingBlock& block = report.blocks[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\"start\": " << block.start << ", \"end\": " << block.end
+            << ", \"label\": " << (block.label.empty() ? "null" : jsonString(block.label))
+            << ", \"cycles\": " << block.cycles << ", \"exit\": \"" << exitName(block.exit) << "\"";
+        if (block.target != NO_ADDRESS) {
+            out << ", \"target\": " << block.target;
+        }
+        out << ", \"successors\": [";
+        for (size_t j = 0; j < block.successors.size(); j++) {
+            out << (j == 0 ? "" : ", ") << block.successors[j];
+        }
+        out << "]}";
+    }
+    out << "\n  ],\n  \"routines\": [";
+    for (size_t i = 0; i < report.routines.size(); i++) {
+        const TimingRoutine& routine = report.routines[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\n      \"name\": " << jsonString(routine.name)
+            << ",\n      \"address\": " << routine.address
+            << ",\n      \"interrupt\": " << (routine.interrupt ? "true" : "false")
+            << ",\n      \"bounded\": " << (routine.bounded() ? "true" : "false")
+            << ",\n      \"worstCaseCycles\": " << jsonCycles(routine.worstCaseCycles);
+        if (!routine.reason.empty()) {
+            out << ",\n      \"reason\": " << jsonString(routine.reason);
+        }
+        out << ",\n      \"blocks\": [";
+        for (size_t j = 0; j < routine.blocks.size(); j++) {
+            out << (j == 0 ? "" : ", ") << routine.blocks[j];
+        }
+        out << "],\n      \"calls\": [";
+        for (size_t j = 0; j < routine.calls.size(); j++) {
+            out << (j == 0 ? "" : ", ") << jsonString(routine.calls[j]);
+        }
+        out << "],\n      \"loops\": [";
+        for (size_t j = 0; j < routine.loops.size(); j++) {
+            const TimingLoop& loop = routine.loops[j];
+            out << (j == 0 ? "\n" : ",\n") << "        {\"header\": " << loop.header
+                << ", \"label\": " << jsonString(loop.label)
+                << ", \"bound\": " << (loop.bound == 0 ? "null" : std::to_string(loop.bound))
+                << ", \"iterationCycles\": " << jsonCycles(loop.iterationCycles) << "}";
+        }
+        out << (routine.loops.empty() ? "]" : "\n      ]") << "\n    }";
+    }
+    out << "\n  ]\n}\n";
+}
@@ -0,0 +1,85 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Static cycle counts and worst-case bounds (--timing)
+//              Works on the encoded image, so relaxed branches, short loads
+//              and -O rewrites are timed as they will run. Code reachable
+//              from address 0, from every bl target and from a label at the
+//              ISR address is split into basic blocks, each costed from the
+//              cycles column of the instruction table.
+//
+//              A routine ends at mv pc, lr, pop pc or halt; a bl adds the
+//              callee's bound. Every loop header needs an annotation
+//
+//                  .loopbound <label> <count>
+//
+//              giving the most times the header runs per entry into the
+//              loop. A loop then costs count times its worst pass through
+//              the body, inner loops first. Routines with recursion,
+//              computed jumps, irreducible loops or a missing bound are
+//              reported as unbounded together with the reason.
+// ============================================================================
+
+#pragma once
+#include "common.h"
+#include "ast.h"
+#include "SymbolTable.h"
+#include "MemoryImage.h"
+#include <string>
+#include <vector>
+
+constexpr uint64_t TIMING_UNBOUNDED = static_cast<uint64_t>(-1);
+constexpr uint32_t NO_ADDRESS = static_cast<uint32_t>(-1);
+
+// How control leaves a basic block
+enum class BlockExit : uint8_t {
+    FALLTHROUGH,    // Next block starts at a label or branch target
+    BRANCH,         // Conditional branch - to the target or the next block
+    JUMP,           // b, or the ld pc, [pc] of a long branch
+    CALL,           // bl - continues after the callee returns
+    RETURN,         // mv pc, lr or pop pc
+    HALT,
+    INDIRECT,       // Any other write to pc - the target is unknown
+    FAULT           // Runs into data or past the image
+};
+
+struct TimingBlock {
+    uint32_t start;
+    uint32_t end;                       // One past the last word
+    uint64_t cycles;                    // Its own instructions, callees excluded
+    BlockExit exit;
+    uint32_t target = NO_ADDRESS;       // Branch, jump or call target
+    std::string label;                  // First label at 'start', if any
+    std::vector<uint32_t> successors;   // Start addresses
+};
+
+struct TimingLoop {
+    uint32_t header;
+    std::string label;
+    uint64_t bound;                     // From .loopbound, 0 if missing
+    uint64_t iterationCycles;           // Worst pass through the body
+};
+
+struct TimingRoutine {
+    std::string name;                   // Entry label, or its address
+    uint32_t address;
+    bool interrupt = false;             // ISR - the bound includes interrupt entry
+    uint64_t worstCaseCycles = TIMING_UNBOUNDED;
+    std::vector<uint32_t> blocks;       // Start addresses in address order
+    std::vector<TimingLoop> loops;      // Innermost first
+    std::vector<std::string> calls;
+    std::string reason;                 // Why the routine is unbounded
+
+    bool bounded() const { return worstCaseCycles != TIMING_UNBOUNDED; }
+};
+
+struct TimingReport {
+    std::vector<TimingBlock> blocks;        // In address order
+    std::vector<TimingRoutine> routines;    // In address order
+};
+
+// Throws on a .loopbound that names no label, has a bad count or does not
+// mark a loop header
+TimingReport analyzeTiming(const MemoryImage& image, const ProgramAST& ast, const SymbolTable& symbols);
+
+void writeTimingJson(const TimingReport& report, const std::string& source, std::ostream& out);
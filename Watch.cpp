@@ -0,0 +1,196 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: --watch mode implementation
+// ============================================================================
+
+#include "Watch.h"
+#include "Assembler.h"
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Modification state of one watched file
+struct WatchedFile {
+    std::string path;
+    fs::file_time_type time;
+    uintmax_t size;
+
+    bool operator==(const WatchedFile& other) const {
+        return path == other.path && time == other.time && size == other.size;
+    }
+};
+
+WatchedFile statFile(const std::string& path) {
+    std::error_code ec;
+    WatchedFile file{path, fs::file_time_type::min(), static_cast<uintmax_t>(-1)};
+    const fs::file_time_type time = fs::last_write_time(path, ec);
+    if (!ec) {
+        file.time = time;
+        file.size = fs::file_size(path, ec);
+        if (ec) {
+            file.size = static_cast<uintmax_t>(-1);
+        }
+    }
+    return file;
+}
+
+std::string timestamp() {
+    const std::time_t now = std::time(nullptr);
+    char text[16];
+    std::strftime(text, sizeof(text), "%H:%M:%S", std::localtime(&now));
+    return std::string("[") + text + "] ";
+}
+
+std::vector<uint16_t> flatten(const MemoryImage& image) {
+    std::vector<uint16_t> words(image.size());
+    image.forEachWord([&](uint32_t address, uint16_t word, bool) {
+        words[address] = word;
+    });
+    return words;
+}
+
+size_t countChangedWords(const std::vector<uint16_t>& before, const std::vector<uint16_t>& after) {
+    const size_t common = std::min(before.size(), after.size());
+    size_t changed = std::max(before.size(), after.size()) - common;
+    for (size_t i = 0; i < common; i++) {
+        changed += before[i] != after[i];
+    }
+    return changed;
+}
+
+class WatchSession {
+private:
+    const WatchConfig& config;
+    AssemblerOptions assemblerOptions;
+    ParseCacheMemory memory;
+    std::unique_ptr<Assembler> current;     // Keeps the AST of the last run (and its cache entries)
+    std::vector<WatchedFile> files;
+    std::vector<uint16_t> lastWords;
+    OutputBuffer lastOutput;
+    bool haveOutput = false;
+
+    void report(const Assembler& assembler) {
+        for (const Diagnostic& diag : assembler.getDiagnostics()) {
+            std::cerr << (diag.kind == DiagnosticKind::ASSEMBLY ? "Error: " : "") << diag.message << "\n";
+        }
+        std::cerr << timestamp() << config.input << ": failed, waiting for changes" << std::endl;
+    }
+
+    // Format and write the image, skipping the write if the output is unchanged
+    void write(const MemoryImage& image, std::chrono::steady_clock::time_point start) {
+        OutputOptions options = config.outputOptions;
+        options.depth = resolveMemoryDepth(image.size(), config.requestedDepth);
+
+        OutputBuffer out;
+        formatOutput(image, options, out);
+
+        std::string outputFile = config.output;
+        addOutputExtension(outputFile, options.format);
+
+        std::vector<uint16_t> words = flatten(image);
+        const size_t changed = haveOutput ? countChangedWords(lastWords, words) : words.size();
+
+        std::error_code ec;
+        const bool unchanged = haveOutput && out == lastOutput && fs::exists(outputFile, ec);
+        if (!unchanged) {
+            out.writeToFile(outputFile);
+        }
+
+        const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start);
+        std::cout << timestamp() << config.input << ": " << image.size() << " words, "
+                  << changed << " changed, "
+                  << (unchanged ? "output unchanged" : "wrote " + outputFile)
+                  << " (" << includeSummary() << elapsed.count() << " ms)" << std::endl;
+
+        lastWords = std::move(words);
+        lastOutput = std::move(out);
+        haveOutput = true;
+    }
+
+    std::string includeSummary() const {
+        const IncludeResolver& includes = current->getIncludes();
+        if (includes.getCachedFiles() + includes.getParsedFiles() == 0) {
+            return "";
+        }
+        return "includes: " + std::to_string(includes.getParsedFiles()) + " parsed, " +
+               std::to_string(includes.getCachedFiles()) + " reused, ";
+    }
+
+public:
+    explicit WatchSession(const WatchConfig& cfg) : config(cfg), assemblerOptions(cfg.assemblerOptions) {
+        assemblerOptions.includes.memoryCache = &memory;
+    }
+
+    void rebuild() {
+        const auto start = std::chrono::steady_clock::now();
+
+        // Watch every file this run read, including the ones that failed to
+        // parse. The input is checked before it is read, so an edit during
+        // the run triggers another one.
+        std::vector<WatchedFile> watched;
+        watched.push_back(statFile(config.input));
+
+        auto assembler = std::make_unique<Assembler>();
+        assembler->setOptions(assemblerOptions);
+        const bool ok = assembler->assembleFile(config.input);
+
+        const ProgramAST& ast = assembler->getAST();
+        for (size_t i = 1; i < ast.fileCount(); i++) {
+            watched.push_back(statFile(ast.fileName(static_cast<uint16_t>(i))));
+        }
+
+        // The previous AST is released here - only then may its cache entries go
+        current = std::move(assembler);
+        memory.prune();
+        files = std::move(watched);
+
+        if (!ok) {
+            report(*current);
+            return;
+        }
+        try {
+            write(current->getImage(), start);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n"
+                      << timestamp() << config.input << ": failed, waiting for changes" << std::endl;
+        }
+    }
+
+    // True once any watched file differs from the last run
+    bool changed() const {
+        for (const WatchedFile& file : files) {
+            if (!(statFile(file.path) == file)) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+} // namespace
+
+int runWatch(const WatchConfig& config) {
+    std::error_code ec;
+    if (!fs::is_regular_file(config.input, ec)) {
+        std::cerr << "Error: Could not open file '" << config.input << "'" << std::endl;
+        return 1;
+    }
+
+    WatchSession session(config);
+    std::cout << "Watching " << config.input << " (Ctrl-C to stop)" << std::endl;
+    for (;;) {
+        session.rebuild();
+        while (!session.changed()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(WATCH_POLL_MILLISECONDS));
+        }
+    }
+}
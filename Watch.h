@@ -0,0 +1,30 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: --watch mode - reassemble whenever a source file changes
+//              The session stays alive between runs: unchanged included files
+//              are loaded from an in-memory parse cache instead of being
+//              parsed again, and the output file is only rewritten when its
+//              content actually changed.
+// ============================================================================
+
+#pragma once
+#include "common.h"
+#include "OutputWriter.h"
+#include "Assembler.h"
+#include <string>
+
+constexpr int WATCH_POLL_MILLISECONDS = 200;
+
+struct WatchConfig {
+    std::string input;
+    std::string output;             // Extension is added by the output writer
+    OutputOptions outputOptions;
+    AssemblerOptions assemblerOptions;
+    int requestedDepth;
+};
+
+// Assemble 'config.input', then poll it and every file it includes and
+// reassemble on each change. Only returns (with 1) if the input cannot be
+// watched at all - otherwise it runs until the process is interrupted.
+int runWatch(const WatchConfig& config);
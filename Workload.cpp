@@ -0,0 +1,150 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Synthetic workload generator implementation
+// ============================================================================
+
+#include "Workload.h"
+#include "MemoryImage.h"
+#include <algorithm>
+
+namespace {
+
+constexpr size_t CONSTANT_COUNT = 64;       // .define constants of the load and table workloads
+constexpr size_t ORG_BLOCK_WORDS = 32;      // Code per .org block
+
+// Deterministic pseudo-random numbers (64-bit LCG, high bits)
+class Random {
+private:
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+
+public:
+    uint32_t next(uint32_t bound) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return static_cast<uint32_t>((state >> 33) % bound);
+    }
+
+    std::string reg() { return "r" + std::to_string(next(6)); }
+};
+
+void line(std::string& out, std::string_view text) {
+    out += "    ";
+    out += text;
+    out += '\n';
+}
+
+void label(std::string& out, std::string_view prefix, size_t index) {
+    out += prefix;
+    out += std::to_string(index);
+    out += ":\n";
+}
+
+void defineConstants(std::string& out, Random& random) {
+    for (size_t i = 0; i < CONSTANT_COUNT; i++) {
+        // Half fit a one-word load, half need two
+        const uint32_t value = (i % 2 == 0) ? random.next(256) : 256 + random.next(0xFF00);
+        out += ".define C" + std::to_string(i) + " " + std::to_string(value) + "\n";
+    }
+}
+
+// About 7 words per block. Branches go a few blocks back or ahead; every
+// 32nd block branches half the program ahead, which needs the long form.
+void branches(std::string& out, size_t words, Random& random) {
+    const size_t blocks = words / 7 + 1;
+    for (size_t i = 0; i < blocks; i++) {
+        label(out, "b", i);
+        const std::string a = random.reg();
+        const std::string b = random.reg();
+        line(out, "add " + a + ", #" + std::to_string(random.next(256)));
+        line(out, "cmp " + a + ", " + b);
+        line(out, "bne b" + std::to_string(i - std::min<size_t>(i, random.next(4))));
+        line(out, "sub " + b + ", #1");
+        line(out, "beq b" + std::to_string(std::min(blocks, i + 1 + random.next(4))));
+        line(out, "and " + a + ", " + b);
+        if (i % 32 == 31) {
+            line(out, "bcc b" + std::to_string(std::min(blocks, i + blocks / 2)));
+        } else {
+            line(out, "mv " + b + ", " + a);
+        }
+    }
+    label(out, "b", blocks);
+    line(out, "halt");
+}
+
+// About 7 words per block: a forward and a backward =label load (two words
+// each), a load of a constant that may fit one word, and a memory access
+void labelLoads(std::string& out, size_t words, Random& random) {
+    defineConstants(out, random);
+    const size_t blocks = words / 7 + 1;
+    for (size_t i = 0; i < blocks; i++) {
+        label(out, "l", i);
+        const std::string a = random.reg();
+        const std::string b = random.reg();
+        line(out, "mv " + a + ", =l" + std::to_string(i + 1 + random.next(16)));
+        line(out, "mv " + b + ", =C" + std::to_string(random.next(CONSTANT_COUNT)));
+        line(out, "ld " + a + ", [" + b + "]");
+        line(out, "mv " + b + ", =l" + std::to_string(i - std::min<size_t>(i, random.next(16))));
+    }
+    for (size_t i = blocks; i <= blocks + 16; i++) {
+        label(out, "l", i);
+    }
+    line(out, "halt");
+}
+
+// Tables of eight values - labels of other tables, constants and numbers
+void wordTables(std::string& out, size_t words, Random& random) {
+    defineConstants(out, random);
+    line(out, "b end");
+    const size_t tables = words / 8 + 1;
+    for (size_t i = 0; i < tables; i++) {
+        label(out, "t", i);
+        std::string values = ".word ";
+        for (int j = 0; j < 8; j++) {
+            if (j > 0) {
+                values += ", ";
+            }
+            switch (random.next(3)) {
+                case 0:  values += "t" + std::to_string(random.next(static_cast<uint32_t>(tables))); break;
+                case 1:  values += "C" + std::to_string(random.next(CONSTANT_COUNT)); break;
+                default: values += std::to_string(random.next(0x10000)); break;
+            }
+        }
+        line(out, values);
+    }
+    out += "end:\n";
+    line(out, "halt");
+}
+
+// Blocks of code spread evenly over the address space, each branching to
+// the next
+void orgGaps(std::string& out, size_t words, Random& random) {
+    const size_t blocks = words / ORG_BLOCK_WORDS + 1;
+    const size_t stride = ADDRESS_SPACE_WORDS / blocks;
+    for (size_t i = 0; i < blocks; i++) {
+        out += ".org " + std::to_string(i * stride) + "\n";
+        label(out, "g", i);
+        for (size_t j = 0; j + 4 < ORG_BLOCK_WORDS; j++) {
+            line(out, "add " + random.reg() + ", #" + std::to_string(random.next(256)));
+        }
+        if (i + 1 < blocks) {
+            line(out, "b g" + std::to_string(i + 1));
+        } else {
+            line(out, "halt");
+        }
+    }
+}
+
+} // namespace
+
+std::string generateWorkload(WorkloadKind kind, size_t words) {
+    std::string out;
+    out.reserve(words * 20);
+    Random random;
+    switch (kind) {
+        case WorkloadKind::BRANCHES:    branches(out, words, random); break;
+        case WorkloadKind::LABEL_LOADS: labelLoads(out, words, random); break;
+        case WorkloadKind::WORD_TABLES: wordTables(out, words, random); break;
+        case WorkloadKind::ORG_GAPS:    orgGaps(out, words, random); break;
+    }
+    return out;
+}
@@ -0,0 +1,40 @@
+// ============================================================================
+// Author: LeonW
+// Date: October 14, 2026
+// Description: Synthetic assembly programs for sbasm_bench
+//              Each workload stresses one part of the pipeline. Programs are
+//              generated from a fixed seed, so a kind and size always give
+//              the same source and benchmark runs stay comparable.
+// ============================================================================
+
+#pragma once
+#include "common.h"
+#include <iterator>
+#include <string>
+#include <string_view>
+
+enum class WorkloadKind : uint8_t {
+    BRANCHES,       // Label-dense code, short and out-of-range branches
+    LABEL_LOADS,    // mv rX, =label and =define loads, mostly forward references
+    WORD_TABLES,    // .word tables of labels and numbers
+    ORG_GAPS        // Code blocks spread over the address space with .org
+};
+
+struct WorkloadDef {
+    WorkloadKind kind;
+    std::string_view name;
+    std::string_view description;
+};
+
+inline constexpr WorkloadDef WORKLOADS[] = {
+    {WorkloadKind::BRANCHES,    "branches",    "Label-dense branching, some branches relaxed"},
+    {WorkloadKind::LABEL_LOADS, "label-loads", "=label loads, mostly forward references"},
+    {WorkloadKind::WORD_TABLES, "word-tables", ".word tables of labels and numbers"},
+    {WorkloadKind::ORG_GAPS,    "org-gaps",    "Code blocks separated by large .org gaps"},
+};
+
+// Approximate program sizes in words
+inline constexpr size_t WORKLOAD_SIZES[] = {1024, 8192, 32768};
+
+// Source of a program of about 'words' words
+std::string generateWorkload(WorkloadKind kind, size_t words);
@@ -2,67 +2,134 @@
 // Author: LeonW
 // Date: February 3, 2025
 // Description: AST node definitions for FLEX & Bison parser
+//              Statements are compact tagged unions stored contiguously;
+//              text fields are views into the source buffer, the symbol
+//              interner or the AST arena - nodes own no heap memory.
 // ============================================================================
 
 #pragma once
 #include "common.h"
-#include <memory>
+#include "Arena.h"
+#include "StringInterner.h"
 #include <vector>
 #include <string>
+#include <string_view>
+#include <stdexcept>
 
-enum class StatementType {
+struct InstructionDef;
+
+constexpr uint8_t NO_REGISTER = 0xFF;
+
+// Numeric literal operand, converted by the scanner. 'valid' is false if
+// the operand is not a number or does not fit in 64 bits.
+struct NumberLiteral {
+    int64_t value;
+    bool valid;
+};
+
+constexpr NumberLiteral NO_NUMBER = {0, false};
+
+enum class StatementType : uint8_t {
     INSTRUCTION,
     DIRECTIVE,
     LABEL
 };
 
-class Statement {
-public:
+struct Instruction {
+    const InstructionDef* def;  // Resolved mnemonic
+    std::string_view operand1;
+    std::string_view operand2;  // Keeps its # or = prefix for immediates
+    SymbolId symbol1;           // Interned operand1 if it names a symbol, else NO_SYMBOL
+    SymbolId symbol2;           // Interned operand2 if it names a symbol, else NO_SYMBOL
+    uint8_t reg1;               // Register number of operand1, else NO_REGISTER
+    uint8_t reg2;               // Register number of operand2, else NO_REGISTER
+    NumberLiteral number2;      // operand2 if it is a number (#5, =0x1234, 7)
+    bool hasComma;
+    bool isLabelImmediate;
+    bool isImmediate;
+};
+
+// One value of a directive - a number or a symbol reference
+struct DataValue {
+    std::string_view text;
+    NumberLiteral number;
+    SymbolId symbol;        // NO_SYMBOL for numbers
+};
+
+struct Directive {
+    std::string_view name;
+    std::string_view label;     // .define NAME, .incbin file name
+    std::string_view value;     // .incbin: the file's bytes
+    SymbolId labelSymbol;       // Interned label (.define NAME)
+    SymbolId valueSymbol;       // Interned value if it names a symbol (.word LABEL)
+    NumberLiteral number;       // Value if it is a number (.word 5)
+    const DataValue* values;    // Comma separated values in the AST arena (.word 1, 2, 3)
+    uint32_t valueCount;        // 0: the only value is value/number/valueSymbol
+
+    size_t count() const { return valueCount == 0 ? 1 : valueCount; }
+
+    DataValue item(size_t i) const {
+        return valueCount == 0 ? DataValue{value, number, valueSymbol} : values[i];
+    }
+};
+
+struct Label {
+    std::string_view name;
+    SymbolId symbol;
+};
+
+struct Statement {
     StatementType type;
+    uint16_t file;      // Index into ProgramAST's file names, 0 = main source
     int line;
     int column;
+    union {
+        Instruction instruction;
+        Directive directive;
+        Label label;
+    };
 
-    Statement(StatementType t, int l, int c) : type(t), line(l), column(c) {}
-    virtual ~Statement() = default;
+    Statement(StatementType t, int l, int c, uint16_t f)
+        : type(t), file(f), line(l), column(c), instruction() {}
 };
 
-class Instruction : public Statement {
+class ProgramAST {
+private:
+    std::vector<Statement> statements;
+    std::vector<std::string> files;     // Source and .incbin names, [0] = main source
+
 public:
-    std::string opcode;
-    std::string operand1;
-    std::string operand2;
-    bool hasComma;
-    bool isLabelImmediate;
-    bool isImmediate;
+    Arena arena;    // Side storage for decoded string literals etc.
 
-    Instruction(const std::string& op, const std::string& op1, 
-                const std::string& op2, bool comma, bool labelImm, bool imm,
-                int l, int c)
-        : Statement(StatementType::INSTRUCTION, l, c), 
-          opcode(op), operand1(op1), operand2(op2), 
-          hasComma(comma), isLabelImmediate(labelImm), isImmediate(imm) {}
-};
+    ProgramAST() : files(1) {}
 
-class Directive : public Statement {
-public:
-    std::string name;
-    std::string label;
-    std::string value;
-
-    Directive(const std::string& n, const std::string& l, 
-              const std::string& v, int line, int col)
-        : Statement(StatementType::DIRECTIVE, line, col), 
-          name(n), label(l), value(v) {}
-};
+    Statement& add(StatementType type, int line, int column, uint16_t file = 0) {
+        statements.emplace_back(type, line, column, file);
+        return statements.back();
+    }
 
-class Label : public Statement {
-public:
-    std::string name;
+    // Copy of a statement loaded from the parse cache
+    void append(const Statement& stmt) { statements.push_back(stmt); }
 
-    Label(const std::string& n, int l, int c)
-        : Statement(StatementType::LABEL, l, c), name(n) {}
-};
+    // Register an included or .incbin file, returns its index for Statement::file
+    uint16_t addFile(std::string name) {
+        if (files.size() > UINT16_MAX) {
+            throw std::runtime_error("Too many source files");
+        }
+        files.push_back(std::move(name));
+        return static_cast<uint16_t>(files.size() - 1);
+    }
 
-using ProgramAST = std::vector<std::unique_ptr<Statement>>;
+    void setMainFile(std::string name) { files[0] = std::move(name); }
+    const std::string& fileName(uint16_t file) const { return files[file]; }
+    size_t fileCount() const { return files.size(); }
 
-extern ProgramAST* g_ast;
+    void reserve(size_t count) { statements.reserve(count); }
+    size_t size() const { return statements.size(); }
+    bool empty() const { return statements.empty(); }
+
+    const Statement& operator[](size_t index) const { return statements[index]; }
+
+    std::vector<Statement>::const_iterator begin() const { return statements.begin(); }
+    std::vector<Statement>::const_iterator end() const { return statements.end(); }
+};
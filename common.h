@@ -10,5 +10,25 @@
 #include <cstddef>
 #include <unordered_map>
 #include <string>
+#include <string_view>
 #include <cstring>
+#include <cstdio>
+
+// 'text' as a quoted JSON string
+inline std::string jsonString(std::string_view text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
 
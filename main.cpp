@@ -6,118 +6,260 @@
 // ============================================================================
 
 #include "common.h"
-#include "ast.h"
-#include "InstructionEncoder.h"
+#include "Assembler.h"
 #include "InstructionDef.h"
-#include "SymbolTable.h"
+#include "OutputWriter.h"
+#include "SourceFile.h"
+#include "Batch.h"
+#include "Watch.h"
+#include "Parallel.h"
+#include "Simulator.h"
+#include "Timing.h"
+#include "Stats.h"
+#include "ObjectFile.h"
+#include "Listing.h"
+#include "LineTable.h"
+#include "NumberParser.h"
+#include <chrono>
 #include <fstream>
-#include <sstream>
+#include <memory>
 #include <iomanip>
 
-extern FILE* yyin;
-extern int yyparse();
-extern ProgramAST* g_ast;
-
 // ============================================================================
-// MIF Writer - Uses disassembly from InstructionDef.h
+// Help and CLI
 // ============================================================================
 
-void writeMIF(const std::vector<uint16_t>& machineCode,
-              const std::vector<bool>& isData,
-              std::string& outputFile,
-              int depth = 256) 
-{
-    if (outputFile.size() < 4 || outputFile.substr(outputFile.size() - 4) != ".mif") {
-        outputFile += ".mif";
-    }
-
-    std::ofstream out(outputFile);
-    if (!out.is_open()) {
-        throw std::runtime_error("Could not open output file: " + outputFile);
-    }
-
-    // MIF header
-    out << "WIDTH = 16;\n";
-    out << "DEPTH = " << depth << ";\n";
-    out << "ADDRESS_RADIX = HEX;\n";
-    out << "DATA_RADIX = HEX;\n\n";
-    out << "CONTENT\n";
-    out << "BEGIN\n";
-
-    // Write each word with disassembly comment
-    for (size_t i = 0; i < machineCode.size(); i++) {
-        // Address column
-        out << std::hex << std::setw(3) << std::setfill(' ') << i;
-        out << "    ";
-        
-        // Data column
-        out << ": " << std::setw(4) << std::setfill('0') << machineCode[i] << ";";
-        out << "        ";
-        
-        // Comment with disassembly
-        out << "% ";
-        if (i < isData.size() && isData[i]) {
-            out << formatDataWord(machineCode[i]);
+void printHelp(const char* programName) {
+    std::cout << "Usage: " << programName << " input_file [options]\n"
+              << "       " << programName << " --batch input_file... [options]\n"
+              << "Assemble qCore assembly to MIF format\n\n"
+              << "Options:\n"
+              << "  -o <file>, --output <file>   Specify output file (default: a.<format>)\n"
+              << "                               With --batch: output directory\n"
+              << "  -f <fmt>, --format <fmt>     Output format (default: mif)\n"
+              << "  -c                           Write a relocatable object for sblink instead\n"
+              << "                               of a memory image (default: a.o)\n"
+              << "  -l <file>                    Write a listing: address, words, source line\n"
+              << "                               and disassembly of every statement\n"
+              << "  -m <file>                    Write a symbol map: labels by address, defines\n"
+              << "  -g                           Write a line table (<output>.dbg) mapping every\n"
+              << "                               address to its source file, line and column\n"
+              << "  --no-comments                Omit disassembly comments from the output\n"
+              << "  --depth <words|auto>         Memory depth (default: 256, grown to the next\n"
+              << "                               power of two if the program does not fit)\n"
+              << "  --no-compress                Write every word of the MIF on its own line\n"
+              << "  --no-relax                   Fail on out-of-range branches instead of\n"
+              << "                               rewriting them into long form\n"
+              << "  --no-shrink                  Always encode mv rX, =value as two words\n"
+              << "  -O                           Drop instructions without effect and report\n"
+              << "                               the words and cycles saved\n"
+              << "  --run                        Run the program in the simulator after assembly\n"
+              << "  --max-cycles <n>             Stop the simulation after n cycles\n"
+              << "                               (default: 100000000)\n"
+              << "  --switches <value>           Simulated switch input (default: 0)\n"
+              << "  --timing <file>              Write cycle counts per basic block and worst-case\n"
+              << "                               bounds per routine as JSON (- for stdout)\n"
+              << "  --batch                      Assemble every input, outputs are named after\n"
+              << "                               the inputs. @file reads inputs from a manifest\n"
+              << "  -j <n>, --jobs <n>           Worker threads (default: all cores)\n"
+              << "  --watch                      Reassemble whenever the input or an included\n"
+              << "                               file changes\n"
+              << "  -I <dir>                     Add a directory to the .include search path\n"
+              << "  --cache <dir>                Cache parsed include files in <dir>\n"
+              << "  --max-errors <n>             Report the first n assembly errors, 0 for no limit\n"
+              << "                               (default: 20)\n"
+              << "  --stats                      Print the time spent per phase and work counters\n"
+              << "  --stats=json                 Print them as JSON on stdout, other messages\n"
+              << "                               on stderr\n"
+              << "  -v, --verbose                Enable verbose output\n"
+              << "  --doc                        Generate instruction set documentation\n"
+              << "  -h, --help                   Display this help message\n\n"
+              << "Output formats:\n";
+    for (const auto& fmt : OUTPUT_FORMATS) {
+        std::cout << "  " << std::left << std::setw(29) << fmt.name << fmt.description << "\n";
+    }
+}
+
+// Numeric option value in [minimum, maximum] - same literals as the assembly
+// source: decimal, 0x hex or 0b binary
+bool parseOptionValue(const char* text, int64_t minimum, int64_t maximum, int64_t& value) {
+    return parseNumber(text, value) && value >= minimum && value <= maximum;
+}
+
+// Scanner and parser messages are printed as they are, assembly errors
+// with an "Error:" prefix and a count if there is more than one
+void printDiagnostics(const std::vector<Diagnostic>& diagnostics) {
+    size_t errors = 0;
+    for (const Diagnostic& diag : diagnostics) {
+        if (diag.kind == DiagnosticKind::ASSEMBLY) {
+            std::cerr << "\nError: " << diag.message << std::endl;
+            errors += diag.code != ErrorCode::TOO_MANY_ERRORS;
         } else {
-            out << disassembleInstruction(machineCode[i], i);
+            std::cerr << diag.message << std::endl;
         }
-        out << " %\n";
     }
-
-    // Fill remaining addresses with zeros
-    if (machineCode.size() < static_cast<size_t>(depth)) {
-        out << "[" << std::hex << machineCode.size() << ".." << (depth - 1) << "] : 0000;\n";
+    if (errors > 1) {
+        std::cerr << "\n" << errors << " errors" << std::endl;
     }
+}
 
-    out << "END;\n";
-    out.close();
+// Words and cycles saved by each -O rewrite
+void printPeepholeReport(const Assembler& assembler) {
+    const ProgramAST& ast = assembler.getAST();
+    int words = 0;
+    int cycles = 0;
+    for (const PeepholeRewrite& rewrite : assembler.getPeepholeRewrites()) {
+        const Statement& stmt = ast[rewrite.first];
+        std::cout << "Optimized line " << stmt.line;
+        if (stmt.file != 0) {
+            std::cout << " of " << ast.fileName(stmt.file);
+        }
+        std::cout << ": " << rewrite.rule << " removed, " << rewrite.words << " word(s), "
+                  << rewrite.cycles << " cycles saved\n";
+        words += rewrite.words;
+        cycles += rewrite.cycles;
+    }
+    std::cout << "Peephole: " << assembler.getPeepholeRewrites().size() << " rewrite(s), "
+              << words << " word(s) and " << cycles << " cycles saved\n";
 }
 
-// ============================================================================
-// Help and CLI
-// ============================================================================
+// Run the image in the simulator and print its final state and where it
+// stopped in the source. Returns the exit code: 0 if the program halted.
+int runSimulation(const MemoryImage& image, const LineTable& lines, uint16_t switches, uint64_t maxCycles) {
+    Simulator simulator(image);
+    simulator.setSwitches(switches);
+
+    const auto start = std::chrono::steady_clock::now();
+    const SimResult result = simulator.run(maxCycles);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "\n=== Simulation ===\n";
+    switch (result.reason) {
+        case StopReason::HALT:
+            std::cout << "Halted";
+            break;
+        case StopReason::CYCLE_LIMIT:
+            std::cout << "Cycle limit reached";
+            break;
+        case StopReason::FETCH_FAULT:
+            std::cout << "Fetch outside program memory at 0x" << std::hex << result.faultAddress << std::dec;
+            break;
+    }
+    // pc is past the halt, at the next instruction after a cycle limit
+    const uint32_t stopAddress = result.reason == StopReason::HALT ? static_cast<uint16_t>(result.registers[7] - 1)
+                                                                   : result.registers[7];
+    const LineEntry* location = result.reason == StopReason::FETCH_FAULT ? nullptr : lines.find(stopAddress);
+    if (location != nullptr) {
+        std::cout << " at line " << location->line;
+        if (location->file != 0) {
+            std::cout << " of " << lines.getFiles()[location->file];
+        }
+    }
+    std::cout << " after " << result.instructions << " instructions, " << result.cycles << " cycles";
+    if (result.interrupts > 0) {
+        std::cout << ", " << result.interrupts << " interrupt(s)";
+    }
+    if (seconds > 0) {
+        std::cout << " (" << std::fixed << std::setprecision(1) << result.cycles / seconds / 1e6
+                  << std::defaultfloat << " M cycles/s)";
+    }
+    std::cout << "\n" << std::hex << std::setfill('0');
+    for (int i = 0; i < 8; i++) {
+        std::cout << "  " << getRegisterName(static_cast<uint8_t>(i)) << " = 0x"
+                  << std::setw(4) << result.registers[i] << (i % 4 == 3 ? "\n" : "");
+    }
+    std::cout << "  Z=" << result.z << " N=" << result.n << " C=" << result.c << "\n"
+              << "  LEDs = 0x" << std::setw(4) << result.leds << "\n  HEX5..HEX0 =";
+    for (int digit = SIM_HEX_DIGITS - 1; digit >= 0; digit--) {
+        std::cout << " " << std::setw(2) << result.hex[digit];
+    }
+    std::cout << std::dec << std::setfill(' ') << "\n";
 
-void printHelp(const char* programName) {
-    std::cout << "Usage: " << programName << " input_file [options]\n"
-              << "Assemble qCore assembly to MIF format\n\n"
-              << "Options:\n"
-              << "  -o <file>, --output <file>   Specify output file (default: a.mif)\n"
-              << "  -v, --verbose                Enable verbose output\n"
-              << "  --doc                        Generate instruction set documentation\n"
-              << "  -h, --help                   Display this help message\n"; 
+    return result.reason == StopReason::HALT ? 0 : 1;
 }
 
-// ============================================================================
-// Utility functions
-// ============================================================================
+// Analyze the image and write the --timing report to 'path' ("-" for
+// stdout), then print the bound of every routine
+void writeTimingReport(const Assembler& assembler, const std::string& source, const std::string& path) {
+    const TimingReport report = analyzeTiming(assembler.getImage(), assembler.getAST(), assembler.getSymbolTable());
+    if (path == "-") {
+        writeTimingJson(report, source, std::cout);
+        return;
+    }
 
-int64_t parseNumber(const std::string& valStr) {
-    if (valStr.size() >= 2 && (valStr.substr(0, 2) == "0b" || valStr.substr(0, 2) == "0B")) {
-        return std::stoll(valStr.substr(2), nullptr, 2);
+    std::ofstream out(path);
+    if (!out) {
+        throw std::runtime_error("Could not open output file: " + path);
     }
-    else if (valStr.size() >= 2 && (valStr.substr(0, 2) == "0x" || valStr.substr(0, 2) == "0X")) {
-        return std::stoll(valStr.substr(2), nullptr, 16);
+    writeTimingJson(report, source, out);
+    out.close();
+    if (!out) {
+        throw std::runtime_error("Failed to write output file: " + path);
     }
-    else {
-        return std::stoll(valStr, nullptr, 0);
+
+    std::cout << "Timing report: " << path << "\n";
+    for (const TimingRoutine& routine : report.routines) {
+        std::cout << "  " << routine.name << ": ";
+        if (routine.bounded()) {
+            std::cout << routine.worstCaseCycles << " cycles worst case";
+        } else {
+            std::cout << "unbounded (" << routine.reason << ")";
+        }
+        std::cout << (routine.interrupt ? ", interrupt entry included\n" : "\n");
     }
 }
 
-// Calculate the size (in words) of a directive
-int getDirectiveSize(Directive* dir) {
-    if (dir->name == ".word") {
+// ============================================================================
+// Batch mode
+// ============================================================================
+
+int runBatchMode(const std::vector<std::string>& arguments, const std::string& outputDirectory,
+                 const OutputOptions& outputOptions, const AssemblerOptions& assemblerOptions,
+                 int requestedDepth, unsigned threads)
+{
+    // Expand @manifest arguments
+    std::vector<BatchJob> jobs;
+    try {
+        for (const std::string& arg : arguments) {
+            if (arg.size() > 1 && arg[0] == '@') {
+                for (const std::string& input : readBatchManifest(arg.substr(1))) {
+                    jobs.push_back({input, batchOutputName(input, outputDirectory)});
+                }
+            } else {
+                jobs.push_back({arg, batchOutputName(arg, outputDirectory)});
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
         return 1;
-    } 
-    else if (dir->name == ".space") {
-        return static_cast<int>(parseNumber(dir->value));
-    }
-    else if (dir->name == ".ascii") {
-        return static_cast<int>(dir->value.length());
     }
-    else if (dir->name == ".asciiz") {
-        return static_cast<int>(dir->value.length()) + 1;  // +1 for null terminator
+
+    const auto start = std::chrono::steady_clock::now();
+    const std::vector<BatchResult> results = runBatch(jobs, outputOptions, assemblerOptions, requestedDepth, threads);
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    // Report failures in input order
+    size_t failed = 0;
+    uint64_t totalWords = 0;
+    for (size_t i = 0; i < results.size(); i++) {
+        const BatchResult& result = results[i];
+        if (result.success) {
+            totalWords += result.words;
+            continue;
+        }
+        failed++;
+        for (const Diagnostic& diag : result.diagnostics) {
+            std::cerr << jobs[i].input << ": " << diag.message << "\n";
+        }
     }
-    return 0;
+
+    const unsigned workers = resolveThreadCount(threads, jobs.size());
+    std::cout << "Batch: " << (results.size() - failed) << " of " << results.size()
+              << " inputs assembled, " << failed << " failed (" << totalWords << " words, "
+              << workers << (workers == 1 ? " worker, " : " workers, ")
+              << elapsed.count() << " ms)\n";
+    return failed == 0 ? 0 : 1;
 }
 
 // ============================================================================
@@ -125,9 +267,24 @@ int getDirectiveSize(Directive* dir) {
 // ============================================================================
 
 int main(int argc, const char* argv[]) {
-    std::string outputFile = "a.mif";
+    std::string outputFile;
+    OutputOptions outputOptions;
+    AssemblerOptions assemblerOptions;
+    int requestedDepth = DEPTH_DEFAULT;
     bool verbose = false;
-    std::string inputFile;
+    bool batch = false;
+    bool watch = false;
+    bool run = false;
+    std::string timingFile;
+    std::string listingFile;
+    std::string mapFile;
+    bool lineTable = false;
+    bool stats = false;
+    bool statsJson = false;
+    uint64_t maxCycles = SIM_DEFAULT_MAX_CYCLES;
+    uint16_t switches = 0;
+    unsigned threads = 0;
+    std::vector<std::string> inputs;
 
     // Handle --doc and --help before input file check
     for (int i = 1; i < argc; ++i) {
@@ -142,16 +299,8 @@ int main(int argc, const char* argv[]) {
         }
     }
 
-    if (argc < 2) {
-        std::cerr << "Error: No input file specified.\n"
-                  << "Usage: " << argv[0] << " input_file [options]\n"
-                  << "Use -h for help" << std::endl;
-        return 1;
-    }
-    inputFile = argv[1];
-
-    // Parse remaining arguments
-    for (int i = 2; i < argc; ) {
+    // Parse arguments - anything that is not an option is an input file
+    for (int i = 1; i < argc; ) {
         std::string arg = argv[i];
         if (arg == "-o" || arg == "--output") {
             if (i + 1 >= argc) {
@@ -160,72 +309,306 @@ int main(int argc, const char* argv[]) {
             }
             outputFile = argv[i + 1];
             i += 2;
+        } else if (arg == "-f" || arg == "--format") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: -f requires an output format" << std::endl;
+                return 1;
+            }
+            const OutputFormatDef* fmt = getOutputFormatDef(argv[i + 1]);
+            if (fmt == nullptr) {
+                std::cerr << "Error: Unknown output format '" << argv[i + 1] << "'\n"
+                          << "Use -h for help" << std::endl;
+                return 1;
+            }
+            outputOptions.format = fmt->format;
+            i += 2;
+        } else if (arg == "-c") {
+            assemblerOptions.objectOutput = true;
+            i += 1;
+        } else if (arg == "-g") {
+            lineTable = true;
+            i += 1;
+        } else if (arg == "-l" || arg == "-m") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " requires an output filename" << std::endl;
+                return 1;
+            }
+            (arg == "-l" ? listingFile : mapFile) = argv[i + 1];
+            i += 2;
+        } else if (arg == "--no-comments") {
+            outputOptions.comments = false;
+            i += 1;
+        } else if (arg == "--no-compress") {
+            outputOptions.compress = false;
+            i += 1;
+        } else if (arg == "--depth") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --depth requires a word count or 'auto'" << std::endl;
+                return 1;
+            }
+            std::string value = argv[i + 1];
+            if (value == "auto") {
+                requestedDepth = DEPTH_AUTO;
+            } else {
+                int64_t depth = 0;
+                if (!parseOptionValue(value.c_str(), 1, MAX_MEMORY_DEPTH, depth)) {
+                    std::cerr << "Error: Invalid memory depth '" << value << "'" << std::endl;
+                    return 1;
+                }
+                requestedDepth = static_cast<int>(depth);
+            }
+            i += 2;
+        } else if (arg == "--batch") {
+            batch = true;
+            i += 1;
+        } else if (arg == "--run") {
+            run = true;
+            i += 1;
+        } else if (arg == "--timing") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --timing requires an output filename" << std::endl;
+                return 1;
+            }
+            timingFile = argv[i + 1];
+            i += 2;
+        } else if (arg == "--max-cycles") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --max-cycles requires a cycle count" << std::endl;
+                return 1;
+            }
+            int64_t count = 0;
+            if (!parseOptionValue(argv[i + 1], 1, INT64_MAX, count)) {
+                std::cerr << "Error: Invalid cycle count '" << argv[i + 1] << "'" << std::endl;
+                return 1;
+            }
+            maxCycles = static_cast<uint64_t>(count);
+            i += 2;
+        } else if (arg == "--switches") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --switches requires a value" << std::endl;
+                return 1;
+            }
+            int64_t value = 0;
+            if (!parseOptionValue(argv[i + 1], 0, 0xFFFF, value)) {
+                std::cerr << "Error: Invalid switch value '" << argv[i + 1] << "'" << std::endl;
+                return 1;
+            }
+            switches = static_cast<uint16_t>(value);
+            i += 2;
+        } else if (arg == "--no-relax") {
+            assemblerOptions.branchRelaxation = false;
+            i += 1;
+        } else if (arg == "--no-shrink") {
+            assemblerOptions.loadShrinking = false;
+            i += 1;
+        } else if (arg == "-O") {
+            assemblerOptions.peephole = true;
+            i += 1;
+        } else if (arg == "--watch") {
+            watch = true;
+            i += 1;
+        } else if (arg == "-j" || arg == "--jobs") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: -j requires a thread count" << std::endl;
+                return 1;
+            }
+            int64_t count = 0;
+            if (!parseOptionValue(argv[i + 1], 1, 1024, count)) {
+                std::cerr << "Error: Invalid thread count '" << argv[i + 1] << "'" << std::endl;
+                return 1;
+            }
+            threads = static_cast<unsigned>(count);
+            i += 2;
+        } else if (arg == "-I") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: -I requires a directory" << std::endl;
+                return 1;
+            }
+            assemblerOptions.includes.searchPaths.push_back(argv[i + 1]);
+            i += 2;
+        } else if (arg.size() > 2 && arg.compare(0, 2, "-I") == 0) {
+            assemblerOptions.includes.searchPaths.push_back(arg.substr(2));
+            i += 1;
+        } else if (arg == "--cache") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --cache requires a directory" << std::endl;
+                return 1;
+            }
+            assemblerOptions.includes.cacheDirectory = argv[i + 1];
+            i += 2;
+        } else if (arg == "--max-errors") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --max-errors requires a count" << std::endl;
+                return 1;
+            }
+            int64_t count = 0;
+            if (!parseOptionValue(argv[i + 1], 0, INT64_MAX, count)) {
+                std::cerr << "Error: Invalid error count '" << argv[i + 1] << "'" << std::endl;
+                return 1;
+            }
+            assemblerOptions.maxErrors = static_cast<size_t>(count);
+            i += 2;
+        } else if (arg == "--stats" || arg == "--stats=json") {
+            stats = true;
+            statsJson = arg == "--stats=json";
+            i += 1;
         } else if (arg == "-v" || arg == "--verbose") {
             verbose = true;
             i += 1;
-        } else {
+        } else if (arg.size() > 1 && arg[0] == '-') {
             std::cerr << "Error: Unexpected argument '" << arg << "'\n"
                       << "Use -h for help" << std::endl;
             return 1;
+        } else {
+            inputs.push_back(arg);
+            i += 1;
         }
     }
 
-    // Open input file
-    yyin = fopen(inputFile.c_str(), "r");
-    if (yyin == nullptr) {
-        std::cerr << "Error: Could not open file '" << inputFile << "'" << std::endl;
+    if (inputs.empty()) {
+        std::cerr << "Error: No input file specified.\n"
+                  << "Usage: " << argv[0] << " input_file [options]\n"
+                  << "Use -h for help" << std::endl;
         return 1;
     }
 
-    int memoryDepth = 256;
+    if (run && (batch || watch)) {
+        std::cerr << "Error: --run cannot be used with " << (batch ? "--batch" : "--watch") << std::endl;
+        return 1;
+    }
 
-    try {
+    if (!timingFile.empty() && (batch || watch)) {
+        std::cerr << "Error: --timing cannot be used with " << (batch ? "--batch" : "--watch") << std::endl;
+        return 1;
+    }
+
+    if ((!listingFile.empty() || !mapFile.empty()) && (batch || watch)) {
+        std::cerr << "Error: " << (!listingFile.empty() ? "-l" : "-m") << " cannot be used with "
+                  << (batch ? "--batch" : "--watch") << std::endl;
+        return 1;
+    }
+    assemblerOptions.listing = !listingFile.empty();
+
+    if (stats && (batch || watch)) {
+        std::cerr << "Error: --stats cannot be used with " << (batch ? "--batch" : "--watch") << std::endl;
+        return 1;
+    }
+
+    if (statsJson && timingFile == "-") {
+        std::cerr << "Error: --stats=json cannot be used with --timing -" << std::endl;
+        return 1;
+    }
+
+    // --stats=json keeps stdout for the JSON object, so it can be piped;
+    // every other message goes to stderr
+    std::ostream statsOut(std::cout.rdbuf());
+    if (statsJson) {
+        std::cout.rdbuf(std::cerr.rdbuf());
+    }
+
+    if (assemblerOptions.objectOutput && (run || !timingFile.empty() || watch || lineTable)) {
+        std::cerr << "Error: -c cannot be used with "
+                  << (run ? "--run" : watch ? "--watch" : lineTable ? "-g" : "--timing") << std::endl;
+        return 1;
+    }
+
+    if (lineTable && watch) {
+        std::cerr << "Error: -g cannot be used with --watch" << std::endl;
+        return 1;
+    }
+    assemblerOptions.lineTable = lineTable || run;     // --run reports where the program stopped
+
+    if (batch && watch) {
+        std::cerr << "Error: --watch cannot be used with --batch" << std::endl;
+        return 1;
+    }
+
+    if (batch) {
         if (verbose) {
-            std::cout << "\n=== Lexical Analysis & Parsing ===\n";
+            std::cerr << "Error: -v cannot be used with --batch" << std::endl;
+            return 1;
         }
+        return runBatchMode(inputs, outputFile, outputOptions, assemblerOptions, requestedDepth, threads);
+    }
 
-        // Parse using Bison
-        int parse_result = yyparse();
-        fclose(yyin);
+    if (inputs.size() > 1) {
+        std::cerr << "Error: Unexpected argument '" << inputs[1] << "'\n"
+                  << "Use --batch to assemble several files" << std::endl;
+        return 1;
+    }
+    const std::string& inputFile = inputs[0];
+    assemblerOptions.encodeThreads = threads;
 
-        if (parse_result != 0) {
-            std::cerr << "Parse failed" << std::endl;
+    if (outputFile.empty()) {
+        outputFile = "a";   // Extension is added by the output writer
+    }
+
+    if (watch) {
+        if (verbose) {
+            std::cerr << "Error: -v cannot be used with --watch" << std::endl;
             return 1;
         }
+        return runWatch({inputFile, outputFile, outputOptions, assemblerOptions, requestedDepth});
+    }
+
+    // Map the input file - the AST keeps views into this buffer, so it must
+    // stay alive until assembly is complete
+    std::unique_ptr<SourceFile> source;
+    try {
+        source = std::make_unique<SourceFile>(inputFile);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    try {
+        if (verbose) {
+            std::cout << "\n=== Lexical Analysis & Parsing ===\n";
+        }
 
-        if (g_ast == nullptr) {
-            std::cerr << "Error: No AST generated" << std::endl;
+        // Parse using Bison - statements are appended to the AST in place
+        Assembler assembler;
+        assembler.setOptions(assemblerOptions);
+        assembler.setSourceName(inputFile);
+        if (!assembler.parse(source->data(), source->bufferSize())) {
+            printDiagnostics(assembler.getDiagnostics());
+            std::cerr << "Parse failed" << std::endl;
             return 1;
         }
+        const ProgramAST& ast = assembler.getAST();
 
-        auto& ast = *g_ast;
+        const IncludeResolver& includes = assembler.getIncludes();
+        if (verbose && includes.getCachedFiles() + includes.getParsedFiles() > 0) {
+            std::cout << "Included files: " << includes.getParsedFiles() << " parsed, "
+                      << includes.getCachedFiles() << " loaded from cache\n";
+        }
 
         // Print AST if verbose
         if (verbose) {
             std::cout << "Abstract Syntax Tree:\n";
-            for (const auto& stmt : ast) {
-                std::cout << "  Line " << stmt->line << ": ";
-                switch (stmt->type) {
+            for (const Statement& stmt : ast) {
+                std::cout << "  Line " << stmt.line << ": ";
+                switch (stmt.type) {
                     case StatementType::LABEL: {
-                        auto label = static_cast<Label*>(stmt.get());
-                        std::cout << "LABEL \"" << label->name << "\"\n";
+                        const Label& label = stmt.label;
+                        std::cout << "LABEL \"" << label.name << "\"\n";
                         break;
                     }
                     case StatementType::DIRECTIVE: {
-                        auto dir = static_cast<Directive*>(stmt.get());
-                        std::cout << "DIRECTIVE " << dir->name;
-                        if (!dir->label.empty()) std::cout << " " << dir->label;
-                        if (!dir->value.empty()) std::cout << " \"" << dir->value << "\"";
+                        const Directive& dir = stmt.directive;
+                        std::cout << "DIRECTIVE " << dir.name;
+                        if (!dir.label.empty()) std::cout << " " << dir.label;
+                        if (!dir.value.empty()) std::cout << " \"" << dir.value << "\"";
                         std::cout << "\n";
                         break;
                     }
                     case StatementType::INSTRUCTION: {
-                        auto instr = static_cast<Instruction*>(stmt.get());
-                        std::cout << "INSTR " << instr->opcode;
-                        if (!instr->operand1.empty()) std::cout << " " << instr->operand1;
-                        if (!instr->operand2.empty()) std::cout << ", " << instr->operand2;
-                        if (instr->isLabelImmediate) std::cout << " [label_imm]";
-                        if (instr->isImmediate) std::cout << " [imm]";
+                        const Instruction& instr = stmt.instruction;
+                        std::cout << "INSTR " << instr.def->mnemonic;
+                        if (!instr.operand1.empty()) std::cout << " " << instr.operand1;
+                        if (!instr.operand2.empty()) std::cout << ", " << instr.operand2;
+                        if (instr.isLabelImmediate) std::cout << " [label_imm]";
+                        if (instr.isImmediate) std::cout << " [imm]";
                         std::cout << "\n";
                         break;
                     }
@@ -234,127 +617,133 @@ int main(int argc, const char* argv[]) {
         }
 
         // ====================================================================
-        // First Pass: Symbol Collection
+        // Assembly: one pass over the AST, forward references are patched
+        // by the encoder once all labels are known
         // ====================================================================
-        
-        SymbolTable symbolTable;
-        int currentAddress = 0;
-        std::vector<bool> isData;
 
         if (verbose) {
-            std::cout << "\n=== First Pass: Symbol Collection ===\n";
+            std::cout << "\n=== Code Generation ===\n";
         }
 
-        for (const auto& stmt : ast) {
-            switch (stmt->type) {
-                case StatementType::LABEL: {
-                    auto label = static_cast<Label*>(stmt.get());
-                    if (verbose) {
-                        std::cout << "  Label: " << label->name << " = 0x" 
-                                  << std::hex << currentAddress << std::dec << "\n";
-                    }
-                    symbolTable.addLabel(label->name, currentAddress);
-                    break;
-                }
-                case StatementType::DIRECTIVE: {
-                    auto dir = static_cast<Directive*>(stmt.get());
-                    
-                    if (dir->name == ".define") {
-                        int64_t value = parseNumber(dir->value);
-                        if (verbose) {
-                            std::cout << "  Define: " << dir->label << " = 0x" 
-                                      << std::hex << value << std::dec << "\n";
-                        }
-                        symbolTable.addDefine(dir->label, value);
-                    } 
-                    else if (dir->name == ".org") {
-                        int64_t targetAddr = parseNumber(dir->value);
-                        if (targetAddr < currentAddress) {
-                            throw std::runtime_error("Error at line " + std::to_string(dir->line) + 
-                                                    ": .org address is less than current address");
-                        }
-                        if (verbose) {
-                            std::cout << "  .org: 0x" << std::hex << currentAddress 
-                                      << " -> 0x" << targetAddr << std::dec << "\n";
-                        }
-                        // Mark padding as data
-                        while (currentAddress < targetAddr) {
-                            isData.push_back(true);
-                            currentAddress++;
-                        }
-                    }
-                    else {
-                        // .word, .space, .ascii, .asciiz
-                        int size = getDirectiveSize(dir);
-                        if (verbose) {
-                            std::cout << "  " << dir->name << " at 0x" << std::hex 
-                                      << currentAddress << " (size=" << std::dec << size << ")\n";
-                        }
-                        for (int i = 0; i < size; i++) {
-                            isData.push_back(true);
-                        }
-                        currentAddress += size;
-                    }
-                    break;
-                }
-                case StatementType::INSTRUCTION: {
-                    auto instr = static_cast<Instruction*>(stmt.get());
-                    int numWords = 1;
-                    
-                    // Check for expanded instructions (=label generates 2 words)
-                    if (instr->isLabelImmediate) {
-                        const InstructionDef* def = getInstructionDef(instr->opcode);
-                        if (def && def->canExpand) {
-                            numWords = 2;
-                        }
-                    }
+        if (!assembler.encode()) {
+            printDiagnostics(assembler.getDiagnostics());
+            return 1;
+        }
+        const MemoryImage& image = assembler.getImage();
 
-                    if (verbose) {
-                        std::cout << "  " << instr->opcode << " at 0x" << std::hex 
-                                  << currentAddress << " (size=" << std::dec << numWords << ")\n";
-                    }
+        if (assemblerOptions.peephole) {
+            printPeepholeReport(assembler);
+        }
 
-                    for (int i = 0; i < numWords; i++) {
-                        isData.push_back(false);
-                    }
-                    currentAddress += numWords;
-                    break;
+        if (assembler.getRelaxedBranchCount() > 0) {
+            std::cout << "Note: " << assembler.getRelaxedBranchCount()
+                      << (assemblerOptions.objectOutput ? " branch(es) in long form (out of range or to another object)\n"
+                                                        : " branch(es) out of range, rewritten into long form\n");
+        }
+
+        if (verbose && assembler.getShortLoadCount() > 0) {
+            std::cout << "Encoded " << assembler.getShortLoadCount() << " =value load(s) in one word\n";
+        }
+
+        if (verbose) {
+            const SymbolTable& symbolTable = assembler.getSymbolTable();
+            std::cout << "Symbols:\n";
+            for (SymbolId id = 0; id < static_cast<SymbolId>(assembler.getSymbols().size()); id++) {
+                const Symbol sym = symbolTable.lookup(id);
+                if (sym.kind != SymbolKind::UNDEFINED) {
+                    std::cout << "  " << (sym.kind == SymbolKind::LABEL ? "Label: " : "Define: ")
+                              << symbolTable.getName(id) << " = 0x"
+                              << std::hex << sym.value << std::dec << "\n";
                 }
             }
+
+            std::cout << "\nGenerated " << image.size() << " words:\n";
+            image.forEachWord([](uint32_t address, uint16_t word, bool data) {
+                std::cout << "  " << std::hex << std::setw(3) << std::setfill('0') << address 
+                          << ": " << std::setw(4) << std::setfill('0') << word;
+                if (!data) {
+                    std::cout << "  ; " << disassembleInstruction(word, address);
+                }
+                std::cout << std::dec << "\n";
+            });
+        }
+
+        if (!listingFile.empty()) {
+            OutputBuffer listing;
+            formatListing(assembler.getAST(), assembler.getStatementAddresses(), image, listing);
+            listing.writeToFile(listingFile);
+            std::cout << "Listing: " << listingFile << "\n";
+        }
+        if (!mapFile.empty()) {
+            OutputBuffer map;
+            formatSymbolMap(assembler.getSymbolTable(), assembler.getSymbols().size(), inputFile, map);
+            map.writeToFile(mapFile);
+            std::cout << "Symbol map: " << mapFile << "\n";
         }
 
         // ====================================================================
-        // Second Pass: Code Generation
+        // Write Output
         // ====================================================================
 
-        if (verbose) {
-            std::cout << "\n=== Second Pass: Code Generation ===\n";
+        if (assemblerOptions.objectOutput) {
+            AssemblyStats assemblyStats = assembler.getStats();
+            const ObjectModule object = assembler.getObject();
+            {
+                ScopedTimer timer(assemblyStats.phase(StatsPhase::OUTPUT));
+                writeObjectFile(object, outputFile);
+            }
+            std::cout << "\nAssembly completed. Object: " << outputFile << " (" << image.size() << " words, "
+                      << object.relocations.size() << " relocation(s)"
+                      << (object.absolute ? ", absolute)\n" : ")\n");
+            if (statsJson) {
+                writeStatsJson(assemblyStats, inputFile, statsOut);
+            } else if (stats) {
+                writeStatsText(assemblyStats, std::cout);
+            }
+            return 0;
         }
 
-        Encoder encoder(symbolTable);
-        std::vector<uint16_t> machineCode = encoder.encode(ast);
+        outputOptions.depth = resolveMemoryDepth(image.size(), requestedDepth);
+        if (requestedDepth == DEPTH_DEFAULT && outputOptions.depth != DEFAULT_MEMORY_DEPTH) {
+            std::cout << "Note: program does not fit in " << DEFAULT_MEMORY_DEPTH 
+                      << " words, using DEPTH = " << outputOptions.depth << "\n";
+        }
 
-        if (verbose) {
-            std::cout << "\nGenerated " << machineCode.size() << " words:\n";
-            for (size_t i = 0; i < machineCode.size(); i++) {
-                std::cout << "  " << std::hex << std::setw(3) << std::setfill('0') << i 
-                          << ": " << std::setw(4) << std::setfill('0') << machineCode[i];
-                if (i < isData.size() && !isData[i]) {
-                    std::cout << "  ; " << disassembleInstruction(machineCode[i], i);
+        AssemblyStats assemblyStats = assembler.getStats();
+        const LineTable lines = assemblerOptions.lineTable ? assembler.getLineTable() : LineTable();
+        {
+            ScopedTimer timer(assemblyStats.phase(StatsPhase::OUTPUT));
+            if (lineTable) {
+                // Named after the output without its format extension
+                std::string lineFile = outputFile;
+                const std::string_view extension = getOutputFormatDef(outputOptions.format)->extension;
+                if (lineFile.size() > extension.size() &&
+                    std::string_view(lineFile).substr(lineFile.size() - extension.size()) == extension) {
+                    lineFile.resize(lineFile.size() - extension.size());
                 }
-                std::cout << std::dec << "\n";
+                writeLineTableFile(lines, lineFile);
+                std::cout << "Line table: " << lineFile << " (" << lines.size() << " entries)\n";
             }
+            writeOutputFile(image, outputFile, outputOptions);
         }
+        std::cout << "\nAssembly completed. Output: " << outputFile 
+                  << " (" << image.size() << " words)\n";
 
-        // ====================================================================
-        // Write Output
-        // ====================================================================
+        if (!timingFile.empty()) {
+            writeTimingReport(assembler, inputFile, timingFile);
+        }
 
-        writeMIF(machineCode, isData, outputFile, memoryDepth);
-        std::cout << "\nAssembly completed. Output: " << outputFile 
-                  << " (" << machineCode.size() << " words)\n";
+        int exitCode = 0;
+        if (run) {
+            exitCode = runSimulation(image, lines, switches, maxCycles);
+        }
 
-        delete g_ast;
+        if (statsJson) {
+            writeStatsJson(assemblyStats, inputFile, statsOut);
+        } else if (stats) {
+            writeStatsText(assemblyStats, std::cout);
+        }
+        return exitCode;
 
     } catch (const std::exception& e) {
         std::cerr << "\nError: " << e.what() << std::endl;
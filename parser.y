@@ -4,21 +4,54 @@
 // Date: December 10, 2025
 // Description: Bison parser specification for the qCore assembler
 //              Clean operand handling with proper type tracking
+//              Pure (reentrant) parser - statements are appended in place
+//              to the AST of the ParseContext passed to yyparse()
+//              Tokens come from a MacroExpander, which expands .macro and
+//              .rept blocks; every statement takes the location of its
+//              first token
 // ============================================================================
 
 #include "common.h"
 #include "ast.h"
-#include <memory>
-#include <vector>
+#include "InstructionDef.h"
+#include <algorithm>
 #include <string>
 #include <iostream>
 
-extern int yylex();
-extern void yyerror(const char*);
-extern int line_num;
-extern int col_num;
+// A rule is located at its first token, an empty rule at the token before it
+#define YYLLOC_DEFAULT(Current, Rhs, N) \
+    do { (Current) = (N) ? YYRHSLOC(Rhs, 1) : YYRHSLOC(Rhs, 0); } while (0)
+%}
+
+%code requires {
+#include "ast.h"
+#include "ParseContext.h"
+
+class MacroExpander;
+
+// Token text - a view into the source buffer, never copied
+struct TokenText {
+    const char* data;
+    int length;
+};
 
-ProgramAST* g_ast = nullptr;
+// Identifier-like token: source text plus its interned symbol
+struct SymbolToken {
+    TokenText text;
+    SymbolId sym;
+};
+
+// Number token: source text plus the value converted by the lexer
+struct NumberToken {
+    TokenText text;
+    NumberLiteral value;
+};
+
+// Register token: source text plus the register number resolved by the lexer
+struct RegisterToken {
+    TokenText text;
+    uint8_t number;
+};
 
 // Operand type enum for clean tracking
 enum class OperandType {
@@ -31,68 +64,215 @@ enum class OperandType {
 };
 
 struct Operand {
-    std::string value;
     OperandType type;
-    
-    Operand() : type(OperandType::NONE) {}
-    Operand(const std::string& v, OperandType t) : value(v), type(t) {}
+    TokenText text;
+    SymbolId symbol;
+    uint8_t reg;
+    NumberLiteral number;
 };
+}
+
+%code provides {
+// Implemented by the selected scanner (lexer.l or FastScanner.cpp)
+int scanner_next(YYSTYPE* lval, void* scanner);
+
+// Implemented by MacroExpander.cpp - the parser's token source
+int yylex(YYSTYPE* lval, SourceLocation* lloc, MacroExpander& tokens);
+}
+
+%code {
+void yyerror(SourceLocation* lloc, MacroExpander& tokens, ParseContext& ctx, const char* msg);
+
+static std::string_view view(const TokenText& text) {
+    return std::string_view(text.data, text.length);
+}
+
+static Operand make_operand(OperandType type, const TokenText& text,
+                            SymbolId sym = NO_SYMBOL, uint8_t reg = NO_REGISTER) {
+    Operand op;
+    op.type = type;
+    op.text = text;
+    op.symbol = sym;
+    op.reg = reg;
+    op.number = NO_NUMBER;
+    return op;
+}
+
+static Operand number_operand(OperandType type, const NumberToken& token) {
+    Operand op = make_operand(type, token.text);
+    op.number = token.value;
+    return op;
+}
+
+static Operand no_operand() {
+    return make_operand(OperandType::NONE, TokenText{nullptr, 0});
+}
+
+static Operand register_operand(const RegisterToken& token) {
+    return make_operand(OperandType::REG, token.text, NO_SYMBOL, token.number);
+}
+
+// Decode escape sequences of a quoted string literal into the AST arena
+static std::string_view decode_string(ProgramAST& ast, const TokenText& text) {
+    char* output = ast.arena.allocateArray<char>(text.length);
+    char* out = output;
+    const char* in = text.data + 1;               // Skip opening quote
+    const char* end = text.data + text.length - 1; // Stop at closing quote
+
+    while (in < end) {
+        if (*in == '\\' && in + 1 < end) {
+            in++;
+            switch (*in) {
+                case 'n':  *out++ = '\n'; break;
+                case 'r':  *out++ = '\r'; break;
+                case 't':  *out++ = '\t'; break;
+                case '\\': *out++ = '\\'; break;
+                case '"':  *out++ = '"';  break;
+                case '0':  *out++ = '\0'; break;
+                default:   *out++ = *in;  break;
+            }
+        } else {
+            *out++ = *in;
+        }
+        in++;
+    }
+    return std::string_view(output, out - output);
+}
 
-static std::unique_ptr<Instruction> make_instruction(
-    const std::string& opcode, 
-    const Operand& op1, 
+static void add_instruction(
+    ParseContext& ctx,
+    const InstructionDef* def,
+    const Operand& op1,
     const Operand& op2,
-    int line, int col) 
+    int line, int col)
 {
-    bool isLabelImm = (op2.type == OperandType::LABEL_IMM);
-    bool isImm = (op2.type == OperandType::IMM || 
-                  op2.type == OperandType::LABEL_IMM || 
-                  op2.type == OperandType::NUMBER);
-    bool hasComma = (op2.type != OperandType::NONE);
-    
-    return std::make_unique<Instruction>(
-        opcode, op1.value, op2.value, 
-        hasComma, isLabelImm, isImm, 
-        line, col
-    );
+    Instruction& instr = ctx.ast.add(StatementType::INSTRUCTION, line, col, ctx.file).instruction;
+    instr.def = def;
+    instr.operand1 = view(op1.text);
+    instr.operand2 = view(op2.text);
+    instr.symbol1 = op1.symbol;
+    instr.symbol2 = op2.symbol;
+    instr.reg1 = op1.reg;
+    instr.reg2 = op2.reg;
+    instr.number2 = op2.number;
+    instr.isLabelImmediate = (op2.type == OperandType::LABEL_IMM);
+    instr.isImmediate = (op2.type == OperandType::IMM ||
+                         op2.type == OperandType::LABEL_IMM ||
+                         op2.type == OperandType::NUMBER);
+    instr.hasComma = (op2.type != OperandType::NONE);
 }
 
-static std::unique_ptr<Directive> make_directive(
-    const std::string& name, 
-    const std::string& label, 
-    const std::string& value,
-    int line, int col) 
+static void add_directive(
+    ParseContext& ctx,
+    const TokenText& name,
+    std::string_view label,
+    std::string_view value,
+    SymbolId labelSym, SymbolId valueSym,
+    NumberLiteral number,
+    int line, int col)
 {
-    return std::make_unique<Directive>(name, label, value, line, col);
+    Directive& dir = ctx.ast.add(StatementType::DIRECTIVE, line, col, ctx.file).directive;
+    dir.name = view(name);
+    dir.label = label;
+    dir.value = value;
+    dir.labelSymbol = labelSym;
+    dir.valueSymbol = valueSym;
+    dir.number = number;
+    dir.values = nullptr;
+    dir.valueCount = 0;
 }
 
-static std::unique_ptr<Label> make_label(const std::string& name, int line, int col) {
-    return std::make_unique<Label>(name, line, col);
+static void report_operands(ParseContext& ctx, const SourceLocation& at, const std::string& message) {
+    ctx.report(DiagnosticKind::PARSE, "Parse error at line " + std::to_string(at.line) +
+                                      ", column " + std::to_string(at.column) + ": " + message, at);
 }
 
-%}
+// .include and .incbin only take a quoted file name, .fill a count and a value
+static void reject_include(ParseContext& ctx, const SourceLocation& at, const TokenText& name) {
+    if (view(name) == ".include") {
+        ctx.report(DiagnosticKind::PARSE, "Include error at line " + std::to_string(at.line) +
+                                          ": .include expects a quoted file name", at);
+    } else if (view(name) == ".incbin") {
+        report_operands(ctx, at, ".incbin expects a quoted file name");
+    } else if (view(name) == ".fill") {
+        report_operands(ctx, at, ".fill expects a count and a value");
+    }
+}
+
+// .global only takes symbol names
+static void reject_global(ParseContext& ctx, const SourceLocation& at, const TokenText& name) {
+    if (view(name) == ".global") {
+        report_operands(ctx, at, ".global expects symbol names");
+    }
+}
+
+// Add a value to the list in ctx.values
+static void push_value(ParseContext& ctx, const Operand& op) {
+    ctx.values.push_back({view(op.text), op.number, op.symbol});
+}
+
+// .word a, b, ..., .global a, b, ... or .fill count, value - one
+// statement, the values are copied from ctx.values into the AST arena
+static void add_value_list(ParseContext& ctx, const TokenText& name, const SourceLocation& at) {
+    const std::string_view directive = view(name);
+    if (directive == ".fill" && ctx.values.size() != 2) {
+        report_operands(ctx, at, ".fill expects a count and a value");
+    } else if (directive != ".word" && directive != ".fill" && directive != ".global") {
+        report_operands(ctx, at, std::string(directive) + " takes a single value");
+    } else if (directive == ".global" &&
+               std::any_of(ctx.values.begin(), ctx.values.end(),
+                           [](const DataValue& value) { return value.symbol == NO_SYMBOL; })) {
+        reject_global(ctx, at, name);
+    }
+
+    DataValue* values = ctx.ast.arena.allocateArray<DataValue>(ctx.values.size());
+    std::copy(ctx.values.begin(), ctx.values.end(), values);
+    Directive& dir = ctx.ast.add(StatementType::DIRECTIVE, at.line, at.column, ctx.file).directive;
+    dir.name = directive;
+    dir.label = std::string_view();
+    dir.value = std::string_view();
+    dir.labelSymbol = NO_SYMBOL;
+    dir.valueSymbol = NO_SYMBOL;
+    dir.number = NO_NUMBER;
+    dir.values = values;
+    dir.valueCount = static_cast<uint32_t>(ctx.values.size());
+    ctx.values.clear();
+}
+
+static void add_label(ParseContext& ctx, const SymbolToken& token, int line, int col) {
+    Label& label = ctx.ast.add(StatementType::LABEL, line, col, ctx.file).label;
+    label.name = view(token.text);
+    label.symbol = token.sym;
+}
+}
+
+%define api.pure full
+%define api.location.type {SourceLocation}
+%locations
+%lex-param {MacroExpander& tokens}
+%parse-param {MacroExpander& tokens} {ParseContext& ctx}
 
 %define parse.error verbose
 %define parse.lac full
 
 %union {
-    char*   str;
-    void*   node;
-    void*   list;
-    void*   operand;
+    TokenText             text;
+    SymbolToken           symbol;
+    RegisterToken         reg;
+    NumberToken           number;
+    const InstructionDef* def;
+    Operand               operand;
 }
 
-%token <str> INSTRUCTION REGISTER NUMBER IMMEDIATE LABEL IDENTIFIER LABEL_IMMEDIATE
-%token <str> DIRECTIVE STRING
+%token <def> INSTRUCTION
+%token <reg> REGISTER
+%token <number> NUMBER IMMEDIATE LABEL_IMMEDIATE
+%token <text> DIRECTIVE STRING
+%token <symbol> LABEL IDENTIFIER IMMEDIATE_SYMBOL LABEL_IMMEDIATE_SYMBOL
 %token COMMA LBRACKET RBRACKET
 %token INVALID END 0
 
-%type <node> statement instruction directive label
-%type <list> program statements
-%type <operand> operand
-
-%destructor { free($$); } <str>
-%destructor { delete static_cast<Operand*>($$); } <operand>
+%type <operand> operand data_value
 
 %start program
 
@@ -100,44 +280,23 @@ static std::unique_ptr<Label> make_label(const std::string& name, int line, int
 
 program:
     statements
-    {
-        g_ast = new ProgramAST();
-        if ($1 != nullptr) {
-            auto* stmts = static_cast<std::vector<std::unique_ptr<Statement>>*>($1);
-            for (auto& stmt : *stmts) {
-                g_ast->push_back(std::move(stmt));
-            }
-            delete stmts;
-        }
-    }
     ;
 
 statements:
     %empty
-    {
-        $$ = new std::vector<std::unique_ptr<Statement>>();
-    }
     | statements statement
-    {
-        auto* stmts = static_cast<std::vector<std::unique_ptr<Statement>>*>($1);
-        if ($2 != nullptr) {
-            stmts->push_back(std::unique_ptr<Statement>(static_cast<Statement*>($2)));
-        }
-        $$ = stmts;
-    }
     ;
 
 statement:
-    instruction { $$ = $1; }
-    | directive { $$ = $1; }
-    | label     { $$ = $1; }
+    instruction
+    | directive
+    | label
     ;
 
 label:
     LABEL
     {
-        $$ = make_label(std::string($1), line_num, col_num).release();
-        free($1);
+        add_label(ctx, $1, @1.line, @1.column);
     }
     ;
 
@@ -147,31 +306,79 @@ directive:
     /* .word VALUE or .org VALUE or .space COUNT */
     DIRECTIVE NUMBER
     {
-        $$ = make_directive($1, "", $2, line_num, col_num).release();
-        free($1);
-        free($2);
+        reject_include(ctx, @1, $1);
+        reject_global(ctx, @1, $1);
+        add_directive(ctx, $1, "", view($2.text), NO_SYMBOL, NO_SYMBOL, $2.value, @1.line, @1.column);
     }
     /* .word LABEL_REF */
     | DIRECTIVE IDENTIFIER
     {
-        $$ = make_directive($1, "", $2, line_num, col_num).release();
-        free($1);
-        free($2);
+        reject_include(ctx, @1, $1);
+        add_directive(ctx, $1, "", view($2.text), NO_SYMBOL, $2.sym, NO_NUMBER, @1.line, @1.column);
     }
     /* .define NAME VALUE */
     | DIRECTIVE IDENTIFIER NUMBER
     {
-        $$ = make_directive($1, $2, $3, line_num, col_num).release();
-        free($1);
-        free($2);
-        free($3);
+        reject_include(ctx, @1, $1);
+        reject_global(ctx, @1, $1);
+        add_directive(ctx, $1, view($2.text), view($3.text), $2.sym, NO_SYMBOL, $3.value, @1.line, @1.column);
     }
-    /* .ascii "string" or .asciiz "string" */
+    /* .word VALUE, VALUE, ... or .fill COUNT, VALUE */
+    | DIRECTIVE data_list
+    {
+        add_value_list(ctx, $1, @1);
+    }
+    /* .ascii "string" or .asciiz "string" or .include "file" or .incbin "file" */
     | DIRECTIVE STRING
     {
-        $$ = make_directive($1, "", $2, line_num, col_num).release();
-        free($1);
-        free($2);
+        const std::string_view value = decode_string(ctx.ast, $2);
+        if (view($1) == ".incbin") {
+            // The file name goes into the label, the value holds its bytes
+            std::string_view data;
+            if (ctx.includes == nullptr) {
+                report_operands(ctx, @1, ".incbin is not available here");
+            } else {
+                data = ctx.includes->incbin(ctx, value, @1.line);
+            }
+            add_directive(ctx, $1, value, data, NO_SYMBOL, NO_SYMBOL, NO_NUMBER, @1.line, @1.column);
+        } else {
+            if (view($1) == ".fill") {
+                reject_include(ctx, @1, $1);
+            }
+            reject_global(ctx, @1, $1);
+            add_directive(ctx, $1, "", value, NO_SYMBOL, NO_SYMBOL, NO_NUMBER, @1.line, @1.column);
+        }
+        if (view($1) == ".include") {
+            if (ctx.includes == nullptr) {
+                ctx.report(DiagnosticKind::PARSE, "Include error at line " + std::to_string(@1.line) +
+                                                  ": .include is not available here", @1);
+            } else {
+                ctx.includes->include(ctx, value, @1.line);
+            }
+        }
+    }
+    ;
+
+data_list:
+    data_value COMMA data_value
+    {
+        push_value(ctx, $1);
+        push_value(ctx, $3);
+    }
+    | data_list COMMA data_value
+    {
+        push_value(ctx, $3);
+    }
+    ;
+
+data_value:
+    NUMBER
+    {
+        $$ = number_operand(OperandType::NUMBER, $1);
+    }
+    | IDENTIFIER
+    {
+        $$ = make_operand(OperandType::IDENT, $1.text, $1.sym);
     }
     ;
 
@@ -181,47 +388,28 @@ instruction:
     /* No operand: halt */
     INSTRUCTION
     {
-        Operand empty;
-        $$ = make_instruction($1, empty, empty, line_num, col_num).release();
-        free($1);
+        add_instruction(ctx, $1, no_operand(), no_operand(), @1.line, @1.column);
     }
     /* Single operand - branch target: b LABEL */
     | INSTRUCTION IDENTIFIER
     {
-        Operand op1($2, OperandType::IDENT);
-        Operand empty;
-        $$ = make_instruction($1, op1, empty, line_num, col_num).release();
-        free($1);
-        free($2);
+        add_instruction(ctx, $1, make_operand(OperandType::IDENT, $2.text, $2.sym),
+                        no_operand(), @1.line, @1.column);
     }
     /* Single operand - register: push r0, pop r1 */
     | INSTRUCTION REGISTER
     {
-        Operand op1($2, OperandType::REG);
-        Operand empty;
-        $$ = make_instruction($1, op1, empty, line_num, col_num).release();
-        free($1);
-        free($2);
+        add_instruction(ctx, $1, register_operand($2), no_operand(), @1.line, @1.column);
     }
     /* Two operands: mv r0, <operand> */
     | INSTRUCTION REGISTER COMMA operand
     {
-        Operand op1($2, OperandType::REG);
-        Operand* op2 = static_cast<Operand*>($4);
-        $$ = make_instruction($1, op1, *op2, line_num, col_num).release();
-        free($1);
-        free($2);
-        delete op2;
+        add_instruction(ctx, $1, register_operand($2), $4, @1.line, @1.column);
     }
     /* Memory access: ld r0, [r1] */
     | INSTRUCTION REGISTER COMMA LBRACKET REGISTER RBRACKET
     {
-        Operand op1($2, OperandType::REG);
-        Operand op2($5, OperandType::REG);
-        $$ = make_instruction($1, op1, op2, line_num, col_num).release();
-        free($1);
-        free($2);
-        free($5);
+        add_instruction(ctx, $1, register_operand($2), register_operand($5), @1.line, @1.column);
     }
     ;
 
@@ -230,35 +418,39 @@ instruction:
 operand:
     REGISTER
     {
-        $$ = new Operand($1, OperandType::REG);
-        free($1);
+        $$ = register_operand($1);
     }
     | IMMEDIATE
     {
-        // Store with # prefix for encoder
-        $$ = new Operand(std::string("#") + $1, OperandType::IMM);
-        free($1);
+        // Text keeps its # prefix for error messages
+        $$ = number_operand(OperandType::IMM, $1);
+    }
+    | IMMEDIATE_SYMBOL
+    {
+        $$ = make_operand(OperandType::IMM, $1.text, $1.sym);
     }
     | LABEL_IMMEDIATE
     {
-        // Store with = prefix for encoder
-        $$ = new Operand(std::string("=") + $1, OperandType::LABEL_IMM);
-        free($1);
+        // Text keeps its = prefix for error messages
+        $$ = number_operand(OperandType::LABEL_IMM, $1);
+    }
+    | LABEL_IMMEDIATE_SYMBOL
+    {
+        $$ = make_operand(OperandType::LABEL_IMM, $1.text, $1.sym);
     }
     | IDENTIFIER
     {
-        $$ = new Operand($1, OperandType::IDENT);
-        free($1);
+        $$ = make_operand(OperandType::IDENT, $1.text, $1.sym);
     }
     | NUMBER
     {
-        $$ = new Operand($1, OperandType::NUMBER);
-        free($1);
+        $$ = number_operand(OperandType::NUMBER, $1);
     }
     ;
 
 %%
 
-void yyerror(const char* msg) {
-    std::cerr << "Parse error at line " << line_num << ", column " << col_num << ": " << msg << std::endl;
-}
\ No newline at end of file
+// Located at the token that could not be parsed
+void yyerror(SourceLocation* lloc, MacroExpander&, ParseContext& ctx, const char* msg) {
+    report_operands(ctx, *lloc, msg);
+}